@@ -0,0 +1,318 @@
+#ifndef DISTRIBUTEDMONITOR_ADAPTIVEEXCLUSIONALGORITHM_H
+#define DISTRIBUTEDMONITOR_ADAPTIVEEXCLUSIONALGORITHM_H
+
+#include <chrono>
+#include <condition_variable>
+#include <optional>
+#include <communication/CommunicationManager.h>
+#include <logging/Logger.h>
+#include <util/MessagePacking.h>
+#include <util/Utils.h>
+#include "IDistributedExclusionAlgorithm.h"
+
+enum class ExclusionMode : unsigned char {
+    PERMISSION, TOKEN
+};
+
+struct AdaptiveExclusionPolicy {
+    /** Weight of the newest sample in the moving averages below **/
+    double smoothing = 0.25;
+    /** Switch to the token mode once this many processes on average want the mutex during one ownership... **/
+    double tokenModeQueueDepth = 1.5;
+    /** ...or once other processes request it at least this many times per second **/
+    double tokenModeRequestRate = 200.0;
+    /** Switch back to the permission mode once both averages drop to these values **/
+    double permissionModeQueueDepth = 0.5;
+    double permissionModeRequestRate = 50.0;
+    /** Number of own acquisitions in a mode required before this process may switch it again **/
+    std::size_t minimumAcquisitionsPerMode = 16;
+};
+
+struct AdaptiveMutexStatistics {
+    ExclusionMode mode;
+    std::size_t switchCount;
+    /** Average number of other processes which requested the mutex while this process was acquiring or holding it **/
+    double queueDepth;
+    /** Average number of requests from other processes per second **/
+    double requestRate;
+};
+
+/**
+ * Wraps a permission based algorithm (e.g. Ricart-Agrawala) and a token based one (e.g. Suzuki-Kasami) and switches
+ * each mutex between them depending on the contention measured by the process holding it.
+ *
+ * A process is in the critical section only when it holds the underlying mutex of the current mode. The owner switches
+ * the mode while still in the critical section: it acquires the mutex of the new mode as well, broadcasts MODE_SWITCH
+ * and waits until every process confirms it before releasing the mutex of the old mode. Therefore anyone who gets the
+ * old mutex afterwards already knows about the switch, releases it and retries in the new mode.
+ *
+ * Every registered mutex is registered in both wrapped algorithms under the same name.
+ */
+class AdaptiveExclusionAlgorithm : public IDistributedExclusionAlgorithm {
+public:
+
+    AdaptiveExclusionAlgorithm(std::shared_ptr<CommunicationManager> communicationManager,
+                               std::shared_ptr<IDistributedExclusionAlgorithm> permissionAlgorithm,
+                               std::shared_ptr<IDistributedExclusionAlgorithm> tokenAlgorithm,
+                               AdaptiveExclusionPolicy policy = {})
+            : communicationManager(std::move(communicationManager)),
+              permissionAlgorithm(std::move(permissionAlgorithm)), tokenAlgorithm(std::move(tokenAlgorithm)),
+              policy(policy) { }
+
+    void registerMutex(const MutexName& mutexName) override {
+        permissionAlgorithm->registerMutex(mutexName);
+        tokenAlgorithm->registerMutex(mutexName);
+        std::lock_guard<std::mutex> guard(mutexesMutex);
+        auto [mutexIterator, inserted] = mutexes.try_emplace(mutexName);
+        if (not inserted) {
+            return;
+        }
+        AdaptiveMutex& mutex = mutexIterator->second;
+        /** Contention measurement - requests of both wrapped algorithms **/
+        for (MessageType requestType : {MessageType::MUTEX_REQUEST, MessageType::TOKEN_REQUEST}) {
+            mutex.subscriptions.push_back(communicationManager->subscribe(
+                    requestType, mutexName, [this, &mutex](const Packet& request) {
+                        std::lock_guard<std::mutex> guard(mutexesMutex);
+                        mutex.requesters.insert(request.source);
+                        ++mutex.requests;
+                    }
+            ));
+        }
+        /** Mode switches handling **/
+        mutex.subscriptions.push_back(communicationManager->subscribe(
+                MessageType::MODE_SWITCH, mutexName, [this, &mutex, mutexName](const Packet& modeSwitch) {
+                    auto mode = static_cast<ExclusionMode>(readNumber(extractData(modeSwitch.message), 0));
+                    {
+                        std::lock_guard<std::mutex> guard(mutexesMutex);
+                        applyModeSwitch(mutex, mode);
+                    }
+                    Logger::log("Mutex '" + mutexName + "' switched to " + toString(mode) + " mode by process " +
+                                std::to_string(modeSwitch.source));
+                    communicationManager->send(MessageType::MODE_SWITCH_CONFIRM, packNamedMessage(mutexName, ""),
+                                               modeSwitch.source);
+                }
+        ));
+        /** Mode switch confirmations handling **/
+        mutex.subscriptions.push_back(communicationManager->subscribe(
+                MessageType::MODE_SWITCH_CONFIRM, mutexName, [this, &mutex](const Packet& confirmation) {
+                    {
+                        std::lock_guard<std::mutex> guard(mutexesMutex);
+                        ++mutex.switchConfirmations;
+                    }
+                    mutex.switchConfirmed.notify_one();
+                }
+        ));
+    }
+
+    void unregisterMutex(const MutexName& mutexName) override {
+        std::vector<SubscriptionId> subscriptions;
+        {
+            std::lock_guard<std::mutex> guard(mutexesMutex);
+            auto mutex = mutexes.find(mutexName);
+            if (mutex == mutexes.end()) {
+                return;
+            }
+            subscriptions = mutex->second.subscriptions;
+        }
+        for (SubscriptionId subscription : subscriptions) {
+            communicationManager->unsubscribe(subscription);
+        }
+        {
+            std::lock_guard<std::mutex> guard(mutexesMutex);
+            mutexes.erase(mutexName);
+        }
+        permissionAlgorithm->unregisterMutex(mutexName);
+        tokenAlgorithm->unregisterMutex(mutexName);
+    }
+
+    /** Accessed by Main Thread **/
+    void acquireMutex(const MutexName& mutexName) override {
+        {
+            std::lock_guard<std::mutex> guard(mutexesMutex);
+            mutexes.at(mutexName).requesters.clear();
+        }
+        while (true) {
+            ExclusionMode mode = getMode(mutexName);
+            getAlgorithm(mode)->acquireMutex(mutexName);
+            {
+                std::lock_guard<std::mutex> guard(mutexesMutex);
+                AdaptiveMutex& mutex = mutexes.at(mutexName);
+                if (mutex.mode == mode) {
+                    mutex.acquiredMode = mode;
+                    ++mutex.acquisitionsInMode;
+                    return;
+                }
+            }
+            /** The owner switched the mode while I was waiting - the mutex I got does not protect anything now **/
+            Logger::log("Mutex '" + mutexName + "' acquired in the outdated " + toString(mode) + " mode, retrying");
+            getAlgorithm(mode)->releaseMutex(mutexName);
+        }
+    }
+
+    /** Accessed by Main Thread - like acquireMutex, with the deadline passed to the algorithm of the current mode **/
+    bool tryAcquireMutex(const MutexName& mutexName, Deadline deadline) override {
+        {
+            std::lock_guard<std::mutex> guard(mutexesMutex);
+            mutexes.at(mutexName).requesters.clear();
+        }
+        while (true) {
+            ExclusionMode mode = getMode(mutexName);
+            if (not getAlgorithm(mode)->tryAcquireMutex(mutexName, deadline)) {
+                return false;
+            }
+            {
+                std::lock_guard<std::mutex> guard(mutexesMutex);
+                AdaptiveMutex& mutex = mutexes.at(mutexName);
+                if (mutex.mode == mode) {
+                    mutex.acquiredMode = mode;
+                    ++mutex.acquisitionsInMode;
+                    return true;
+                }
+            }
+            Logger::log("Mutex '" + mutexName + "' acquired in the outdated " + toString(mode) + " mode, retrying");
+            getAlgorithm(mode)->releaseMutex(mutexName);
+        }
+    }
+
+    /** Accessed by Main Thread **/
+    void releaseMutex(const MutexName& mutexName) override {
+        ExclusionMode acquiredMode;
+        std::optional<ExclusionMode> newMode;
+        {
+            std::lock_guard<std::mutex> guard(mutexesMutex);
+            AdaptiveMutex& mutex = mutexes.at(mutexName);
+            updateStatistics(mutex);
+            acquiredMode = mutex.acquiredMode;
+            newMode = chooseMode(mutex);
+        }
+        if (newMode) {
+            switchMode(mutexName, acquiredMode, *newMode);
+            acquiredMode = *newMode;
+        }
+        getAlgorithm(acquiredMode)->releaseMutex(mutexName);
+    }
+
+    ProcessId getProcessId() override {
+        return communicationManager->getProcessId();
+    }
+
+    ExclusionMode getMode(const MutexName& mutexName) {
+        std::lock_guard<std::mutex> guard(mutexesMutex);
+        return mutexes.at(mutexName).mode;
+    }
+
+    /** Number of mode switches of the mutex, performed by any process **/
+    std::size_t getSwitchCount(const MutexName& mutexName) {
+        std::lock_guard<std::mutex> guard(mutexesMutex);
+        return mutexes.at(mutexName).switchCount;
+    }
+
+    AdaptiveMutexStatistics getStatistics(const MutexName& mutexName) {
+        std::lock_guard<std::mutex> guard(mutexesMutex);
+        const AdaptiveMutex& mutex = mutexes.at(mutexName);
+        return AdaptiveMutexStatistics {
+                .mode = mutex.mode,
+                .switchCount = mutex.switchCount,
+                .queueDepth = mutex.queueDepth,
+                .requestRate = mutex.requestRate
+        };
+    }
+
+    static std::string toString(ExclusionMode mode) {
+        return mode == ExclusionMode::PERMISSION ? "permission" : "token";
+    }
+
+private:
+
+    struct AdaptiveMutex {
+        ExclusionMode mode = ExclusionMode::PERMISSION;
+        /** Mode of the underlying mutex this process holds **/
+        ExclusionMode acquiredMode = ExclusionMode::PERMISSION;
+        std::size_t switchCount = 0;
+        std::size_t acquisitionsInMode = 0;
+
+        /** Processes which requested the mutex since this process started acquiring it **/
+        ProcessSet requesters;
+        /** Requests received since the last release **/
+        std::size_t requests = 0;
+        std::chrono::steady_clock::time_point lastRelease = std::chrono::steady_clock::now();
+        double queueDepth = 0.0;
+        double requestRate = 0.0;
+
+        std::size_t switchConfirmations = 0;
+        std::condition_variable switchConfirmed;
+        std::vector<SubscriptionId> subscriptions;
+    };
+
+    /** Accessed by Main Thread **/
+    void switchMode(const MutexName& mutexName, ExclusionMode oldMode, ExclusionMode newMode) {
+        Logger::log("Switching mutex '" + mutexName + "' to " + toString(newMode) + " mode", rang::fg::magenta);
+        getAlgorithm(newMode)->acquireMutex(mutexName);
+        AdaptiveMutex* mutex;
+        {
+            std::lock_guard<std::mutex> guard(mutexesMutex);
+            mutex = &mutexes.at(mutexName);
+            applyModeSwitch(*mutex, newMode);
+            mutex->acquiredMode = newMode;
+            mutex->switchConfirmations = 0;
+        }
+        std::string data;
+        appendNumber(data, static_cast<std::uint64_t>(newMode));
+        communicationManager->sendOthers(MessageType::MODE_SWITCH, packNamedMessage(mutexName, data));
+        {
+            std::unique_lock<std::mutex> lock(mutexesMutex);
+            auto expectedConfirmations = static_cast<std::size_t>(communicationManager->getNumberOfProcesses()) - 1;
+            mutex->switchConfirmed.wait(lock, [&]() { return mutex->switchConfirmations == expectedConfirmations; });
+        }
+        getAlgorithm(oldMode)->releaseMutex(mutexName);
+    }
+
+    /** Accessed by Main and Receiving threads - protected by mutexesMutex **/
+    static void applyModeSwitch(AdaptiveMutex& mutex, ExclusionMode mode) {
+        mutex.mode = mode;
+        mutex.acquisitionsInMode = 0;
+        ++mutex.switchCount;
+    }
+
+    /** Accessed by Main Thread - protected by mutexesMutex **/
+    void updateStatistics(AdaptiveMutex& mutex) {
+        using namespace std::chrono;
+        auto now = steady_clock::now();
+        double elapsedSeconds = duration_cast<duration<double>>(now - mutex.lastRelease).count();
+        double requestRate = elapsedSeconds > 0 ? static_cast<double>(mutex.requests) / elapsedSeconds : 0.0;
+        mutex.queueDepth += policy.smoothing * (static_cast<double>(mutex.requesters.size()) - mutex.queueDepth);
+        mutex.requestRate += policy.smoothing * (requestRate - mutex.requestRate);
+        mutex.requests = 0;
+        mutex.lastRelease = now;
+    }
+
+    /** Accessed by Main Thread - protected by mutexesMutex **/
+    std::optional<ExclusionMode> chooseMode(const AdaptiveMutex& mutex) {
+        if (mutex.acquisitionsInMode < policy.minimumAcquisitionsPerMode) {
+            return std::nullopt;
+        }
+        if (mutex.mode == ExclusionMode::PERMISSION and (mutex.queueDepth >= policy.tokenModeQueueDepth or
+                                                         mutex.requestRate >= policy.tokenModeRequestRate)) {
+            return ExclusionMode::TOKEN;
+        }
+        if (mutex.mode == ExclusionMode::TOKEN and mutex.queueDepth <= policy.permissionModeQueueDepth and
+                                                   mutex.requestRate <= policy.permissionModeRequestRate) {
+            return ExclusionMode::PERMISSION;
+        }
+        return std::nullopt;
+    }
+
+    const std::shared_ptr<IDistributedExclusionAlgorithm>& getAlgorithm(ExclusionMode mode) const {
+        return mode == ExclusionMode::PERMISSION ? permissionAlgorithm : tokenAlgorithm;
+    }
+
+    std::map<MutexName, AdaptiveMutex> mutexes;
+    std::mutex mutexesMutex;
+
+    std::shared_ptr<CommunicationManager> communicationManager;
+    std::shared_ptr<IDistributedExclusionAlgorithm> permissionAlgorithm;
+    std::shared_ptr<IDistributedExclusionAlgorithm> tokenAlgorithm;
+    AdaptiveExclusionPolicy policy;
+};
+
+#endif //DISTRIBUTEDMONITOR_ADAPTIVEEXCLUSIONALGORITHM_H
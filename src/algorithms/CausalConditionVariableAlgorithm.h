@@ -0,0 +1,245 @@
+#ifndef DISTRIBUTEDMONITOR_CAUSALCONDITIONVARIABLEALGORITHM_H
+#define DISTRIBUTEDMONITOR_CAUSALCONDITIONVARIABLEALGORITHM_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include <communication/CommunicationManager.h>
+#include <logging/ConsoleColor.h>
+#include <logging/Logger.h>
+#include "IDistributedConditionVariableAlgorithm.h"
+
+/**
+ * DistributedConditionVariableAlgorithm without the confirmations of the end of a wait. They are needed only to make
+ * sure that no process acquires the mutex and notifies a process which stopped waiting before it learns about it. With
+ * causally ordered delivery (see CausalCommunicator), COND_WAIT_END sent before releasing the mutex is dispatched by
+ * every process before the mutex reaches it, so the waiting process leaves the wait right after broadcasting it.
+ *
+ * Requires a causally ordered communication manager and an exclusion algorithm passing the mutex with messages (not
+ * RmaMcsExclusionAlgorithm).
+ *
+ * A timed wait which runs out of time withdraws the wait with COND_WAIT_END as well. A notification which arrived
+ * after its last wake-up was sent before the waiting process acquired the mutex again, while the wait was still known
+ * to the notifier - it is passed on to the next waiting process of the wait's class, which would miss it otherwise.
+ *
+ * Waits and notifications are tracked per process, like in DistributedConditionVariableAlgorithm, so while a thread
+ * of a process waits on a CV no other thread of it may wait on or notify it (see checkNoLocalWait).
+ *
+ * A process notified with notifyOne is not chosen again until its COND_WAIT_END arrives, so that several notifications
+ * sent within one entry wake up different processes. A process woken up whose predicate does not hold yet waits again
+ * and announces it with another COND_WAIT, which makes it eligible for notifications again.
+ */
+class CausalConditionVariableAlgorithm : public IDistributedConditionVariableAlgorithm {
+public:
+
+    explicit CausalConditionVariableAlgorithm(std::shared_ptr<CommunicationManager> communicationManager)
+            : communicationManager(std::move(communicationManager)) {
+        if (not this->communicationManager->isCausallyOrdered()) {
+            throw std::runtime_error("CausalConditionVariableAlgorithm requires causally ordered delivery");
+        }
+        waitingProcesses = ProcessSet(static_cast<std::size_t>(this->communicationManager->getNumberOfProcesses()));
+        /** Conditional variables waits handling - a process waiting again can be notified again **/
+        subscribe(MessageType::COND_WAIT, [](const Packet& waitInfo, ConditionVariable& conditionVariable) {
+            conditionVariable.waits.insert(waitInfo);
+            conditionVariable.notifiedProcesses.erase(waitInfo.source);
+        });
+        /** Conditional variables waits ends handling - only the wait of the sender has ended **/
+        subscribe(MessageType::COND_WAIT_END, [](const Packet& waitEnd, ConditionVariable& conditionVariable) {
+            std::set<Packet>& waits = conditionVariable.waits;
+            for (auto wait = waits.begin(); wait != waits.end();) {
+                wait = wait->source == waitEnd.source ? waits.erase(wait) : std::next(wait);
+            }
+            conditionVariable.notifiedProcesses.erase(waitEnd.source);
+        });
+        /** Conditional variable notify handling **/
+        subscribe(MessageType::COND_NOTIFY, [](const Packet&, ConditionVariable& conditionVariable) {
+            conditionVariable.notificationReceived = true;
+            conditionVariable.notified.notify_one();
+        });
+    }
+
+    ~CausalConditionVariableAlgorithm() override {
+        for (SubscriptionId subscription : subscriptions) {
+            communicationManager->unsubscribe(subscription);
+        }
+    }
+
+    void registerCV(const CondName& condName) override {
+        communicationManager->internName(condName);
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        conditionVariables.try_emplace(condName);
+    }
+
+    void unregisterCV(const CondName& condName) override {
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        conditionVariables.erase(condName);
+    }
+
+    /** Accessed by Main Thread **/
+    void wait(const CondName& condName, DistributedMutex& mutex, const Predicate& predicate,
+              WaitClass waitClass) override {
+        if (predicate()) {
+            return;
+        }
+        ConditionVariable* conditionVariable = startWait(condName);
+
+        std::string waitInfo = packWaitClass(condName, waitClass);
+        communicationManager->sendOthers(MessageType::COND_WAIT, waitInfo);
+        Logger::log("Started waiting on CV '" + condName + "'", rang::fg::cyan);
+        conditionVariable->notified.wait(mutex);
+        while (not predicate()) {
+            /** The notification, if any, has been used up - others have to know that I still wait **/
+            communicationManager->sendOthers(MessageType::COND_WAIT, waitInfo);
+            conditionVariable->notified.wait(mutex);
+        }
+        Logger::log("Stopped waiting on CV '" + condName + "'", rang::fg::magenta);
+        communicationManager->sendOthers(MessageType::COND_WAIT_END, condName);
+        endWait(*conditionVariable);
+    }
+
+    /** Accessed by Main Thread **/
+    bool waitUntil(const CondName& condName, DistributedMutex& mutex, const Predicate& predicate,
+                   WaitClass waitClass, Deadline deadline) override {
+        if (predicate()) {
+            return true;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        ConditionVariable* conditionVariable = startWait(condName);
+
+        std::string waitInfo = packWaitClass(condName, waitClass);
+        communicationManager->sendOthers(MessageType::COND_WAIT, waitInfo);
+        Logger::log("Started waiting on CV '" + condName + "'", rang::fg::cyan);
+        std::cv_status status = conditionVariable->notified.wait_until(mutex, deadline);
+        bool satisfied = predicate();
+        while (not satisfied and status == std::cv_status::no_timeout) {
+            resetNotification(*conditionVariable);
+            communicationManager->sendOthers(MessageType::COND_WAIT, waitInfo);
+            status = conditionVariable->notified.wait_until(mutex, deadline);
+            satisfied = predicate();
+        }
+        Logger::log((satisfied ? "Stopped waiting on CV '" : "Timed out waiting on CV '") + condName + "'",
+                    rang::fg::magenta);
+        communicationManager->sendOthers(MessageType::COND_WAIT_END, condName);
+        bool notificationReceived = endWait(*conditionVariable);
+        if (not satisfied and notificationReceived) {
+            Logger::log("Passing on the notification received after timing out on CV '" + condName + "'");
+            notifyOne(condName, waitClass);
+        }
+        return satisfied;
+    }
+
+    /** Accessed by Main Thread - skips the processes notified already, which may not have stopped waiting yet **/
+    void notifyOne(const CondName& condName, WaitClass waitClass) override {
+        std::unique_lock<std::mutex> guard(conditionVariablesMutex);
+        ConditionVariable& conditionVariable = conditionVariables.at(condName);
+        checkNoLocalWait(condName, conditionVariable.waitingThread);
+        const std::set<Packet>& waits = conditionVariable.waits;
+        auto firstWait = std::find_if(waits.begin(), waits.end(), [&](const Packet& wait) {
+            return not conditionVariable.notifiedProcesses.contains(wait.source) and
+                   matches(unpackWaitClass(wait.message), waitClass);
+        });
+        if (firstWait == waits.end()) {
+            Logger::log("There is no one to notify");
+            return;
+        }
+        ProcessId firstWaitingProcess = firstWait->source;
+        conditionVariable.notifiedProcesses.insert(firstWaitingProcess);
+        guard.unlock();
+        communicationManager->send(MessageType::COND_NOTIFY, condName, firstWaitingProcess);
+    }
+
+    /** Accessed by Main Thread **/
+    void notifyAll(const CondName& condName) override {
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        ConditionVariable& conditionVariable = conditionVariables.at(condName);
+        checkNoLocalWait(condName, conditionVariable.waitingThread);
+        const std::set<Packet>& waits = conditionVariable.waits;
+        if (waits.empty()) {
+            Logger::log("There is no one to notify");
+            return;
+        }
+        waitingProcesses.clear();
+        for (const Packet& wait : waits) {
+            waitingProcesses.insert(wait.source);
+            conditionVariable.notifiedProcesses.insert(wait.source);
+        }
+        communicationManager->send(MessageType::COND_NOTIFY, condName, waitingProcesses);
+    }
+
+    ProcessId getProcessId() override {
+        return communicationManager->getProcessId();
+    }
+
+private:
+
+    struct ConditionVariable {
+        /** Waits of other processes **/
+        std::set<Packet> waits;
+        /** Woken up by notifications addressed to this process **/
+        std::condition_variable_any notified;
+        /** Processes notified by this one whose COND_WAIT_END (or next COND_WAIT) has not arrived yet **/
+        ProcessSet notifiedProcesses;
+        /** The thread of this process waiting on the CV, if any (see checkNoLocalWait) **/
+        std::thread::id waitingThread;
+        /** Set when a notification arrives after the last COND_WAIT of the current wait **/
+        bool notificationReceived = false;
+    };
+
+    /** Accessed by Main Thread **/
+    ConditionVariable* startWait(const CondName& condName) {
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        ConditionVariable* conditionVariable = &conditionVariables.at(condName);
+        checkNoLocalWait(condName, conditionVariable->waitingThread);
+        conditionVariable->waitingThread = std::this_thread::get_id();
+        conditionVariable->notificationReceived = false;
+        return conditionVariable;
+    }
+
+    /** Accessed by Main Thread **/
+    void resetNotification(ConditionVariable& conditionVariable) {
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        conditionVariable.notificationReceived = false;
+    }
+
+    /** Accessed by Main Thread - returns whether a notification arrived after the last COND_WAIT **/
+    bool endWait(ConditionVariable& conditionVariable) {
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        conditionVariable.waitingThread = std::thread::id();
+        return conditionVariable.notificationReceived;
+    }
+
+    /**
+     * Subscribes to all packets of the given type. The handler is called with the CV the packet concerns, under
+     * conditionVariablesMutex.
+     */
+    template <typename Handler>
+    void subscribe(MessageType messageType, Handler handler) {
+        subscriptions.push_back(communicationManager->subscribe(messageType, [this, handler](const Packet& packet) {
+            std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+            lookupName.assign(extractObjectName(packet.messageType, packet.message));
+            auto conditionVariable = conditionVariables.find(lookupName);
+            if (conditionVariable == conditionVariables.end()) {
+                return false;
+            }
+            handler(packet, conditionVariable->second);
+            return true;
+        }));
+    }
+
+    std::unordered_map<CondName, ConditionVariable> conditionVariables;
+    std::mutex conditionVariablesMutex;
+    /** Reused by every lookup of a received CV name, so that it does not allocate **/
+    CondName lookupName;
+    /** Reused by every notifyAll to collect the processes to notify **/
+    ProcessSet waitingProcesses;
+    std::vector<SubscriptionId> subscriptions;
+
+    std::shared_ptr<CommunicationManager> communicationManager;
+};
+
+#endif //DISTRIBUTEDMONITOR_CAUSALCONDITIONVARIABLEALGORITHM_H
@@ -0,0 +1,499 @@
+#ifndef DISTRIBUTEDMONITOR_CENTRALIZEDCONDITIONVARIABLEALGORITHM_H
+#define DISTRIBUTEDMONITOR_CENTRALIZEDCONDITIONVARIABLEALGORITHM_H
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include <communication/CommunicationManager.h>
+#include <logging/ConsoleColor.h>
+#include <logging/Logger.h>
+#include "IDistributedConditionVariableAlgorithm.h"
+
+/**
+ * Every CV has a home process (chosen by hashing its name) which keeps the queue of processes waiting on it. A waiting
+ * process registers its wait at the home (COND_WAIT), notifications are sent to the home (COND_NOTIFY_ONE,
+ * COND_NOTIFY_ALL), which forwards them to the chosen waiters (COND_WAKE). A wait takes at most three messages, no
+ * matter how many processes there are, and no confirmations are needed.
+ *
+ * A wait and a notification concerning it come from different processes, so the notification may reach the home first.
+ * Both happen under the same mutex, so the Lamport time of every wait is lower than the time of every notification
+ * following it - a notification which finds no earlier wait is kept and wakes up a wait with a lower time arriving
+ * later. It relies on the exclusion algorithm passing the mutex between processes with messages, so it cannot be used
+ * with RmaMcsExclusionAlgorithm, and on a CV being always used with the same mutex. The home stamps its own waits and
+ * notifications with its current time without advancing it, since the mutex may stay with the process in between (e.g.
+ * handed over between its threads) - a notification of the home also wakes up the waits with the same time queued
+ * before it. All processes have to register every CV, as any of them may be its home.
+ *
+ * Any threads of a process may wait on and notify a CV. A wait is told by its process and its Lamport time, so
+ * COND_WAKE names the wait it wakes up - or, for notify_all, the latest time of the waits it wakes up - and the process
+ * wakes up the matching waits of its threads. A process may have several waits on the way to the home then, so it
+ * reports the number of its waits with each of them, and the home keeps as many notifications which found no wait.
+ *
+ * A timed wait which runs out of time is withdrawn at the home with COND_WAIT_CANCEL, which the home confirms with
+ * COND_WAKE if the wait was still queued. Otherwise the COND_WAKE waking it up is on the way already - the notification
+ * it brings is passed on to the home with COND_NOTIFY_ONE of the wait's class, so that another waiter gets it.
+ */
+class CentralizedConditionVariableAlgorithm : public IDistributedConditionVariableAlgorithm {
+public:
+
+    explicit CentralizedConditionVariableAlgorithm(std::shared_ptr<CommunicationManager> communicationManager)
+            : communicationManager(std::move(communicationManager)) {
+        wokenProcesses = ProcessSet(static_cast<std::size_t>(this->communicationManager->getNumberOfProcesses()));
+        /** Waits registered at the home **/
+        subscribe(MessageType::COND_WAIT, [this](const Packet& wait, const CondName& condName,
+                                                 ConditionVariable& conditionVariable) {
+            std::string_view data = extractData(wait.message);
+            std::size_t offset = 0;
+            auto waitClass = static_cast<WaitClass>(readVarint(data, offset));
+            reportWaits(conditionVariable, wait.source, readVarint(data, offset));
+            addWaiter(condName, conditionVariable, {wait.lamportTime, wait.source, waitClass, nullptr});
+        });
+        /** Timed out waits withdrawn at the home **/
+        subscribe(MessageType::COND_WAIT_CANCEL, [this](const Packet& cancel, const CondName& condName,
+                                                        ConditionVariable& conditionVariable) {
+            std::string_view data = extractData(cancel.message);
+            std::size_t offset = 0;
+            LamportTime waitTime = readVarint(data, offset);
+            std::deque<Waiter>& waiters = conditionVariable.waiters;
+            auto waiter = std::find_if(waiters.begin(), waiters.end(), [&](const Waiter& queued) {
+                return queued.processId == cancel.source and queued.waitTime == waitTime;
+            });
+            /** The wait has been woken up already - its COND_WAKE is on the way **/
+            if (waiter == waiters.end()) {
+                return;
+            }
+            waiters.erase(waiter);
+            std::string confirmation = packWakeUp(condName, WakeUp::WITHDRAWN, waitTime);
+            this->communicationManager->send(MessageType::COND_WAKE, confirmation, cancel.source);
+        });
+        /** Notifications sent to the home **/
+        subscribe(MessageType::COND_NOTIFY_ONE, [this](const Packet& notification, const CondName& condName,
+                                                       ConditionVariable& conditionVariable) {
+            Notification pendingNotification {notification.lamportTime, unpackWaitClass(notification.message), false};
+            wakeOne(condName, conditionVariable, pendingNotification);
+        });
+        subscribe(MessageType::COND_NOTIFY_ALL, [this](const Packet& notification, const CondName& condName,
+                                                       ConditionVariable& conditionVariable) {
+            wakeAll(condName, conditionVariable, {notification.lamportTime, ANY_WAIT_CLASS, false});
+        });
+        /** Notifications forwarded by the home **/
+        subscribe(MessageType::COND_WAKE, [this](const Packet& notification, const CondName& condName,
+                                                 ConditionVariable& conditionVariable) {
+            std::string_view data = extractData(notification.message);
+            std::size_t offset = 0;
+            auto wakeUp = static_cast<WakeUp>(readVarint(data, offset));
+            LamportTime time = readVarint(data, offset);
+            auto woken = [&](const LocalWait& wait) {
+                return wakeUp == WakeUp::WAITS_UNTIL ? wait.waitTime <= time : wait.waitTime == time;
+            };
+            std::vector<LocalWait>& localWaits = conditionVariable.localWaits;
+            bool wokenAny = false;
+            for (const LocalWait& wait : localWaits) {
+                if (not woken(wait)) {
+                    continue;
+                }
+                if (wait.notified != nullptr) {
+                    *wait.notified = true;
+                    wokenAny = true;
+                } else if (wakeUp == WakeUp::WAIT) {
+                    Logger::log("Passing on the notification of a withdrawn wait on CV '" + condName + "'");
+                    std::string passedOn = packWaitClass(condName, wait.waitClass);
+                    this->communicationManager->send(MessageType::COND_NOTIFY_ONE, passedOn, notification.source);
+                }
+            }
+            /** A wait woken up by notify_all may be woken up again once its COND_WAIT reaches the home **/
+            localWaits.erase(std::remove_if(localWaits.begin(), localWaits.end(), woken), localWaits.end());
+            if (wokenAny) {
+                getNotifiedCondition(condName).notify_all();
+            }
+        });
+    }
+
+    ~CentralizedConditionVariableAlgorithm() override {
+        for (SubscriptionId subscription : subscriptions) {
+            communicationManager->unsubscribe(subscription);
+        }
+    }
+
+    void registerCV(const CondName& condName) override {
+        communicationManager->internName(condName);
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        conditionVariables.try_emplace(condName);
+    }
+
+    void unregisterCV(const CondName& condName) override {
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        conditionVariables.erase(condName);
+    }
+
+    /** Accessed by Main Thread **/
+    void wait(const CondName& condName, DistributedMutex& mutex, const Predicate& predicate,
+              WaitClass waitClass) override {
+        while (not predicate()) {
+            /** Set when this wait is notified - by the home itself or by COND_WAKE **/
+            bool notified = false;
+            startWait(condName, waitClass, &notified);
+            Logger::log("Started waiting on CV '" + condName + "'", rang::fg::cyan);
+            mutex.unlock();
+            {
+                std::unique_lock<std::mutex> lock(conditionVariablesMutex);
+                getNotifiedCondition(condName).wait(lock, [&]() { return notified; });
+            }
+            Logger::log("Stopped waiting on CV '" + condName + "'", rang::fg::magenta);
+            mutex.lock();
+        }
+    }
+
+    /**
+     * Accessed by Main Thread - a wait which runs out of time before it is notified is withdrawn (see
+     * withdrawWait), a notification arriving later is passed on by the receiving thread.
+     */
+    bool waitUntil(const CondName& condName, DistributedMutex& mutex, const Predicate& predicate,
+                   WaitClass waitClass, Deadline deadline) override {
+        while (not predicate()) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            bool notified = false;
+            startWait(condName, waitClass, &notified);
+            Logger::log("Started waiting on CV '" + condName + "'", rang::fg::cyan);
+            mutex.unlock();
+            {
+                std::unique_lock<std::mutex> lock(conditionVariablesMutex);
+                if (not getNotifiedCondition(condName).wait_until(lock, deadline, [&]() { return notified; })) {
+                    withdrawWait(condName, conditionVariables.at(condName), &notified);
+                }
+            }
+            Logger::log((notified ? "Stopped waiting on CV '" : "Timed out waiting on CV '") + condName + "'",
+                        rang::fg::magenta);
+            mutex.lock();
+        }
+        return true;
+    }
+
+    /** Accessed by Main Thread **/
+    void notifyOne(const CondName& condName, WaitClass waitClass) override {
+        ProcessId home = getHome(condName);
+        if (home != getProcessId()) {
+            communicationManager->send(MessageType::COND_NOTIFY_ONE, packWaitClass(condName, waitClass), home);
+            return;
+        }
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        Notification notification {communicationManager->getCurrentLamportTime(), waitClass, true};
+        wakeOne(condName, conditionVariables.at(condName), notification);
+    }
+
+    /** Accessed by Main Thread **/
+    void notifyAll(const CondName& condName) override {
+        ProcessId home = getHome(condName);
+        if (home != getProcessId()) {
+            communicationManager->send(MessageType::COND_NOTIFY_ALL, condName, home);
+            return;
+        }
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        Notification notification {communicationManager->getCurrentLamportTime(), ANY_WAIT_CLASS, true};
+        wakeAll(condName, conditionVariables.at(condName), notification);
+    }
+
+    ProcessId getProcessId() override {
+        return communicationManager->getProcessId();
+    }
+
+private:
+
+    struct Waiter {
+        LamportTime waitTime;
+        ProcessId processId;
+        WaitClass waitClass;
+        /** Set when a wait of the home itself is notified **/
+        bool* notified;
+    };
+
+    struct Notification {
+        LamportTime notificationTime;
+        WaitClass waitClass;
+        /** Made by the home itself **/
+        bool local;
+    };
+
+    /** A wait of a thread of this process, registered at another process **/
+    struct LocalWait {
+        /** The time of its COND_WAIT **/
+        LamportTime waitTime;
+        WaitClass waitClass;
+        /** Null once the wait has been withdrawn, until the home confirms it or wakes the wait up **/
+        bool* notified;
+    };
+
+    /** What COND_WAKE wakes up, followed by a time **/
+    enum class WakeUp : std::uint8_t {
+        /** The wait with the given time **/
+        WAIT = 0,
+        /** All waits with the given time or an earlier one **/
+        WAITS_UNTIL = 1,
+        /** None - the withdrawn wait with the given time has been removed from the queue **/
+        WITHDRAWN = 2
+    };
+
+    /** State of a registered CV. Queues are used only by its home. **/
+    struct ConditionVariable {
+        /** Processes waiting on the CV, in the order their waits arrived **/
+        std::deque<Waiter> waiters;
+        /** notify_one calls which found no earlier wait, the latest ones of each class, in the order of their times **/
+        std::vector<Notification> pendingNotifications;
+        /** The latest notify_all - waits arriving later which precede it are woken up right away **/
+        Notification notifiedAll {0, ANY_WAIT_CLASS, false};
+        /**
+         * The most waits every process has reported having at once (at least one, none for the home) and their sum,
+         * filled in by the first wait arriving at the home
+         */
+        std::vector<std::uint64_t> reportedWaits;
+        std::uint64_t reportedWaitsTotal = 0;
+        /** Waits of the threads of this process, unless it is the home **/
+        std::vector<LocalWait> localWaits;
+    };
+
+    /**
+     * Subscribes to all packets of the given type. The handler is called with the CV the packet concerns, under
+     * conditionVariablesMutex.
+     */
+    template <typename Handler>
+    void subscribe(MessageType messageType, Handler handler) {
+        subscriptions.push_back(communicationManager->subscribe(messageType, [this, handler](const Packet& packet) {
+            std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+            lookupName.assign(extractObjectName(packet.messageType, packet.message));
+            auto conditionVariable = conditionVariables.find(lookupName);
+            if (conditionVariable == conditionVariables.end()) {
+                return false;
+            }
+            handler(packet, conditionVariable->first, conditionVariable->second);
+            return true;
+        }));
+    }
+
+    /** Accessed by Main Thread - registers the wait at the home, 'notified' is set once it is notified **/
+    void startWait(const CondName& condName, WaitClass waitClass, bool* notified) {
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        ConditionVariable& conditionVariable = conditionVariables.at(condName);
+        ProcessId home = getHome(condName);
+        if (home == getProcessId()) {
+            Waiter waiter {communicationManager->getCurrentLamportTime(), getProcessId(), waitClass, notified};
+            addWaiter(condName, conditionVariable, waiter);
+        } else {
+            std::string waitInfo = packWait(condName, waitClass, conditionVariable.localWaits.size() + 1);
+            Packet wait = communicationManager->send(MessageType::COND_WAIT, waitInfo, home);
+            conditionVariable.localWaits.push_back({wait.lamportTime, waitClass, notified});
+        }
+    }
+
+    /**
+     * Accessed by Main Thread - protected by conditionVariablesMutex. The home removes its own wait from the queue
+     * right away, another process keeps the wait until the home answers its COND_WAIT_CANCEL.
+     */
+    void withdrawWait(const CondName& condName, ConditionVariable& conditionVariable, const bool* notified) {
+        ProcessId home = getHome(condName);
+        if (home == getProcessId()) {
+            std::deque<Waiter>& waiters = conditionVariable.waiters;
+            waiters.erase(std::find_if(waiters.begin(), waiters.end(), [&](const Waiter& waiter) {
+                return waiter.notified == notified;
+            }));
+            return;
+        }
+        std::vector<LocalWait>& localWaits = conditionVariable.localWaits;
+        auto wait = std::find_if(localWaits.begin(), localWaits.end(), [&](const LocalWait& localWait) {
+            return localWait.notified == notified;
+        });
+        wait->notified = nullptr;
+        std::string data;
+        appendVarint(data, wait->waitTime);
+        communicationManager->send(MessageType::COND_WAIT_CANCEL, packNamedMessage(condName, data), home);
+    }
+
+    /** Accessed by the home - protected by conditionVariablesMutex **/
+    void addWaiter(const CondName& condName, ConditionVariable& conditionVariable, Waiter waiter) {
+        if (precedes(waiter, conditionVariable.notifiedAll)) {
+            wake(condName, waiter, WakeUp::WAITS_UNTIL);
+            return;
+        }
+        std::vector<Notification>& pendingNotifications = conditionVariable.pendingNotifications;
+        auto pendingNotification = std::find_if(pendingNotifications.begin(), pendingNotifications.end(),
+                                                [&](const Notification& notification) {
+                                                    return precedes(waiter, notification) and
+                                                           matches(waiter.waitClass, notification.waitClass);
+                                                });
+        if (pendingNotification != pendingNotifications.end()) {
+            pendingNotifications.erase(pendingNotification);
+            wake(condName, waiter, WakeUp::WAIT);
+            return;
+        }
+        conditionVariable.waiters.push_back(waiter);
+    }
+
+    /** Accessed by the home - protected by conditionVariablesMutex **/
+    void wakeOne(const CondName& condName, ConditionVariable& conditionVariable, Notification notification) {
+        std::deque<Waiter>& waiters = conditionVariable.waiters;
+        auto earliestWaiter = waiters.end();
+        for (auto waiter = waiters.begin(); waiter != waiters.end(); ++waiter) {
+            if (wakes(notification, waiter->waitTime) and matches(waiter->waitClass, notification.waitClass)
+                and (earliestWaiter == waiters.end() or waiter->waitTime < earliestWaiter->waitTime)) {
+                earliestWaiter = waiter;
+            }
+        }
+        if (earliestWaiter != waiters.end()) {
+            Waiter waiter = *earliestWaiter;
+            waiters.erase(earliestWaiter);
+            wake(condName, waiter, WakeUp::WAIT);
+            return;
+        }
+        /**
+         * The wait it concerns may still be on its way. Any wait a notification could wake up can be woken up by a
+         * later one of the same class as well, so only the latest ones of each class are kept - as many as the waits
+         * other processes have reported having at once, each of which may be on the way (see reportWaits).
+         */
+        std::vector<Notification>& pendingNotifications = conditionVariable.pendingNotifications;
+        auto position = std::upper_bound(pendingNotifications.begin(), pendingNotifications.end(), notification,
+                                         [](const Notification& a, const Notification& b) {
+                                             return a.notificationTime < b.notificationTime;
+                                         });
+        pendingNotifications.insert(position, notification);
+        auto sameClass = [&](const Notification& pending) { return pending.waitClass == notification.waitClass; };
+        auto sameClassCount = std::count_if(pendingNotifications.begin(), pendingNotifications.end(), sameClass);
+        if (static_cast<std::uint64_t>(sameClassCount) > getWaitsOnTheWayLimit(conditionVariable)) {
+            auto oldest = std::find_if(pendingNotifications.begin(), pendingNotifications.end(), sameClass);
+            pendingNotifications.erase(oldest);
+        }
+    }
+
+    /** Accessed by the home - protected by conditionVariablesMutex **/
+    void wakeAll(const CondName& condName, ConditionVariable& conditionVariable, Notification notification) {
+        Notification& notifiedAll = conditionVariable.notifiedAll;
+        if (notification.notificationTime > notifiedAll.notificationTime) {
+            notifiedAll = notification;
+        } else if (notification.notificationTime == notifiedAll.notificationTime) {
+            notifiedAll.local = notifiedAll.local or notification.local;
+        }
+        std::deque<Waiter>& waiters = conditionVariable.waiters;
+        wokenProcesses.clear();
+        bool wakeMyself = false;
+        for (const Waiter& waiter : waiters) {
+            if (not wakes(notification, waiter.waitTime)) {
+                continue;
+            }
+            if (waiter.processId == getProcessId()) {
+                *waiter.notified = true;
+                wakeMyself = true;
+            } else {
+                wokenProcesses.insert(waiter.processId);
+            }
+        }
+        waiters.erase(std::remove_if(waiters.begin(), waiters.end(), [&](const Waiter& waiter) {
+            return wakes(notification, waiter.waitTime);
+        }), waiters.end());
+        if (not wokenProcesses.empty()) {
+            LamportTime latestWaitTime = notification.local ? notification.notificationTime
+                                                            : notification.notificationTime - 1;
+            communicationManager->send(MessageType::COND_WAKE,
+                                       packWakeUp(condName, WakeUp::WAITS_UNTIL, latestWaitTime), wokenProcesses);
+        }
+        if (wakeMyself) {
+            getNotifiedCondition(condName).notify_all();
+        }
+    }
+
+    /** Whether the notification wakes up a wait queued before it arrived **/
+    static bool wakes(const Notification& notification, LamportTime waitTime) {
+        return waitTime < notification.notificationTime or
+               (notification.local and waitTime == notification.notificationTime);
+    }
+
+    /**
+     * Whether a wait arriving after the notification was made before it. A wait made after a notification of the home
+     * gets a later time, since the mutex reaches another process from the home with a message, so with the same time
+     * only a wait of another process does.
+     */
+    bool precedes(const Waiter& waiter, const Notification& notification) {
+        return waiter.waitTime < notification.notificationTime or
+               (notification.local and waiter.processId != getProcessId() and
+                waiter.waitTime == notification.notificationTime);
+    }
+
+    /**
+     * Accessed by the home - protected by conditionVariablesMutex. A waiter woken up by notify_all is woken up with the
+     * waits of its process preceding it, which may have been woken up already.
+     */
+    void wake(const CondName& condName, const Waiter& waiter, WakeUp wakeUp) {
+        if (waiter.processId == getProcessId()) {
+            *waiter.notified = true;
+            getNotifiedCondition(condName).notify_all();
+        } else {
+            communicationManager->send(MessageType::COND_WAKE, packWakeUp(condName, wakeUp, waiter.waitTime),
+                                       waiter.processId);
+        }
+    }
+
+    /**
+     * Accessed by the home - protected by conditionVariablesMutex. Every COND_WAIT carries the number of waits its
+     * process has on the CV, including itself - all of them may be on the way at once.
+     */
+    void reportWaits(ConditionVariable& conditionVariable, ProcessId process, std::uint64_t waits) {
+        std::vector<std::uint64_t>& reportedWaits = conditionVariable.reportedWaits;
+        if (reportedWaits.empty()) {
+            reportedWaits.assign(static_cast<std::size_t>(communicationManager->getNumberOfProcesses()), 1);
+            reportedWaits[static_cast<std::size_t>(getProcessId())] = 0;
+            conditionVariable.reportedWaitsTotal = reportedWaits.size() - 1;
+        }
+        std::uint64_t& reported = reportedWaits[static_cast<std::size_t>(process)];
+        if (waits > reported) {
+            conditionVariable.reportedWaitsTotal += waits - reported;
+            reported = waits;
+        }
+    }
+
+    /** Other processes have a wait on the way each until they report more **/
+    std::uint64_t getWaitsOnTheWayLimit(const ConditionVariable& conditionVariable) {
+        return conditionVariable.reportedWaits.empty()
+               ? static_cast<std::uint64_t>(communicationManager->getNumberOfProcesses()) - 1
+               : conditionVariable.reportedWaitsTotal;
+    }
+
+    /** COND_WAIT carries the wait class and the number of waits of the sender on the CV, including this one **/
+    static std::string packWait(const CondName& condName, WaitClass waitClass, std::uint64_t waits) {
+        std::string data;
+        appendVarint(data, waitClass);
+        appendVarint(data, waits);
+        return packNamedMessage(condName, data);
+    }
+
+    static std::string packWakeUp(const CondName& condName, WakeUp wakeUp, LamportTime time) {
+        std::string data;
+        appendVarint(data, static_cast<std::uint64_t>(wakeUp));
+        appendVarint(data, time);
+        return packNamedMessage(condName, data);
+    }
+
+    ProcessId getHome(const CondName& condName) {
+        return static_cast<ProcessId>(std::hash<CondName>()(condName) %
+                                      static_cast<std::size_t>(communicationManager->getNumberOfProcesses()));
+    }
+
+    /** Waiting threads share a few condition variables instead of having one per CV **/
+    std::condition_variable& getNotifiedCondition(const CondName& condName) {
+        return notifiedConditions[std::hash<CondName>()(condName) % notifiedConditions.size()];
+    }
+
+    std::unordered_map<CondName, ConditionVariable> conditionVariables;
+    std::mutex conditionVariablesMutex;
+    /** Reused by every lookup of a received CV name, so that it does not allocate **/
+    CondName lookupName;
+    /** Reused by every notify_all to collect the processes to wake up **/
+    ProcessSet wokenProcesses;
+    std::array<std::condition_variable, 16> notifiedConditions;
+    std::vector<SubscriptionId> subscriptions;
+
+    std::shared_ptr<CommunicationManager> communicationManager;
+};
+
+#endif //DISTRIBUTEDMONITOR_CENTRALIZEDCONDITIONVARIABLEALGORITHM_H
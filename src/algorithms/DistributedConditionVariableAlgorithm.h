@@ -1,131 +1,167 @@
 #ifndef DISTRIBUTEDMONITOR_DISTRIBUTEDCONDITIONVARIABLEALGORITHM_H
 #define DISTRIBUTEDMONITOR_DISTRIBUTEDCONDITIONVARIABLEALGORITHM_H
 
+#include <algorithm>
+#include <array>
 #include <condition_variable>
 #include <communication/CommunicationManager.h>
 #include <util/Utils.h>
 #include <set>
+#include <unordered_map>
+#include <vector>
 #include <logging/ConsoleColor.h>
 #include <logging/Logger.h>
 #include "IDistributedConditionVariableAlgorithm.h"
 
+/**
+ * CVs are kept in a table of the algorithm, which subscribes to each message type once for all of them, so registering
+ * a CV takes constant time.
+ *
+ * If the communication manager has direct receive enabled, confirmations of the end of a wait are received by the
+ * waiting thread itself instead of being passed from the receiving thread.
+ *
+ * Waits and notifications are tracked per process, so a notification never reaches a wait of its own process. While
+ * a thread of a process waits on a CV no other thread of it may wait on or notify it (see checkNoLocalWait) - a
+ * producer and a consumer thread sharing a process would never wake each other up.
+ *
+ * A timed wait which runs out of time ends like any other wait - COND_WAIT_END withdraws only the wait of its sender,
+ * and once all processes confirm it no notification can be addressed to the process anymore. A notification sent
+ * before a process learnt about the withdrawal may still arrive until then - it is passed on to the next waiting
+ * process of the wait's class once the confirmations are in.
+ */
 class DistributedConditionVariableAlgorithm : public IDistributedConditionVariableAlgorithm {
 public:
 
     explicit DistributedConditionVariableAlgorithm(std::shared_ptr<CommunicationManager> communicationManager)
             : communicationManager(std::move(communicationManager)) {
+        directReceive = this->communicationManager->isDirectReceiveEnabled();
+        waitingProcesses = ProcessSet(static_cast<std::size_t>(this->communicationManager->getNumberOfProcesses()));
         /** Conditional variables waits handling **/
-        this->communicationManager->subscribe(
-            [&](const Packet& packet) {
-                const CondName& condName = packet.message;
-                std::lock_guard<std::mutex> guard(registerCVsMutex);
-                return packet.messageType == MessageType::COND_WAIT and contains(registeredCVs, condName);
-            },
-            [&](const Packet& waitInfo) {
-                const CondName& condName = waitInfo.message;
-                std::lock_guard<std::mutex> guard(conditionalWaitsMutex);
-                conditionalWaits[condName].insert(waitInfo);
+        subscribe(MessageType::COND_WAIT, [](const Packet& waitInfo, const CondName&,
+                                             ConditionVariable& conditionVariable) {
+            conditionVariable.waits.insert(waitInfo);
+        });
+        /** Conditional variables waits ends handling - only the wait of the sender has ended **/
+        subscribe(MessageType::COND_WAIT_END, [this](const Packet& waitEnd, const CondName& condName,
+                                                     ConditionVariable& conditionVariable) {
+            std::set<Packet>& waits = conditionVariable.waits;
+            for (auto wait = waits.begin(); wait != waits.end();) {
+                wait = wait->source == waitEnd.source ? waits.erase(wait) : std::next(wait);
+            }
+            if (directReceive) {
+                this->communicationManager->sendDirectly(MessageType::COND_WAIT_END_CONFIRM, condName, waitEnd.source);
+            } else {
+                this->communicationManager->send(MessageType::COND_WAIT_END_CONFIRM, condName, waitEnd.source);
             }
-        );
-        /** Conditional variables waits ends handling **/
-        this->communicationManager->subscribe(
-            [&](const Packet& packet) {
-                const CondName& condName = packet.message;
-                std::lock_guard<std::mutex> guard(registerCVsMutex);
-                return packet.messageType == MessageType::COND_WAIT_END and contains(registeredCVs, condName);
-            },
-            [&](const Packet& waitEndInfo) {
-                const CondName& condName = waitEndInfo.message;
-                {
-                    std::lock_guard<std::mutex> guard(conditionalWaitsMutex);
-                    conditionalWaits.erase(condName);
-                }
-                this->communicationManager->send(MessageType::COND_WAIT_END_CONFIRM, condName, waitEndInfo.source);
+        });
+        /** Conditional variable notify handling **/
+        subscribe(MessageType::COND_NOTIFY, [](const Packet&, const CondName&, ConditionVariable& conditionVariable) {
+            conditionVariable.notificationReceived = true;
+            conditionVariable.notified.notify_one();
+        });
+        /** Conditional variables waits ends confirmations handling **/
+        subscribe(MessageType::COND_WAIT_END_CONFIRM, [this](const Packet& confirmation, const CondName& condName,
+                                                             ConditionVariable& conditionVariable) {
+            conditionVariable.confirmations.insert(confirmation.source);
+            if (conditionVariable.confirmations.size() < otherProcessesCount()) {
+                return;
             }
-        );
+            conditionVariable.confirmedGeneration = conditionVariable.waitGeneration;
+            getConfirmationsCondition(condName).notify_all();
+        });
+    }
+
+    ~DistributedConditionVariableAlgorithm() override {
+        for (SubscriptionId subscription : subscriptions) {
+            communicationManager->unsubscribe(subscription);
+        }
     }
 
     void registerCV(const CondName& condName) override {
-        std::lock_guard<std::mutex> guard(registerCVsMutex);
-        registeredCVs.insert(condName);
+        communicationManager->internName(condName);
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        conditionVariables.try_emplace(condName);
     }
 
     void unregisterCV(const CondName& condName) override {
-        std::lock_guard<std::mutex> guard(registerCVsMutex);
-        registeredCVs.erase(condName);
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        conditionVariables.erase(condName);
     }
 
-    void wait(const CondName& condName, DistributedMutex& mutex, const Predicate& predicate) override {
-        std::mutex allConfirmationsMutex;
-        std::condition_variable allConfirmationsCondition;
-        std::condition_variable_any realCond;
-        std::unordered_set<Packet> receivedConfirmations;
+    void wait(const CondName& condName, DistributedMutex& mutex, const Predicate& predicate,
+              WaitClass waitClass) override {
+        if (predicate()) {
+            return;
+        }
+        ConditionVariable* conditionVariable = startWait(condName);
 
-        /** Conditional variable notify handling **/
-        SubscriptionId notifySubscriptionId = communicationManager->subscribe(
-                /** Predicate function - Accessed by Receiving Thread **/
-                [&](const Packet& packet) {
-                    return packet.messageType == MessageType::COND_NOTIFY and packet.message == condName;
-                },
-                /** Callback function - Accessed by Receiving Thread **/
-                [&](const Packet& notification) {
-                    realCond.notify_one();
-                }
-        );
-
-        communicationManager->sendOthers(MessageType::COND_WAIT, condName);
+        communicationManager->sendOthers(MessageType::COND_WAIT, packWaitClass(condName, waitClass));
         Logger::log("Started waiting on CV '" + condName + "'", rang::fg::cyan);
-        realCond.wait(mutex, predicate);
+        conditionVariable->notified.wait(mutex, predicate);
         Logger::log("Stopped waiting on CV '" + condName + "'", rang::fg::magenta);
+        endWait(condName, *conditionVariable);
+    }
 
-        SubscriptionId confirmationsSubscriptionId = communicationManager->subscribe(
-                /** Predicate function - Accessed by Receiving Thread **/
-                [&](const Packet& packet) {
-                    return packet.messageType == MessageType::COND_WAIT_END_CONFIRM and packet.message == condName;
-                },
-                /** Callback function - Accessed by Receiving Thread **/
-                [&](const Packet& confirmation) {
-                    std::unique_lock<std::mutex> guard(allConfirmationsMutex);
-                    receivedConfirmations.insert(confirmation);
-                    if (areConfirmationsComplete(receivedConfirmations)) {
-                        guard.unlock();
-                        allConfirmationsCondition.notify_one();
-                    }
-                }
-        );
+    bool waitUntil(const CondName& condName, DistributedMutex& mutex, const Predicate& predicate,
+                   WaitClass waitClass, Deadline deadline) override {
+        if (predicate()) {
+            return true;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        ConditionVariable* conditionVariable = startWait(condName);
 
-        communicationManager->sendOthers(MessageType::COND_WAIT_END, condName);
-        /** Wait until all processed confirm that they received our COND_WAIT_END message **/
-        std::unique_lock<std::mutex> allConfirmationsLock(allConfirmationsMutex);
-        allConfirmationsCondition.wait(allConfirmationsLock, [&]() { return areConfirmationsComplete(receivedConfirmations); });
-        communicationManager->unsubscribe(notifySubscriptionId);
-        communicationManager->unsubscribe(confirmationsSubscriptionId);
+        communicationManager->sendOthers(MessageType::COND_WAIT, packWaitClass(condName, waitClass));
+        Logger::log("Started waiting on CV '" + condName + "'", rang::fg::cyan);
+        bool satisfied = conditionVariable->notified.wait_until(mutex, deadline, predicate);
+        Logger::log((satisfied ? "Stopped waiting on CV '" : "Timed out waiting on CV '") + condName + "'",
+                    rang::fg::magenta);
+        endWait(condName, *conditionVariable);
+        bool notificationReceived;
+        {
+            std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+            notificationReceived = conditionVariable->notificationReceived;
+        }
+        if (not satisfied and notificationReceived) {
+            /** The notifier chose this process over another one still waiting, which would miss the notification **/
+            Logger::log("Passing on the notification received after timing out on CV '" + condName + "'");
+            notifyOne(condName, waitClass);
+        }
+        return satisfied;
     }
 
-    void notifyOne(const CondName& condName) override {
-        std::unique_lock<std::mutex> guard(conditionalWaitsMutex);
-        if (conditionalWaits[condName].empty()) {
+    void notifyOne(const CondName& condName, WaitClass waitClass) override {
+        std::unique_lock<std::mutex> guard(conditionVariablesMutex);
+        ConditionVariable& conditionVariable = conditionVariables.at(condName);
+        checkNoLocalWait(condName, conditionVariable.waitingThread);
+        const std::set<Packet>& waits = conditionVariable.waits;
+        auto firstWait = std::find_if(waits.begin(), waits.end(), [&](const Packet& wait) {
+            return matches(unpackWaitClass(wait.message), waitClass);
+        });
+        if (firstWait == waits.end()) {
             Logger::log("There is no one to notify");
             return;
         }
-        ProcessId firstWaitingProcess = (*(conditionalWaits[condName].begin())).source;
+        ProcessId firstWaitingProcess = firstWait->source;
         guard.unlock();
         communicationManager->send(MessageType::COND_NOTIFY, condName, firstWaitingProcess);
     }
 
     void notifyAll(const CondName& condName) override {
-        std::unique_lock<std::mutex> guard(conditionalWaitsMutex);
-        if (conditionalWaits.empty()) {
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        ConditionVariable& conditionVariable = conditionVariables.at(condName);
+        checkNoLocalWait(condName, conditionVariable.waitingThread);
+        const std::set<Packet>& waits = conditionVariable.waits;
+        if (waits.empty()) {
             Logger::log("There is no one to notify");
             return;
         }
-        std::unordered_set<ProcessId> recipients;
-        const std::set<Packet>& waiting = conditionalWaits[condName];
-        std::transform(waiting.begin(), waiting.end(), std::inserter(recipients, recipients.begin()), [&](const Packet& packet) {
-            return packet.source;
-        });
-        guard.unlock();
-        communicationManager->send(MessageType::COND_NOTIFY, condName, recipients);
+        waitingProcesses.clear();
+        for (const Packet& wait : waits) {
+            waitingProcesses.insert(wait.source);
+        }
+        communicationManager->send(MessageType::COND_NOTIFY, condName, waitingProcesses);
     }
 
     ProcessId getProcessId() override {
@@ -134,16 +170,93 @@ public:
 
 private:
 
-    bool areConfirmationsComplete(const std::unordered_set<Packet>& receivedConfirmations) const {
-        return receivedConfirmations.size() == static_cast<std::size_t>(communicationManager->getNumberOfProcesses()) - 1;
+    /** State of a registered CV, kept for its whole lifetime so that waiting on it does not subscribe to anything **/
+    struct ConditionVariable {
+        /** Waits of other processes **/
+        std::set<Packet> waits;
+        /** Woken up by notifications addressed to this process **/
+        std::condition_variable_any notified;
+        /** Processes which confirmed the end of my current wait, grows with the first confirmations **/
+        ProcessSet confirmations;
+        /** Number of my current wait and of the last one whose end all processes confirmed **/
+        std::uint64_t waitGeneration = 0;
+        std::uint64_t confirmedGeneration = 0;
+        /** The thread of this process waiting on the CV, if any (see checkNoLocalWait) **/
+        std::thread::id waitingThread;
+        /** Set when a notification arrives during the current wait **/
+        bool notificationReceived = false;
+    };
+
+    /** Accessed by Main Thread **/
+    ConditionVariable* startWait(const CondName& condName) {
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        ConditionVariable* conditionVariable = &conditionVariables.at(condName);
+        checkNoLocalWait(condName, conditionVariable->waitingThread);
+        conditionVariable->waitingThread = std::this_thread::get_id();
+        conditionVariable->notificationReceived = false;
+        return conditionVariable;
     }
 
-    std::unordered_set<CondName> registeredCVs;
-    std::map<CondName, std::set<Packet>> conditionalWaits;
-    std::shared_ptr<CommunicationManager> communicationManager;
+    /** Accessed by Main Thread - the mutex is held again **/
+    void endWait(const CondName& condName, ConditionVariable& conditionVariable) {
+        std::unique_lock<std::mutex> lock(conditionVariablesMutex);
+        conditionVariable.waitingThread = std::thread::id();
+        std::uint64_t generation = ++conditionVariable.waitGeneration;
+        conditionVariable.confirmations.clear();
+        communicationManager->sendOthers(MessageType::COND_WAIT_END, condName);
+        /** Wait until all processed confirm that they received our COND_WAIT_END message **/
+        auto allConfirmationsReceived = [&]() {
+            return conditionVariable.confirmedGeneration == generation or otherProcessesCount() == 0;
+        };
+        if (directReceive) {
+            lock.unlock();
+            communicationManager->receiveDirectly(condName, [&]() {
+                std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+                return allConfirmationsReceived();
+            });
+        } else {
+            getConfirmationsCondition(condName).wait(lock, allConfirmationsReceived);
+        }
+    }
 
-    std::mutex conditionalWaitsMutex;
-    std::mutex registerCVsMutex;
+    /**
+     * Subscribes to all packets of the given type. The handler is called with the CV the packet concerns, under
+     * conditionVariablesMutex.
+     */
+    template <typename Handler>
+    void subscribe(MessageType messageType, Handler handler) {
+        subscriptions.push_back(communicationManager->subscribe(messageType, [this, handler](const Packet& packet) {
+            std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+            lookupName.assign(extractObjectName(packet.messageType, packet.message));
+            auto conditionVariable = conditionVariables.find(lookupName);
+            if (conditionVariable == conditionVariables.end()) {
+                return false;
+            }
+            handler(packet, conditionVariable->first, conditionVariable->second);
+            return true;
+        }));
+    }
+
+    /** Threads waiting for confirmations share a few condition variables instead of having one per CV **/
+    std::condition_variable& getConfirmationsCondition(const CondName& condName) {
+        return confirmationsConditions[std::hash<CondName>()(condName) % confirmationsConditions.size()];
+    }
+
+    std::size_t otherProcessesCount() const {
+        return static_cast<std::size_t>(communicationManager->getNumberOfProcesses()) - 1;
+    }
+
+    std::unordered_map<CondName, ConditionVariable> conditionVariables;
+    std::mutex conditionVariablesMutex;
+    /** Reused by every lookup of a received CV name, so that it does not allocate **/
+    CondName lookupName;
+    /** Reused by every notifyAll to collect the processes to notify **/
+    ProcessSet waitingProcesses;
+    std::array<std::condition_variable, 16> confirmationsConditions;
+    std::vector<SubscriptionId> subscriptions;
+
+    std::shared_ptr<CommunicationManager> communicationManager;
+    bool directReceive;
 };
 
 #endif //DISTRIBUTEDMONITOR_DISTRIBUTEDCONDITIONVARIABLEALGORITHM_H
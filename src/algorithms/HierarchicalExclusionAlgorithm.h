@@ -0,0 +1,523 @@
+#ifndef DISTRIBUTEDMONITOR_HIERARCHICALEXCLUSIONALGORITHM_H
+#define DISTRIBUTEDMONITOR_HIERARCHICALEXCLUSIONALGORITHM_H
+
+#include <mpi.h>
+#include <condition_variable>
+#include <deque>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <communication/CommunicationManager.h>
+#include <communication/GroupCommunicationManager.h>
+#include <logging/Logger.h>
+#include <util/MessagePacking.h>
+#include <util/Utils.h>
+#include "IDistributedExclusionAlgorithm.h"
+
+using ExclusionAlgorithmFactory =
+        std::function<std::shared_ptr<IDistributedExclusionAlgorithm>(std::shared_ptr<CommunicationManager>)>;
+
+/**
+ * Two-level mutual exclusion. Processes are grouped into nodes and the process with the lowest id in each node becomes
+ * its leader. Processes ask their leader for the mutex. Only the leaders take part in the global algorithm, which is
+ * created by the given factory on a GroupCommunicationManager of the leaders, so the number of messages exchanged
+ * between nodes depends on the number of nodes rather than processes.
+ *
+ * Once a leader acquires the mutex globally, it passes it among the local waiters (at most 'maxLocalHandoffs' times
+ * to stay fair to other nodes) before releasing it globally.
+ *
+ * The mutex no longer reaches the next owner directly from the previous one, so the previous owner's SYNC could arrive
+ * later than the mutex. The previous owner therefore reports how many packets it has sent to every process, leaders
+ * pass it along with the mutex (MUTEX_FENCE between the leaders) and the next owner waits for that many packets.
+ *
+ * A leader talks to the global algorithm from a single worker thread shared by all the mutexes. When the global
+ * algorithm acquires mutexes asynchronously (see supportsAsyncAcquire), the worker never waits for other leaders;
+ * otherwise it acquires the mutexes one at a time, so a process must not acquire a mutex while holding another one.
+ * When every node has a single process the global algorithm is used directly, among all the processes.
+ *
+ * A timed acquisition which runs out of time leaves the leader's queue if it is the leader's own. Another process
+ * abandons its request instead and releases the mutex as soon as it is granted, without a fence of its own, so the next
+ * owner still waits for the packets of the previous one. Acquiring the mutex again takes over the abandoned request.
+ */
+class HierarchicalExclusionAlgorithm : public IDistributedExclusionAlgorithm {
+public:
+
+    /**
+     * Collective - has to be constructed by all processes at the same time.
+     * @param nodes node identifier of every process. By default processes sharing a host form a node.
+     */
+    HierarchicalExclusionAlgorithm(std::shared_ptr<CommunicationManager> communicationManager,
+                                   const ExclusionAlgorithmFactory& globalAlgorithmFactory,
+                                   std::size_t maxLocalHandoffs = 16,
+                                   const std::vector<int>& nodes = detectNodes())
+            : communicationManager(std::move(communicationManager)), maxLocalHandoffs(maxLocalHandoffs) {
+
+        ProcessId myProcessId = this->communicationManager->getProcessId();
+        std::set<ProcessId> leaders;
+        leader = myProcessId;
+        for (ProcessId processId = 0; processId < static_cast<ProcessId>(nodes.size()); ++processId) {
+            if (nodes[processId] == nodes[myProcessId]) {
+                leader = std::min(leader, processId);
+            }
+            if (std::find(nodes.begin(), nodes.begin() + processId, nodes[processId]) == nodes.begin() + processId) {
+                leaders.insert(processId);
+            }
+        }
+        flat = leaders.size() == nodes.size();
+        if (flat) {
+            globalAlgorithm = globalAlgorithmFactory(this->communicationManager);
+        } else if (isLeader()) {
+            auto leadersManager = std::make_shared<GroupCommunicationManager>(
+                    this->communicationManager, std::vector<ProcessId>(leaders.begin(), leaders.end()));
+            for (ProcessId otherLeader : leaders) {
+                if (otherLeader != myProcessId) {
+                    otherLeaders.insert(otherLeader);
+                }
+            }
+            globalAlgorithm = globalAlgorithmFactory(leadersManager);
+            globalWorker = std::thread([this]() { globalWorkerFunction(); });
+        }
+    }
+
+    ~HierarchicalExclusionAlgorithm() override {
+        std::vector<MutexName> mutexNames;
+        {
+            std::lock_guard<std::mutex> lock(mutexesMutex);
+            for (const auto& mutex : mutexes) {
+                mutexNames.push_back(mutex.first);
+            }
+        }
+        for (const MutexName& mutexName : mutexNames) {
+            unregisterMutex(mutexName);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutexesMutex);
+            stopping = true;
+        }
+        globalCommandsAvailable.notify_one();
+        if (globalWorker.joinable()) {
+            globalWorker.join();
+        }
+    }
+
+    void registerMutex(const MutexName& mutexName) override {
+        if (flat) {
+            globalAlgorithm->registerMutex(mutexName);
+            return;
+        }
+        if (isLeader()) {
+            globalAlgorithm->registerMutex(mutexName);
+        }
+        std::lock_guard<std::mutex> lock(mutexesMutex);
+        auto [mutexIterator, inserted] = mutexes.try_emplace(mutexName);
+        if (not inserted) {
+            return;
+        }
+        HierarchicalMutex& mutex = mutexIterator->second;
+        if (not isLeader()) {
+            /** Grants from the leader handling **/
+            mutex.subscriptions.push_back(communicationManager->subscribe(
+                    MessageType::LOCAL_MUTEX_GRANT, mutexName, [this, &mutex, mutexName](const Packet& grant) {
+                        std::string_view data = extractData(grant.message);
+                        {
+                            std::lock_guard<std::mutex> lock(mutexesMutex);
+                            if (mutex.requestAbandoned) {
+                                mutex.requestAbandoned = false;
+                                Logger::log("Releasing mutex '" + mutexName + "' requested in vain");
+                                communicationManager->send(MessageType::LOCAL_MUTEX_RELEASE,
+                                                           packNamedMessage(mutexName, ""), leader);
+                                return;
+                            }
+                            mutex.granted = true;
+                            mutex.grantFenceOwner =
+                                    static_cast<ProcessId>(static_cast<std::int64_t>(readNumber(data, 0)));
+                            mutex.grantFencePackets = readNumber(data, 1);
+                        }
+                        mutex.grantArrived.notify_one();
+                    }
+            ));
+            return;
+        }
+        /** Local requests handling **/
+        mutex.subscriptions.push_back(communicationManager->subscribe(
+                MessageType::LOCAL_MUTEX_REQUEST, mutexName, [this, &mutex, mutexName](const Packet& request) {
+                    std::lock_guard<std::mutex> lock(mutexesMutex);
+                    mutex.queue.push_back(request.source);
+                    schedule(mutexName, mutex);
+                }
+        ));
+        /** Local releases handling **/
+        mutex.subscriptions.push_back(communicationManager->subscribe(
+                MessageType::LOCAL_MUTEX_RELEASE, mutexName, [this, &mutex, mutexName](const Packet& release) {
+                    std::lock_guard<std::mutex> lock(mutexesMutex);
+                    processLocalRelease(mutexName, mutex, release.source, readNumbers(extractData(release.message), 0));
+                }
+        ));
+        /** Fences from other leaders handling **/
+        mutex.subscriptions.push_back(communicationManager->subscribe(
+                MessageType::MUTEX_FENCE, mutexName, [this, &mutex](const Packet& fence) {
+                    std::string_view data = extractData(fence.message);
+                    std::lock_guard<std::mutex> lock(mutexesMutex);
+                    std::uint64_t sequence = readNumber(data, 0);
+                    /** Fences of earlier owners may arrive after the latest one **/
+                    if (sequence > mutex.fence.sequence) {
+                        mutex.fence.sequence = sequence;
+                        mutex.fence.lastOwner = static_cast<ProcessId>(static_cast<std::int64_t>(readNumber(data, 1)));
+                        mutex.fence.sentPackets = readNumbers(data, 2);
+                    }
+                }
+        ));
+    }
+
+    void unregisterMutex(const MutexName& mutexName) override {
+        if (flat) {
+            globalAlgorithm->unregisterMutex(mutexName);
+            return;
+        }
+        std::vector<SubscriptionId> subscriptions;
+        {
+            std::lock_guard<std::mutex> lock(mutexesMutex);
+            auto mutex = mutexes.find(mutexName);
+            if (mutex == mutexes.end()) {
+                return;
+            }
+            subscriptions = mutex->second.subscriptions;
+        }
+        for (SubscriptionId subscription : subscriptions) {
+            communicationManager->unsubscribe(subscription);
+        }
+        {
+            /** The last global release may still be waiting for the worker **/
+            std::unique_lock<std::mutex> lock(mutexesMutex);
+            HierarchicalMutex& mutex = mutexes.at(mutexName);
+            globalCommandsDone.wait(lock, [&]() { return mutex.queuedGlobalCommands == 0; });
+            mutexes.erase(mutexName);
+        }
+        if (isLeader()) {
+            globalAlgorithm->unregisterMutex(mutexName);
+        }
+    }
+
+    /** Accessed by Main Thread **/
+    void acquireMutex(const MutexName& mutexName) override {
+        if (flat) {
+            globalAlgorithm->acquireMutex(mutexName);
+            return;
+        }
+        std::unique_lock<std::mutex> lock(mutexesMutex);
+        HierarchicalMutex& mutex = mutexes.at(mutexName);
+        request(mutexName, mutex);
+        mutex.grantArrived.wait(lock, [&]() { return mutex.granted; });
+        enter(mutexName, mutex, lock);
+    }
+
+    /** Accessed by Main Thread **/
+    bool tryAcquireMutex(const MutexName& mutexName, Deadline deadline) override {
+        if (flat) {
+            return globalAlgorithm->tryAcquireMutex(mutexName, deadline);
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::unique_lock<std::mutex> lock(mutexesMutex);
+        HierarchicalMutex& mutex = mutexes.at(mutexName);
+        request(mutexName, mutex);
+        if (not mutex.grantArrived.wait_until(lock, deadline, [&]() { return mutex.granted; })) {
+            if (isLeader()) {
+                mutex.queue.erase(std::find(mutex.queue.begin(), mutex.queue.end(), getProcessId()));
+            } else {
+                mutex.requestAbandoned = true;
+            }
+            Logger::log("Gave up acquiring mutex '" + mutexName + "'", rang::fg::yellow);
+            return false;
+        }
+        enter(mutexName, mutex, lock);
+        return true;
+    }
+
+    void acquireMutexAsync(const MutexName& mutexName, std::function<void()> onAcquired) override {
+        if (flat) {
+            globalAlgorithm->acquireMutexAsync(mutexName, std::move(onAcquired));
+            return;
+        }
+        IDistributedExclusionAlgorithm::acquireMutexAsync(mutexName, std::move(onAcquired));
+    }
+
+    bool supportsAsyncAcquire() const override {
+        return flat and globalAlgorithm->supportsAsyncAcquire();
+    }
+
+    /** Accessed by Main Thread **/
+    void releaseMutex(const MutexName& mutexName) override {
+        if (flat) {
+            globalAlgorithm->releaseMutex(mutexName);
+            return;
+        }
+        std::vector<std::uint64_t> sentPackets;
+        std::size_t channel = communicationManager->getChannel(mutexName);
+        for (ProcessId processId = 0; processId < communicationManager->getNumberOfProcesses(); ++processId) {
+            sentPackets.push_back(communicationManager->getSentPacketsCount(processId, channel));
+        }
+        Logger::log("Mutex '" + mutexName + "' released", rang::fg::yellow);
+        if (isLeader()) {
+            std::lock_guard<std::mutex> lock(mutexesMutex);
+            processLocalRelease(mutexName, mutexes.at(mutexName), getProcessId(), std::move(sentPackets));
+        } else {
+            std::string data;
+            for (std::uint64_t packets : sentPackets) {
+                appendNumber(data, packets);
+            }
+            communicationManager->send(MessageType::LOCAL_MUTEX_RELEASE, packNamedMessage(mutexName, data), leader);
+        }
+    }
+
+    ProcessId getProcessId() override {
+        return communicationManager->getProcessId();
+    }
+
+    ProcessId getLeader() const {
+        return leader;
+    }
+
+    bool isLeader() {
+        return leader == communicationManager->getProcessId();
+    }
+
+    /** Collective - identifies every process' node by the lowest id of a process sharing the host with it **/
+    static std::vector<int> detectNodes() {
+        MPI_Comm nodeCommunicator;
+        int myProcessId, numberOfProcesses;
+        MPI_Comm_rank(MPI_COMM_WORLD, &myProcessId);
+        MPI_Comm_size(MPI_COMM_WORLD, &numberOfProcesses);
+        MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, myProcessId, MPI_INFO_NULL, &nodeCommunicator);
+        int node = myProcessId;
+        MPI_Allreduce(MPI_IN_PLACE, &node, 1, MPI_INT, MPI_MIN, nodeCommunicator);
+        MPI_Comm_free(&nodeCommunicator);
+
+        std::vector<int> nodes(static_cast<std::size_t>(numberOfProcesses));
+        MPI_Allgather(&node, 1, MPI_INT, nodes.data(), 1, MPI_INT, MPI_COMM_WORLD);
+        return nodes;
+    }
+
+private:
+
+    static constexpr ProcessId NO_PROCESS = -1;
+
+    enum class GlobalCommand {
+        ACQUIRE, RELEASE
+    };
+
+    /** Who owned the mutex last and how many packets it had sent to every process by then **/
+    struct Fence {
+        std::uint64_t sequence = 0;
+        ProcessId lastOwner = NO_PROCESS;
+        std::vector<std::uint64_t> sentPackets;
+    };
+
+    struct HierarchicalMutex {
+        /** Local participant's state **/
+        bool granted = false;
+        /** A timed acquisition of this process (not the leader) gave up - the grant is returned right away **/
+        bool requestAbandoned = false;
+        ProcessId grantFenceOwner = NO_PROCESS;
+        std::uint64_t grantFencePackets = 0;
+        std::condition_variable grantArrived;
+
+        /** Leader's state **/
+        std::deque<ProcessId> queue;
+        ProcessId owner = NO_PROCESS;
+        bool globalHeld = false;
+        bool globalRequested = false;
+        std::size_t localHandoffs = 0;
+        Fence fence;
+
+        /** Commands pushed for the global worker and not run yet **/
+        std::size_t queuedGlobalCommands = 0;
+
+        std::vector<SubscriptionId> subscriptions;
+    };
+
+    /** Accessed by Main Thread - protected by mutexesMutex. Takes over an abandoned request if there is one. **/
+    void request(const MutexName& mutexName, HierarchicalMutex& mutex) {
+        mutex.granted = false;
+        if (isLeader()) {
+            mutex.queue.push_back(getProcessId());
+            schedule(mutexName, mutex);
+        } else if (mutex.requestAbandoned) {
+            mutex.requestAbandoned = false;
+        } else {
+            communicationManager->send(MessageType::LOCAL_MUTEX_REQUEST, packNamedMessage(mutexName, ""), leader);
+        }
+    }
+
+    /** Accessed by Main Thread - the mutex has been granted, unlocks the lock **/
+    void enter(const MutexName& mutexName, HierarchicalMutex& mutex, std::unique_lock<std::mutex>& lock) {
+        ProcessId fenceOwner = mutex.grantFenceOwner;
+        std::uint64_t fencePackets = mutex.grantFencePackets;
+        lock.unlock();
+
+        /** Make sure everything the previous owner has sent to me (e.g. SYNC) has been processed **/
+        if (fenceOwner != NO_PROCESS and fenceOwner != getProcessId()) {
+            communicationManager->awaitDispatchedPackets(fenceOwner, fencePackets,
+                                                         communicationManager->getChannel(mutexName));
+        }
+        Logger::log("Mutex '" + mutexName + "' acquired", rang::fg::blue);
+    }
+
+    /** Accessed by Leader's threads - protected by mutexesMutex **/
+    void schedule(const MutexName& mutexName, HierarchicalMutex& mutex) {
+        if (mutex.owner != NO_PROCESS or mutex.queue.empty()) {
+            return;
+        }
+        if (mutex.globalHeld) {
+            grant(mutexName, mutex);
+        } else if (not mutex.globalRequested) {
+            mutex.globalRequested = true;
+            pushGlobalCommand(mutexName, mutex, GlobalCommand::ACQUIRE);
+        }
+    }
+
+    /**
+     * Accessed by Leader's threads - protected by mutexesMutex. A process which abandoned its request sends no packet
+     * counts, the fence of the previous owner stays then.
+     */
+    void processLocalRelease(const MutexName& mutexName, HierarchicalMutex& mutex, ProcessId owner,
+                             std::vector<std::uint64_t> sentPackets) {
+        mutex.owner = NO_PROCESS;
+        if (not sentPackets.empty()) {
+            mutex.fence.lastOwner = owner;
+            mutex.fence.sentPackets = std::move(sentPackets);
+        }
+        if (not mutex.queue.empty() and mutex.localHandoffs < maxLocalHandoffs) {
+            grant(mutexName, mutex);
+            return;
+        }
+        releaseGlobally(mutexName, mutex);
+        schedule(mutexName, mutex);
+    }
+
+    /** Accessed by Leader's threads - protected by mutexesMutex **/
+    void grant(const MutexName& mutexName, HierarchicalMutex& mutex) {
+        ProcessId nextOwner = mutex.queue.front();
+        mutex.queue.pop_front();
+        mutex.owner = nextOwner;
+        ++mutex.localHandoffs;
+        ProcessId fenceOwner = mutex.fence.lastOwner;
+        std::uint64_t fencePackets = fenceOwner == NO_PROCESS ? 0 : mutex.fence.sentPackets[nextOwner];
+        if (nextOwner == getProcessId()) {
+            mutex.granted = true;
+            mutex.grantFenceOwner = fenceOwner;
+            mutex.grantFencePackets = fencePackets;
+            mutex.grantArrived.notify_one();
+        } else {
+            std::string data;
+            appendNumber(data, static_cast<std::uint64_t>(static_cast<std::int64_t>(fenceOwner)));
+            appendNumber(data, fencePackets);
+            communicationManager->send(MessageType::LOCAL_MUTEX_GRANT, packNamedMessage(mutexName, data), nextOwner);
+        }
+    }
+
+    /**
+     * Accessed by Leader's threads - protected by mutexesMutex
+     * The fence is sent to other leaders before the global release, so it reaches the next global owner first.
+     */
+    void releaseGlobally(const MutexName& mutexName, HierarchicalMutex& mutex) {
+        mutex.globalHeld = false;
+        ++mutex.fence.sequence;
+        if (not otherLeaders.empty()) {
+            std::string data;
+            appendNumber(data, mutex.fence.sequence);
+            appendNumber(data, static_cast<std::uint64_t>(static_cast<std::int64_t>(mutex.fence.lastOwner)));
+            for (std::uint64_t packets : mutex.fence.sentPackets) {
+                appendNumber(data, packets);
+            }
+            communicationManager->send(MessageType::MUTEX_FENCE, packNamedMessage(mutexName, data), otherLeaders);
+        }
+        pushGlobalCommand(mutexName, mutex, GlobalCommand::RELEASE);
+    }
+
+    /** Accessed by Leader's threads - protected by mutexesMutex **/
+    void pushGlobalCommand(const MutexName& mutexName, HierarchicalMutex& mutex, GlobalCommand command) {
+        ++mutex.queuedGlobalCommands;
+        globalCommands.emplace_back(mutexName, command);
+        globalCommandsAvailable.notify_one();
+    }
+
+    /**
+     * Accessed by Leader's Global Worker Thread - the commands are run without mutexesMutex, since the global algorithm
+     * may call back synchronously. Stops once the commands left by the unregistered mutexes are run.
+     */
+    void globalWorkerFunction() {
+        Logger::registerThread("Glob", rang::fg::green);
+        while (true) {
+            std::pair<MutexName, GlobalCommand> command;
+            {
+                std::unique_lock<std::mutex> lock(mutexesMutex);
+                globalCommandsAvailable.wait(lock, [&]() { return stopping or not globalCommands.empty(); });
+                if (globalCommands.empty()) {
+                    return;
+                }
+                command = std::move(globalCommands.front());
+                globalCommands.pop_front();
+            }
+            const MutexName& mutexName = command.first;
+            if (command.second == GlobalCommand::RELEASE) {
+                globalAlgorithm->releaseMutex(mutexName);
+            } else if (globalAlgorithm->supportsAsyncAcquire()) {
+                globalAlgorithm->acquireMutexAsync(mutexName, [this, mutexName]() { processGlobalAcquire(mutexName); });
+            } else {
+                globalAlgorithm->acquireMutex(mutexName);
+                processGlobalAcquire(mutexName);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutexesMutex);
+                --mutexes.at(mutexName).queuedGlobalCommands;
+            }
+            globalCommandsDone.notify_all();
+        }
+    }
+
+    /** Accessed by Leader's Global Worker Thread or the thread completing an asynchronous global acquisition **/
+    void processGlobalAcquire(const MutexName& mutexName) {
+        std::lock_guard<std::mutex> lock(mutexesMutex);
+        HierarchicalMutex& mutex = mutexes.at(mutexName);
+        mutex.globalHeld = true;
+        mutex.globalRequested = false;
+        mutex.localHandoffs = 0;
+        /** The leader's own request, the only one, may have been withdrawn in the meantime **/
+        if (mutex.queue.empty()) {
+            releaseGlobally(mutexName, mutex);
+            return;
+        }
+        schedule(mutexName, mutex);
+    }
+
+    static std::vector<std::uint64_t> readNumbers(std::string_view data, std::size_t firstIndex) {
+        std::vector<std::uint64_t> numbers;
+        for (std::size_t i = firstIndex; i < countNumbers(data); ++i) {
+            numbers.push_back(readNumber(data, i));
+        }
+        return numbers;
+    }
+
+    std::map<MutexName, HierarchicalMutex> mutexes;
+    std::mutex mutexesMutex;
+
+    /** Leader's commands for the global algorithm, protected by mutexesMutex **/
+    std::deque<std::pair<MutexName, GlobalCommand>> globalCommands;
+    std::condition_variable globalCommandsAvailable;
+    std::condition_variable globalCommandsDone;
+    bool stopping = false;
+    std::thread globalWorker;
+
+    std::shared_ptr<CommunicationManager> communicationManager;
+    std::shared_ptr<IDistributedExclusionAlgorithm> globalAlgorithm;
+    ProcessSet otherLeaders;
+    ProcessId leader;
+    /** Every node has a single process - the global algorithm runs among all of them, without the leaders' level **/
+    bool flat = false;
+    std::size_t maxLocalHandoffs;
+};
+
+#endif //DISTRIBUTEDMONITOR_HIERARCHICALEXCLUSIONALGORITHM_H
@@ -1,24 +1,89 @@
 #ifndef DISTRIBUTEDMONITOR_IDISTRIBUTEDCONDITIONVARIABLEALGORITHM_H
 #define DISTRIBUTEDMONITOR_IDISTRIBUTEDCONDITIONVARIABLEALGORITHM_H
 
+#include <functional>
+#include <stdexcept>
+#include <thread>
 #include <util/Define.h>
+#include <util/MessagePacking.h>
 #include <distributed/DistributedMutex.h>
 
 class IDistributedConditionVariableAlgorithm {
 public:
 
+    virtual ~IDistributedConditionVariableAlgorithm() = default;
+
     virtual void registerCV(const CondName& condName) = 0;
 
     virtual void unregisterCV(const CondName& condName) = 0;
 
-    virtual void wait(const CondName& condName, DistributedMutex& mutex, const Predicate& predicate) = 0;
+    /** Returns right away, without sending anything, if the predicate already holds **/
+    virtual void wait(const CondName& condName, DistributedMutex& mutex, const Predicate& predicate,
+                      WaitClass waitClass) = 0;
+
+    /**
+     * Like wait, but stops waiting at the deadline and withdraws the wait, so that no notification is addressed to
+     * it afterwards - a notification which was on its way already is passed on to another waiting process of its class.
+     * The mutex is held again on return either way. Returns what the predicate returns then.
+     */
+    virtual bool waitUntil(const CondName& condName, DistributedMutex& mutex, const Predicate& predicate,
+                           WaitClass waitClass, Deadline deadline) {
+        throw std::runtime_error("This condition variable algorithm does not support timed waits on CV '" + condName +
+                                 "'");
+    }
 
-    virtual void notifyOne(const CondName& condName) = 0;
+    /**
+     * Like wait, but does not block the calling thread: once the predicate holds with the mutex locked again (see
+     * DistributedMutex::lockAsync), 'onWoken' is called by the thread which has locked it - right away if the predicate
+     * already holds. The mutex is unlocked before the call returns otherwise.
+     */
+    virtual void waitAsync(const CondName& condName, DistributedMutex& mutex, Predicate predicate, WaitClass waitClass,
+                           std::function<void()> onWoken) {
+        throw std::runtime_error("This condition variable algorithm does not support asynchronous waits on CV '" +
+                                 condName + "'");
+    }
+
+    /** Wakes up the earliest waiting process whose wait class matches the given one **/
+    virtual void notifyOne(const CondName& condName, WaitClass waitClass) = 0;
 
     virtual void notifyAll(const CondName& condName) = 0;
 
     virtual ProcessId getProcessId() = 0;
 
+protected:
+
+    static bool matches(WaitClass waitClass, WaitClass notificationClass) {
+        return waitClass == notificationClass or waitClass == ANY_WAIT_CLASS or notificationClass == ANY_WAIT_CLASS;
+    }
+
+    /** COND_WAIT and COND_NOTIFY_ONE carry the wait class after the CV name, nothing for ANY_WAIT_CLASS **/
+    static std::string packWaitClass(const CondName& condName, WaitClass waitClass) {
+        std::string data;
+        if (waitClass != ANY_WAIT_CLASS) {
+            appendVarint(data, waitClass);
+        }
+        return packNamedMessage(condName, data);
+    }
+
+    static WaitClass unpackWaitClass(std::string_view message) {
+        std::string_view data = extractData(message);
+        std::size_t offset = 0;
+        return data.empty() ? ANY_WAIT_CLASS : static_cast<WaitClass>(readVarint(data, offset));
+    }
+
+    /**
+     * For the algorithms which track the waits of processes rather than of threads - a notification never reaches a
+     * wait of its own process, so while a thread of this process waits on the CV (the given thread, if any), no other
+     * thread of it may wait on or notify the CV.
+     */
+    static void checkNoLocalWait(const CondName& condName, std::thread::id waitingThread) {
+        if (waitingThread != std::thread::id()) {
+            throw std::runtime_error("Another thread of this process waits on CV '" + condName + "' - the algorithm " +
+                                     "supports one thread per process, use MonitorStateConditionVariableAlgorithm " +
+                                     "or CentralizedConditionVariableAlgorithm");
+        }
+    }
+
 };
 
 #endif //DISTRIBUTEDMONITOR_IDISTRIBUTEDCONDITIONVARIABLEALGORITHM_H
@@ -1,11 +1,16 @@
 #ifndef DISTRIBUTEDMONITOR_IDISTRIBUTEDEXCLUSIONALGORITHM_H
 #define DISTRIBUTEDMONITOR_IDISTRIBUTEDEXCLUSIONALGORITHM_H
 
+#include <chrono>
+#include <functional>
+#include <stdexcept>
 #include <util/Define.h>
 
 class IDistributedExclusionAlgorithm {
 public:
 
+    virtual ~IDistributedExclusionAlgorithm() = default;
+
     /** Associates a mutex with the given algorithm. It is crucial to know which algorithms handle which mutexes. */
     virtual void registerMutex(const MutexName& mutexName) = 0;
 
@@ -14,6 +19,42 @@ public:
     /** This function blocks until all other remote processes agree for this process to acquire the mutex */
     virtual void acquireMutex(const MutexName& mutexName) = 0;
 
+    /**
+     * Like acquireMutex, but gives up at the deadline and withdraws the request, so that the mutex is not granted to
+     * this process afterwards. Returns whether the mutex has been acquired. A deadline which has already passed makes
+     * it fail without sending anything unless the mutex can be acquired without any messages.
+     *
+     * All the algorithms of this library support it. By default the mutex is never acquired without messages, so a
+     * deadline which has passed fails right away, and waiting until a later deadline is not supported.
+     */
+    virtual bool tryAcquireMutex(const MutexName& mutexName, Deadline deadline) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        throw std::runtime_error("This exclusion algorithm does not support timed acquisition of mutex '" +
+                                 mutexName + "'");
+    }
+
+    /**
+     * Acquires the mutex without blocking the calling thread and calls 'onAcquired' with the mutex held - on the
+     * calling thread if it is granted without waiting, otherwise on the thread which completes the acquisition (e.g.
+     * the receiving thread), so it must neither block nor throw. The mutex is released with releaseMutex as usual, from
+     * any thread. By default the calling thread is blocked in acquireMutex, so the mutex must not be acquired again
+     * before it is released.
+     */
+    virtual void acquireMutexAsync(const MutexName& mutexName, std::function<void()> onAcquired) {
+        acquireMutex(mutexName);
+        onAcquired();
+    }
+
+    /**
+     * Whether acquireMutexAsync returns without waiting for other processes. Otherwise it must not be called by the
+     * receiving thread, which would wait for the agreements it is supposed to receive itself.
+     */
+    virtual bool supportsAsyncAcquire() const {
+        return false;
+    }
+
     virtual void releaseMutex(const MutexName& mutexName) = 0;
 
     virtual ProcessId getProcessId() = 0;
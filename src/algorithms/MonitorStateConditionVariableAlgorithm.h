@@ -0,0 +1,386 @@
+#ifndef DISTRIBUTEDMONITOR_MONITORSTATECONDITIONVARIABLEALGORITHM_H
+#define DISTRIBUTEDMONITOR_MONITORSTATECONDITIONVARIABLEALGORITHM_H
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <communication/CommunicationManager.h>
+#include <distributed/DistributedMonitorRegistry.h>
+#include <logging/ConsoleColor.h>
+#include <logging/Logger.h>
+#include <util/MessagePacking.h>
+#include "IDistributedConditionVariableAlgorithm.h"
+
+/**
+ * Queues of processes waiting on the CVs of a monitor are a part of the monitor's state - they are sent in its SYNC
+ * messages and restored from them. Waiting and notifying are operations on the queue under the monitor's mutex, so the
+ * only messages of a wait are the SYNC sent before releasing the mutex and the notification of the process which
+ * notifies the waiter - COND_NOTIFY_ONE with the class of the removed wait, or COND_NOTIFY for notify_all().
+ *
+ * Every process keeps its own waits locally in the order they started, so that many threads (and asynchronous waits,
+ * see waitAsync) of a process can wait on one CV - a COND_NOTIFY_ONE wakes up the earliest one of its class.
+ *
+ * CVs have to be used with the mutex of a DistributedMonitor (or StaticDistributedMonitor) sharing the communication
+ * manager with the algorithm, and notified while holding it. All processes have to create the same condition variable
+ * algorithms, in the same order, for every communication manager.
+ */
+class MonitorStateConditionVariableAlgorithm : public IDistributedConditionVariableAlgorithm,
+                                               public MonitorStateExtension {
+public:
+
+    explicit MonitorStateConditionVariableAlgorithm(std::shared_ptr<CommunicationManager> communicationManager)
+            : communicationManager(std::move(communicationManager)) {
+        registry = DistributedMonitorRegistry::of(this->communicationManager);
+        registry->addExtension(this);
+        waitingProcesses = ProcessSet(static_cast<std::size_t>(this->communicationManager->getNumberOfProcesses()));
+        /** Conditional variable notify handling **/
+        for (MessageType messageType : {MessageType::COND_NOTIFY, MessageType::COND_NOTIFY_ONE}) {
+            notifySubscriptions.push_back(this->communicationManager->subscribe(
+                    messageType, [this](const Packet& notification) {
+                        return processNotification(notification);
+                    }
+            ));
+        }
+    }
+
+    ~MonitorStateConditionVariableAlgorithm() override {
+        for (SubscriptionId subscription : notifySubscriptions) {
+            communicationManager->unsubscribe(subscription);
+        }
+        registry->removeExtension(this);
+    }
+
+    void registerCV(const CondName& condName) override {
+        communicationManager->internName(condName);
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        conditionVariables.try_emplace(condName);
+    }
+
+    void unregisterCV(const CondName& condName) override {
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        conditionVariables.erase(condName);
+    }
+
+    /** Accessed by Main Thread - the mutex is held whenever the predicate is checked and the queue modified **/
+    void wait(const CondName& condName, DistributedMutex& mutex, const Predicate& predicate,
+              WaitClass waitClass) override {
+        while (not predicate()) {
+            bool notified = false;
+            startWait(condName, mutex, {waitClass, &notified});
+            /** The next owner of the mutex has to know I am waiting **/
+            registry->publish(mutex.getName());
+            Logger::log("Started waiting on CV '" + condName + "'", rang::fg::cyan);
+            mutex.unlock();
+            {
+                std::unique_lock<std::mutex> lock(conditionVariablesMutex);
+                getNotifiedCondition(condName).wait(lock, [&]() { return notified; });
+            }
+            Logger::log("Stopped waiting on CV '" + condName + "'", rang::fg::magenta);
+            mutex.lock();
+        }
+    }
+
+    /**
+     * Accessed by Main Thread - a wait which runs out of time removes its entry from the queue once the mutex is held
+     * again, unless a notification has removed it in the meantime. The queue without it is sent with the next SYNC.
+     */
+    bool waitUntil(const CondName& condName, DistributedMutex& mutex, const Predicate& predicate,
+                   WaitClass waitClass, Deadline deadline) override {
+        while (not predicate()) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            bool notified = false;
+            auto localWait = startWait(condName, mutex, {waitClass, &notified});
+            registry->publish(mutex.getName());
+            Logger::log("Started waiting on CV '" + condName + "'", rang::fg::cyan);
+            mutex.unlock();
+            {
+                std::unique_lock<std::mutex> lock(conditionVariablesMutex);
+                if (not getNotifiedCondition(condName).wait_until(lock, deadline, [&]() { return notified; })) {
+                    conditionVariables.at(condName).localWaits.erase(localWait);
+                }
+            }
+            mutex.lock();
+            if (not notified) {
+                Logger::log("Timed out waiting on CV '" + condName + "'", rang::fg::magenta);
+                withdraw(condName, waitClass);
+                return predicate();
+            }
+            Logger::log("Stopped waiting on CV '" + condName + "'", rang::fg::magenta);
+        }
+        return true;
+    }
+
+    /**
+     * The wait is queued like a blocking one. When it is notified, the mutex is locked asynchronously and the wait
+     * repeated, so that the predicate is checked again with the mutex held. The notification is handled by the
+     * receiving thread, so the mutex algorithm has to acquire it without blocking (see supportsAsyncAcquire).
+     */
+    void waitAsync(const CondName& condName, DistributedMutex& mutex, Predicate predicate, WaitClass waitClass,
+                   std::function<void()> onWoken) override {
+        if (not mutex.supportsAsyncLock()) {
+            throw std::runtime_error("Asynchronous waits on CV '" + condName + "' require a mutex algorithm acquiring "
+                                     "the mutex asynchronously");
+        }
+        if (predicate()) {
+            onWoken();
+            return;
+        }
+        startWait(condName, mutex, {waitClass, nullptr, &mutex, std::move(predicate), std::move(onWoken)});
+        registry->publish(mutex.getName());
+        Logger::log("Started waiting asynchronously on CV '" + condName + "'", rang::fg::cyan);
+        mutex.unlock();
+    }
+
+    /** Accessed by Main Thread - the mutex of the CV's monitor has to be held **/
+    void notifyOne(const CondName& condName, WaitClass waitClass) override {
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        std::deque<Waiter>* waiters = findWaiters(condName);
+        if (waiters == nullptr) {
+            Logger::log("There is no one to notify");
+            return;
+        }
+        auto firstWaiter = std::find_if(waiters->begin(), waiters->end(), [&](const Waiter& waiter) {
+            return matches(waiter.waitClass, waitClass);
+        });
+        if (firstWaiter == waiters->end()) {
+            Logger::log("There is no one to notify");
+            return;
+        }
+        ProcessId firstWaitingProcess = firstWaiter->processId;
+        WaitClass firstWaitClass = firstWaiter->waitClass;
+        waiters->erase(firstWaiter);
+        removeIfEmpty(condName);
+        communicationManager->send(MessageType::COND_NOTIFY_ONE, packWaitClass(condName, firstWaitClass),
+                                   firstWaitingProcess);
+    }
+
+    /** Accessed by Main Thread - the mutex of the CV's monitor has to be held **/
+    void notifyAll(const CondName& condName) override {
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        std::deque<Waiter>* waiters = findWaiters(condName);
+        if (waiters == nullptr) {
+            Logger::log("There is no one to notify");
+            return;
+        }
+        waitingProcesses.clear();
+        for (const Waiter& waiter : *waiters) {
+            waitingProcesses.insert(waiter.processId);
+        }
+        waiters->clear();
+        removeIfEmpty(condName);
+        communicationManager->send(MessageType::COND_NOTIFY, condName, waitingProcesses);
+    }
+
+    ProcessId getProcessId() override {
+        return communicationManager->getProcessId();
+    }
+
+    /**
+     * Queues are saved as: [number of CVs] and for each of them [name length][name][number of waiters] followed by
+     * [process][wait class] of every waiter
+     */
+    void saveMonitorState(const std::string& monitorName, std::string& state) override {
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        auto monitorQueues = waitQueues.find(monitorName);
+        if (monitorQueues == waitQueues.end()) {
+            appendVarint(state, 0);
+            return;
+        }
+        appendVarint(state, monitorQueues->second.size());
+        for (const auto& [condName, waiters] : monitorQueues->second) {
+            appendVarint(state, condName.size());
+            state.append(condName);
+            appendVarint(state, waiters.size());
+            for (const Waiter& waiter : waiters) {
+                appendVarint(state, static_cast<std::uint64_t>(waiter.processId));
+                appendVarint(state, waiter.waitClass);
+            }
+        }
+    }
+
+    /** Accessed by Receiving Thread - replaces all queues of the monitor **/
+    void restoreMonitorState(const std::string& monitorName, std::string_view state) override {
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        std::size_t offset = 0;
+        auto conditionVariablesCount = readVarint(state, offset);
+        if (conditionVariablesCount == 0) {
+            waitQueues.erase(monitorName);
+            return;
+        }
+        std::map<CondName, std::deque<Waiter>>& monitorQueues = waitQueues[monitorName];
+        monitorQueues.clear();
+        for (std::uint64_t i = 0; i < conditionVariablesCount; ++i) {
+            auto nameLength = static_cast<std::size_t>(readVarint(state, offset));
+            CondName condName(state.substr(offset, nameLength));
+            offset += nameLength;
+            std::deque<Waiter>& waiters = monitorQueues[condName];
+            auto waitersCount = readVarint(state, offset);
+            for (std::uint64_t waiter = 0; waiter < waitersCount; ++waiter) {
+                auto processId = static_cast<ProcessId>(readVarint(state, offset));
+                auto waitClass = static_cast<WaitClass>(readVarint(state, offset));
+                waiters.push_back({processId, waitClass});
+            }
+            auto conditionVariable = conditionVariables.find(condName);
+            if (conditionVariable != conditionVariables.end()) {
+                conditionVariable->second.monitorName = monitorName;
+            }
+        }
+    }
+
+private:
+
+    struct Waiter {
+        ProcessId processId;
+        WaitClass waitClass;
+    };
+
+    /** Wait of a thread of this process, or an asynchronous one **/
+    struct LocalWait {
+        WaitClass waitClass;
+        /** Set under conditionVariablesMutex when the waiting thread is notified **/
+        bool* notified;
+        DistributedMutex* mutex = nullptr;
+        Predicate predicate;
+        std::function<void()> onWoken;
+    };
+
+    /** Local state of a registered CV **/
+    struct ConditionVariable {
+        /** Monitor the CV was last seen waited on with, empty if not known yet **/
+        MutexName monitorName;
+        /** Waits of this process, in the order they started **/
+        std::list<LocalWait> localWaits;
+    };
+
+    /** Queues the wait both locally and in the monitor's state, the mutex has to be held **/
+    std::list<LocalWait>::iterator startWait(const CondName& condName, DistributedMutex& mutex, LocalWait localWait) {
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        ConditionVariable& conditionVariable = conditionVariables.at(condName);
+        conditionVariable.monitorName = mutex.getName();
+        waitQueues[mutex.getName()][condName].push_back({getProcessId(), localWait.waitClass});
+        return conditionVariable.localWaits.insert(conditionVariable.localWaits.end(), std::move(localWait));
+    }
+
+    /**
+     * Accessed by Receiving Thread - COND_NOTIFY_ONE wakes up the earliest local wait of the class of the removed queue
+     * entry, COND_NOTIFY wakes up all of them.
+     */
+    bool processNotification(const Packet& notification) {
+        std::unique_lock<std::mutex> lock(conditionVariablesMutex);
+        lookupName.assign(extractObjectName(notification.messageType, notification.message));
+        auto conditionVariable = conditionVariables.find(lookupName);
+        if (conditionVariable == conditionVariables.end()) {
+            return false;
+        }
+        std::list<LocalWait>& localWaits = conditionVariable->second.localWaits;
+        std::list<LocalWait> wokenWaits;
+        if (notification.messageType == MessageType::COND_NOTIFY_ONE) {
+            WaitClass waitClass = unpackWaitClass(notification.message);
+            auto localWait = std::find_if(localWaits.begin(), localWaits.end(), [&](const LocalWait& wait) {
+                return wait.waitClass == waitClass;
+            });
+            if (localWait != localWaits.end()) {
+                wokenWaits.splice(wokenWaits.end(), localWaits, localWait);
+            }
+        } else {
+            wokenWaits.swap(localWaits);
+        }
+        bool wakeThreads = false;
+        for (LocalWait& wait : wokenWaits) {
+            if (wait.notified != nullptr) {
+                *wait.notified = true;
+                wakeThreads = true;
+            }
+        }
+        const CondName& condName = conditionVariable->first;
+        std::condition_variable& notifiedCondition = getNotifiedCondition(condName);
+        CondName wokenName = wokenWaits.empty() ? CondName() : condName;
+        lock.unlock();
+        if (wakeThreads) {
+            notifiedCondition.notify_all();
+        }
+        for (LocalWait& wait : wokenWaits) {
+            if (wait.notified == nullptr) {
+                relockAsync(wokenName, std::move(wait));
+            }
+        }
+        return true;
+    }
+
+    /** Repeats the wait once the mutex is locked again, which calls 'onWoken' if the predicate holds **/
+    void relockAsync(const CondName& condName, LocalWait wait) {
+        Logger::log("Stopped waiting asynchronously on CV '" + condName + "'", rang::fg::magenta);
+        DistributedMutex& mutex = *wait.mutex;
+        mutex.lockAsync([this, condName, wait = std::move(wait)]() {
+            waitAsync(condName, *wait.mutex, wait.predicate, wait.waitClass, wait.onWoken);
+        });
+    }
+
+    /** Protected by conditionVariablesMutex - returns nullptr if no process waits on the CV **/
+    std::deque<Waiter>* findWaiters(const CondName& condName) {
+        const MutexName& monitorName = conditionVariables.at(condName).monitorName;
+        auto monitorQueues = waitQueues.find(monitorName);
+        if (monitorQueues == waitQueues.end()) {
+            return nullptr;
+        }
+        auto waiters = monitorQueues->second.find(condName);
+        return waiters == monitorQueues->second.end() ? nullptr : &waiters->second;
+    }
+
+    /** Protected by conditionVariablesMutex - only queues with waiters are kept **/
+    void removeIfEmpty(const CondName& condName) {
+        auto monitorQueues = waitQueues.find(conditionVariables.at(condName).monitorName);
+        auto waiters = monitorQueues->second.find(condName);
+        if (waiters->second.empty()) {
+            monitorQueues->second.erase(waiters);
+        }
+        if (monitorQueues->second.empty()) {
+            waitQueues.erase(monitorQueues);
+        }
+    }
+
+    /** Accessed by Main Thread - removes the earliest wait of this process with the class from the queue of the CV **/
+    void withdraw(const CondName& condName, WaitClass waitClass) {
+        std::lock_guard<std::mutex> guard(conditionVariablesMutex);
+        std::deque<Waiter>* waiters = findWaiters(condName);
+        if (waiters == nullptr) {
+            return;
+        }
+        auto myWait = std::find_if(waiters->begin(), waiters->end(), [&](const Waiter& waiter) {
+            return waiter.processId == getProcessId() and waiter.waitClass == waitClass;
+        });
+        if (myWait != waiters->end()) {
+            waiters->erase(myWait);
+            removeIfEmpty(condName);
+        }
+    }
+
+    /** Waiting threads share a few condition variables instead of having one per CV **/
+    std::condition_variable& getNotifiedCondition(const CondName& condName) {
+        return notifiedConditions[std::hash<CondName>()(condName) % notifiedConditions.size()];
+    }
+
+    std::unordered_map<CondName, ConditionVariable> conditionVariables;
+    /** Processes waiting on the CVs of each monitor, in the order they started waiting **/
+    std::unordered_map<MutexName, std::map<CondName, std::deque<Waiter>>> waitQueues;
+    std::mutex conditionVariablesMutex;
+    /** Reused by every lookup of a received CV name, so that it does not allocate **/
+    CondName lookupName;
+    /** Reused by every notifyAll to collect the processes to notify **/
+    ProcessSet waitingProcesses;
+    std::array<std::condition_variable, 16> notifiedConditions;
+
+    std::shared_ptr<CommunicationManager> communicationManager;
+    std::shared_ptr<DistributedMonitorRegistry> registry;
+    std::vector<SubscriptionId> notifySubscriptions;
+};
+
+#endif //DISTRIBUTEDMONITOR_MONITORSTATECONDITIONVARIABLEALGORITHM_H
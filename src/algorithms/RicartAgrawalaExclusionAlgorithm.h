@@ -3,82 +3,242 @@
 
 #include <communication/CommunicationManager.h>
 #include <util/Utils.h>
+#include <array>
 #include <condition_variable>
+#include <deque>
+#include <functional>
 #include <logging/Logger.h>
-#include <unordered_set>
-#include <sstream>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include "IDistributedExclusionAlgorithm.h"
 
+/**
+ * Ricart-Agrawala mutual exclusion algorithm.
+ *
+ * With 'retainPermissions' enabled it works as the Roucairol-Carvalho variant: an agreement received from a process
+ * stays valid until that process requests the mutex itself. Only processes whose agreements were revoked that way are
+ * asked again, so re-entering a mutex that nobody else wanted in the meantime does not require any messages. An
+ * agreement revoked while waiting for the mutex is asked for again with MUTEX_RENEWAL, which carries the timestamp of
+ * the original request, so that both processes compare the same priorities.
+ *
+ * If the communication manager has direct receive enabled, agreements are received by the thread acquiring the mutex
+ * itself instead of being passed from the receiving thread. Not used with 'retainPermissions', which relies on an
+ * agreement never being overtaken by a later request of the same process.
+ *
+ * Mutexes are kept in a table of the algorithm, which subscribes to requests and agreements once for all of them, so
+ * registering a mutex takes constant time and an idle mutex only takes its entry in the table.
+ *
+ * A timed acquisition which runs out of time sends MUTEX_CANCEL to the processes whose agreements are missing. Each of
+ * them replies with the agreement right away if it has deferred the request, so every request is answered exactly
+ * once - the agreements answering cancelled requests are counted off as they arrive and never taken for agreements to
+ * a later request. Requests deferred because of the cancelled one are agreed to at once.
+ *
+ * An asynchronous acquisition keeps its continuation in the mutex's entry and the thread which handles the last
+ * agreement runs it. Asynchronous acquisitions of a mutex this process already holds or waits for are queued locally
+ * and each of them requests the mutex again once the previous one releases it, so that remote processes are not
+ * starved. A blocking acquisition waits in the same queue and a timed one until its deadline, while an acquisition
+ * whose deadline has passed fails at once. With direct receive asynchronous acquisitions block the calling thread,
+ * since nobody would receive the agreements.
+ */
 class RicartAgrawalaExclusionAlgorithm : public IDistributedExclusionAlgorithm {
 public:
 
-    explicit RicartAgrawalaExclusionAlgorithm(std::shared_ptr<CommunicationManager> communicationManager)
-            : communicationManager(std::move(communicationManager)) {
+    explicit RicartAgrawalaExclusionAlgorithm(std::shared_ptr<CommunicationManager> communicationManager,
+                                              bool retainPermissions = false)
+            : communicationManager(std::move(communicationManager)), retainPermissions(retainPermissions) {
+        directReceive = this->communicationManager->isDirectReceiveEnabled() and not retainPermissions;
+        missingPermissions = ProcessSet(static_cast<std::size_t>(this->communicationManager->getNumberOfProcesses()));
         /** Mutex requests handling **/
-        this->communicationManager->subscribe(
-                [&](const Packet& packet) {
-                    const MutexName& mutexName = packet.message;
-                    std::lock_guard<std::mutex> guard(registeredMutexesMutex);
-                    return packet.messageType == MessageType::MUTEX_REQUEST and contains(registeredMutexes, mutexName);
-                },
-                [&](const Packet& request) {
-                    processRequest(request);
+        subscriptions.push_back(this->communicationManager->subscribe(
+                MessageType::MUTEX_REQUEST, [this](const Packet& request) {
+                    std::lock_guard<std::mutex> lock(mutexesMutex);
+                    auto mutex = findMutex(request.message);
+                    if (mutex == mutexes.end()) {
+                        return false;
+                    }
+                    processRequest(request, request.lamportTime, mutex->first, mutex->second);
+                    return true;
+                }
+        ));
+        /** Renewed mutex requests handling - requests re-sent with the timestamp of the original request **/
+        subscriptions.push_back(this->communicationManager->subscribe(
+                MessageType::MUTEX_RENEWAL, [this](const Packet& renewal) {
+                    std::lock_guard<std::mutex> lock(mutexesMutex);
+                    auto mutex = findMutex(extractName(renewal.message));
+                    if (mutex == mutexes.end()) {
+                        return false;
+                    }
+                    auto requestLamportTime = static_cast<LamportTime>(readNumber(extractData(renewal.message), 0));
+                    processRequest(renewal, requestLamportTime, mutex->first, mutex->second);
+                    return true;
+                }
+        ));
+        /** Mutex request cancellations handling **/
+        subscriptions.push_back(this->communicationManager->subscribe(
+                MessageType::MUTEX_CANCEL, [this](const Packet& cancellation) {
+                    std::lock_guard<std::mutex> lock(mutexesMutex);
+                    auto mutex = findMutex(cancellation.message);
+                    if (mutex == mutexes.end()) {
+                        return false;
+                    }
+                    /** The reply only closes the request - the permission I hold from its sender stays valid **/
+                    if (mutex->second.deferredRequests.contains(cancellation.source)) {
+                        mutex->second.deferredRequests.erase(cancellation.source);
+                        replyAgreement(mutex->first, cancellation.source);
+                    }
+                    return true;
                 }
-        );
+        ));
+        /** Mutex agreements handling **/
+        subscriptions.push_back(this->communicationManager->subscribe(
+                MessageType::MUTEX_AGREEMENT, [this](const Packet& agreement) {
+                    std::unique_lock<std::mutex> lock(mutexesMutex);
+                    auto mutex = findMutex(agreement.message);
+                    if (mutex == mutexes.end()) {
+                        return false;
+                    }
+                    std::condition_variable& allAgreementsReceived = getAgreementsCondition(mutex->first);
+                    if (processAgreement(agreement, mutex->first, mutex->second)) {
+                        std::function<void()> onAcquired = std::move(mutex->second.onAcquired);
+                        mutex->second.onAcquired = nullptr;
+                        lock.unlock();
+                        if (onAcquired) {
+                            runContinuation(std::move(onAcquired));
+                        } else {
+                            allAgreementsReceived.notify_all();
+                        }
+                    }
+                    return true;
+                }
+        ));
+    }
+
+    ~RicartAgrawalaExclusionAlgorithm() {
+        for (SubscriptionId subscription : subscriptions) {
+            communicationManager->unsubscribe(subscription);
+        }
     }
 
     void registerMutex(const MutexName& mutexName) override {
-        std::lock_guard<std::mutex> guard(registeredMutexesMutex);
-        registeredMutexes.insert(mutexName);
+        communicationManager->internName(mutexName);
+        std::lock_guard<std::mutex> guard(mutexesMutex);
+        mutexes.try_emplace(mutexName);
     }
 
     void unregisterMutex(const MutexName& mutexName) override {
-        std::lock_guard<std::mutex> guard(registeredMutexesMutex);
-        registeredMutexes.erase(mutexName);
+        std::lock_guard<std::mutex> guard(mutexesMutex);
+        mutexes.erase(mutexName);
     }
 
     /** Accessed by Main Thread **/
     void acquireMutex(const MutexName& mutexName) override {
-        std::mutex allAgreementsMutex;
-        std::condition_variable allAgreementsCondition;
-        std::unordered_set<Packet> receivedAgreements;
-
-        SubscriptionId subscriptionId = communicationManager->subscribe(
-                /** Predicate function - Accessed by Receiving Thread **/
-                [&](const Packet& packet) {
-                    return packet.messageType == MessageType::MUTEX_AGREEMENT and packet.message == mutexName;
-                },
-                /** Callback function - Accessed by Receiving Thread **/
-                [&](const Packet& agreement) {
-                    std::unique_lock<std::mutex> guard(allAgreementsMutex);
-                    addAgreement(receivedAgreements, agreement);
-                    auto remainingAgreements = communicationManager->getNumberOfProcesses() - 1 - receivedAgreements.size();
-                    Logger::log("Agreements remaining: " + std::to_string(remainingAgreements));
-                    if (areAgreementsComplete(receivedAgreements)) {
-                        guard.unlock();
-                        allAgreementsCondition.notify_one();
-                    }
-                }
-        );
-
-        queue(mutexName);
-        std::unique_lock<std::mutex> allAgreementsLock(allAgreementsMutex);
-        allAgreementsCondition.wait(allAgreementsLock, [&]() { return areAgreementsComplete(receivedAgreements); });
-        communicationManager->unsubscribe(subscriptionId);
+        std::unique_lock<std::mutex> lock(mutexesMutex);
+        PermissionMutex& mutex = mutexes.at(mutexName);
+        if (mutex.queued and not directReceive) {
+            /** Held or requested by an asynchronous acquisition - wait for my turn after it **/
+            bool acquired = false;
+            addPendingAcquisition(mutex, [&]() {
+                std::lock_guard<std::mutex> guard(mutexesMutex);
+                acquired = true;
+                getAgreementsCondition(mutexName).notify_all();
+            });
+            getAgreementsCondition(mutexName).wait(lock, [&]() { return acquired; });
+            return;
+        }
+        std::uint64_t generation = ++mutex.requestGeneration;
+        if (queue(mutexName, mutex)) {
+            Logger::log("Mutex '" + mutexName + "' acquired without sending any requests", rang::fg::blue);
+            return;
+        }
+        if (directReceive) {
+            lock.unlock();
+            communicationManager->receiveDirectly(mutexName, [&]() {
+                std::lock_guard<std::mutex> guard(mutexesMutex);
+                return mutex.enteredGeneration == generation;
+            });
+        } else {
+            getAgreementsCondition(mutexName).wait(lock, [&]() { return mutex.enteredGeneration == generation; });
+        }
         Logger::log("Mutex '" + mutexName + "' acquired", rang::fg::blue);
         // Mutex acquired - can enter critical section
     }
 
     /** Accessed by Main Thread **/
+    bool tryAcquireMutex(const MutexName& mutexName, Deadline deadline) override {
+        std::unique_lock<std::mutex> lock(mutexesMutex);
+        PermissionMutex& mutex = mutexes.at(mutexName);
+        if (mutex.queued and not directReceive) {
+            return awaitPendingAcquisition(mutexName, mutex, lock, deadline);
+        }
+        if (not arePermissionsComplete(mutex) and std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::uint64_t generation = ++mutex.requestGeneration;
+        if (queue(mutexName, mutex)) {
+            Logger::log("Mutex '" + mutexName + "' acquired without sending any requests", rang::fg::blue);
+            return true;
+        }
+        auto entered = [&]() { return mutex.enteredGeneration == generation; };
+        if (directReceive) {
+            lock.unlock();
+            communicationManager->receiveDirectly(mutexName, [&]() {
+                std::lock_guard<std::mutex> guard(mutexesMutex);
+                return entered();
+            }, deadline);
+            lock.lock();
+        } else {
+            getAgreementsCondition(mutexName).wait_until(lock, deadline, entered);
+        }
+        /** The last agreement may have arrived after the deadline, it is checked under the lock once more **/
+        if (entered()) {
+            Logger::log("Mutex '" + mutexName + "' acquired", rang::fg::blue);
+            return true;
+        }
+        cancel(mutexName, mutex);
+        Logger::log("Gave up acquiring mutex '" + mutexName + "'", rang::fg::yellow);
+        startPendingAcquisition(mutexName, mutex, lock);
+        return false;
+    }
+
+    void acquireMutexAsync(const MutexName& mutexName, std::function<void()> onAcquired) override {
+        if (directReceive) {
+            IDistributedExclusionAlgorithm::acquireMutexAsync(mutexName, std::move(onAcquired));
+            return;
+        }
+        std::unique_lock<std::mutex> lock(mutexesMutex);
+        PermissionMutex& mutex = mutexes.at(mutexName);
+        if (mutex.queued) {
+            addPendingAcquisition(mutex, std::move(onAcquired));
+            return;
+        }
+        onAcquired = queueAsync(mutexName, mutex, std::move(onAcquired));
+        lock.unlock();
+        if (onAcquired) {
+            runContinuation(std::move(onAcquired));
+        }
+    }
+
+    /** With direct receive the agreements are received by the acquiring thread, so it has to block **/
+    bool supportsAsyncAcquire() const override {
+        return not directReceive;
+    }
+
+    /** Accessed by Main Thread or by the thread running the continuation of an asynchronous acquisition **/
     void releaseMutex(const MutexName& mutexName) override {
-        std::scoped_lock lock(queuedMutexesMutex, receivedRequestsMutex);
+        std::unique_lock<std::mutex> lock(mutexesMutex);
+        PermissionMutex& mutex = mutexes.at(mutexName);
         Logger::log("Mutex '" + mutexName + "' released", rang::fg::yellow);
-        for (const Packet& request : receivedRequests[mutexName]) {
-            sendAgreement(request);
+        mutex.queued = false;
+        mutex.entered = false;
+        mutex.deferredRequests.forEach([&](ProcessId processId) {
+            sendAgreement(mutexName, mutex, processId);
+        });
+        mutex.deferredRequests.clear();
+        if (not retainPermissions) {
+            mutex.heldPermissions.clear();
         }
-
-        receivedRequests[mutexName].clear();
-        queuedMutexes.erase(mutexName);
+        startPendingAcquisition(mutexName, mutex, lock);
     }
 
     ProcessId getProcessId() override {
@@ -87,99 +247,323 @@ public:
 
 private:
 
-    /** Accessed by Receiving Thread **/
-    bool addAgreement(std::unordered_set<Packet>& receivedAgreements, const Packet& agreement) {
-        const std::string& mutexName = agreement.message;
-        std::lock_guard<std::mutex> lock(queuedMutexesMutex);
-        bool amQueuedInMutex = contains(queuedMutexes, mutexName);
-        if (amQueuedInMutex) {
-            /** If I am queued in this mutex - accept the agreement **/
-            receivedAgreements.insert(agreement);
+    /**
+     * State of a registered mutex, kept for its whole lifetime. The sets grow when the mutex is first used, so an idle
+     * mutex allocates nothing but its entry and acquiring it again allocates nothing either.
+     */
+    struct PermissionMutex {
+        /** Processes whose agreements I currently hold **/
+        ProcessSet heldPermissions;
+        /** Processes whose requests wait until I release the mutex **/
+        ProcessSet deferredRequests;
+        bool queued = false;
+        bool entered = false;
+        LamportTime requestLamportTime = 0;
+        /** Number of the current acquisition and of the last one which has entered the mutex **/
+        std::uint64_t requestGeneration = 0;
+        std::uint64_t enteredGeneration = 0;
+        /** Agreements still to come from each process in reply to cancelled requests, sized at the first cancel **/
+        std::vector<std::uint32_t> staleAgreements;
+        /** Continuation of the current acquisition if it is asynchronous **/
+        std::function<void()> onAcquired;
+        /** Acquisitions waiting until the current one releases the mutex, created for the first of them **/
+        std::unique_ptr<std::deque<std::function<void()>>> pendingAcquisitions;
+    };
+
+    /** Accessed by Main Thread - protected by mutexesMutex **/
+    static void addPendingAcquisition(PermissionMutex& mutex, std::function<void()> onAcquired) {
+        if (not mutex.pendingAcquisitions) {
+            mutex.pendingAcquisitions = std::make_unique<std::deque<std::function<void()>>>();
+        }
+        mutex.pendingAcquisitions->push_back(std::move(onAcquired));
+    }
+
+    /**
+     * Accessed by Main Thread or by the thread running the continuation of an asynchronous acquisition
+     * Starts the next pending acquisition once the mutex is neither held nor requested. Releases the lock.
+     */
+    void startPendingAcquisition(const MutexName& mutexName, PermissionMutex& mutex,
+                                 std::unique_lock<std::mutex>& lock) {
+        if (not mutex.pendingAcquisitions or mutex.pendingAcquisitions->empty()) {
+            lock.unlock();
+            return;
+        }
+        std::function<void()> onAcquired = std::move(mutex.pendingAcquisitions->front());
+        mutex.pendingAcquisitions->pop_front();
+        onAcquired = queueAsync(mutexName, mutex, std::move(onAcquired));
+        lock.unlock();
+        if (onAcquired) {
+            runContinuation(std::move(onAcquired));
+        }
+    }
+
+    /**
+     * Accessed by Main Thread - protected by mutexesMutex
+     * Waits for the turn after the acquisitions which hold or requested the mutex, failing right away if the deadline
+     * has passed. A turn which comes after the deadline releases the mutex at once.
+     */
+    bool awaitPendingAcquisition(const MutexName& mutexName, PermissionMutex& mutex,
+                                 std::unique_lock<std::mutex>& lock, Deadline deadline) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        struct Turn {
+            bool acquired = false;
+            bool abandoned = false;
+        };
+        auto turn = std::make_shared<Turn>();
+        addPendingAcquisition(mutex, [this, mutexName, turn]() {
+            std::unique_lock<std::mutex> guard(mutexesMutex);
+            if (turn->abandoned) {
+                guard.unlock();
+                releaseMutex(mutexName);
+                return;
+            }
+            turn->acquired = true;
+            getAgreementsCondition(mutexName).notify_all();
+        });
+        if (getAgreementsCondition(mutexName).wait_until(lock, deadline, [&]() { return turn->acquired; })) {
             return true;
-        } else {
+        }
+        turn->abandoned = true;
+        Logger::log("Gave up waiting for mutex '" + mutexName + "' after the local acquisitions", rang::fg::yellow);
+        return false;
+    }
+
+    /**
+     * Accessed by Receiving Thread - protected by mutexesMutex
+     * Once the last missing agreement arrives the mutex is considered entered right away, so that any request received
+     * afterwards is deferred until the mutex is released. Returns true if it has just been entered.
+     */
+    bool processAgreement(const Packet& agreement, const MutexName& mutexName, PermissionMutex& mutex) {
+        auto source = static_cast<std::size_t>(agreement.source);
+        if (source < mutex.staleAgreements.size() and mutex.staleAgreements[source] > 0) {
+            /** Agreements arrive in the order of the requests, this one answers a cancelled request **/
+            --mutex.staleAgreements[source];
+            return false;
+        }
+        if (not mutex.queued) {
             /** I did not queue in this mutex. It should not happen. **/
             Logger::log("Received agreement from Process " + std::to_string(agreement.source) + " concerning mutex " +
                         mutexName + " which I did not intend to acquire");
             throw std::runtime_error("Received agreement on acquiring mutex I was not interested in acquiring");
         }
+        mutex.heldPermissions.insert(agreement.source);
+        if (Logger::isEnabled()) {
+            auto remainingAgreements = communicationManager->getNumberOfProcesses() - 1 - mutex.heldPermissions.size();
+            Logger::log("Agreements remaining: " + std::to_string(remainingAgreements));
+        }
+        if (not arePermissionsComplete(mutex)) {
+            return false;
+        }
+        mutex.entered = true;
+        mutex.enteredGeneration = mutex.requestGeneration;
+        return true;
+    }
+
+    /**
+     * Accessed by Main Thread - protected by mutexesMutex
+     * Requests the mutex from every process whose agreement is not held. Returns true if there was no one to ask.
+     */
+    bool queue(const MutexName& mutexName, PermissionMutex& mutex) {
+        mutex.queued = true;
+        if (arePermissionsComplete(mutex)) {
+            mutex.requestLamportTime = communicationManager->getCurrentLamportTime();
+            mutex.entered = true;
+            mutex.enteredGeneration = mutex.requestGeneration;
+            return true;
+        }
+        Packet packet;
+        if (mutex.heldPermissions.empty()) {
+            packet = communicationManager->sendOthers(MessageType::MUTEX_REQUEST, mutexName);
+        } else {
+            missingPermissions.clear();
+            for (ProcessId processId = 0; processId < communicationManager->getNumberOfProcesses(); ++processId) {
+                if (processId != getProcessId() and not mutex.heldPermissions.contains(processId)) {
+                    missingPermissions.insert(processId);
+                }
+            }
+            packet = communicationManager->send(MessageType::MUTEX_REQUEST, mutexName, missingPermissions);
+        }
+        mutex.requestLamportTime = packet.lamportTime;
+        return false;
+    }
+
+    /**
+     * Accessed by Main Thread - protected by mutexesMutex
+     * Withdraws the request of an acquisition which has run out of time. Agreements held are treated as on release.
+     */
+    void cancel(const MutexName& mutexName, PermissionMutex& mutex) {
+        mutex.queued = false;
+        mutex.staleAgreements.resize(static_cast<std::size_t>(communicationManager->getNumberOfProcesses()), 0);
+        missingPermissions.clear();
+        for (ProcessId processId = 0; processId < communicationManager->getNumberOfProcesses(); ++processId) {
+            if (processId != getProcessId() and not mutex.heldPermissions.contains(processId)) {
+                missingPermissions.insert(processId);
+                ++mutex.staleAgreements[static_cast<std::size_t>(processId)];
+            }
+        }
+        communicationManager->send(MessageType::MUTEX_CANCEL, mutexName, missingPermissions);
+        mutex.deferredRequests.forEach([&](ProcessId processId) {
+            sendAgreement(mutexName, mutex, processId);
+        });
+        mutex.deferredRequests.clear();
+        if (not retainPermissions) {
+            mutex.heldPermissions.clear();
+        }
     }
 
-    /** Accessed by Main Thread */
-    void queue(const MutexName& mutexName) {
-        std::lock_guard<std::mutex> lock(queuedMutexesMutex);
-        Packet packet = communicationManager->sendOthers(MessageType::MUTEX_REQUEST, mutexName);
-        queuedMutexes[mutexName] = packet.lamportTime;
+    /**
+     * Protected by mutexesMutex
+     * Starts an asynchronous acquisition. Returns its continuation if the mutex has been entered right away.
+     */
+    std::function<void()> queueAsync(const MutexName& mutexName, PermissionMutex& mutex,
+                                     std::function<void()> onAcquired) {
+        ++mutex.requestGeneration;
+        if (queue(mutexName, mutex)) {
+            Logger::log("Mutex '" + mutexName + "' acquired without sending any requests", rang::fg::blue);
+            return onAcquired;
+        }
+        mutex.onAcquired = std::move(onAcquired);
+        return nullptr;
     }
 
-    /** Accessed by Receiving Thread */
-    void processRequest(const Packet& request) {
-        const MutexName& mutexName = request.message;
-        std::scoped_lock lock(queuedMutexesMutex, receivedRequestsMutex);
-        if (canSendAgreement(request)) {
-            sendAgreement(request);
+    /**
+     * Continuations releasing the mutex may start the next acquisition, whose continuation would run inside the
+     * previous one. They are run one after another by the outermost call instead, so that the stack does not grow.
+     */
+    static void runContinuation(std::function<void()> onAcquired) {
+        static thread_local std::deque<std::function<void()>>* runningContinuations = nullptr;
+        if (runningContinuations != nullptr) {
+            runningContinuations->push_back(std::move(onAcquired));
+            return;
+        }
+        std::deque<std::function<void()>> continuations;
+        continuations.push_back(std::move(onAcquired));
+        runningContinuations = &continuations;
+        while (not continuations.empty()) {
+            std::function<void()> continuation = std::move(continuations.front());
+            continuations.pop_front();
+            continuation();
+        }
+        runningContinuations = nullptr;
+    }
+
+    /** Accessed by Receiving Thread - protected by mutexesMutex **/
+    void processRequest(const Packet& request, LamportTime requestLamportTime, const MutexName& mutexName,
+                        PermissionMutex& mutex) {
+        if (canSendAgreement(request, requestLamportTime, mutexName, mutex)) {
+            sendAgreement(mutexName, mutex, request.source);
         } else {
-            receivedRequests[mutexName].insert(request);
+            mutex.deferredRequests.insert(request.source);
         }
     }
 
-    /** Accessed by Receiving Thread */
-    bool canSendAgreement(const Packet& request) {
-        std::stringstream acceptanceLoggerMessage;
-        const MutexName& mutexName = request.message;
-        acceptanceLoggerMessage << "Allowing process " << std::to_string(request.source) << " to acquire mutex " <<
-                                   request.message << " because ";
+    /**
+     * Accessed by Receiving Thread - protected by mutexesMutex
+     * Log messages are built only when logging is enabled, so that handling a request does not allocate.
+     */
+    bool canSendAgreement(const Packet& request, LamportTime requestLamportTime, const MutexName& mutexName,
+                          const PermissionMutex& mutex) {
+        /** I'm in the critical section - the request has to wait until I release the mutex **/
+        if (mutex.entered) {
+            if (Logger::isEnabled()) {
+                Logger::log("Delaying the agreement to process " + std::to_string(request.source) +
+                            " until I release the mutex");
+            }
+            return false;
+        }
 
-        auto queuedMutexPtr = queuedMutexes.find(mutexName);
-        auto queuedMutexEnd = queuedMutexes.end();
         /** I'm not interested in acquiring the mutex **/
-        if (queuedMutexPtr == queuedMutexEnd) {
-            acceptanceLoggerMessage << "I am not interested";
-            Logger::log(acceptanceLoggerMessage.str());
+        if (not mutex.queued) {
+            if (Logger::isEnabled()) {
+                logAgreement(request, mutexName, "I am not interested");
+            }
             return true;
         }
 
         /** Request's logical clock is lower than my logical clock' **/
-        LamportTime myRequestLamportTime = (*queuedMutexPtr).second;
-        if (request.lamportTime < myRequestLamportTime) {
-            acceptanceLoggerMessage << "incoming request has lower TS " <<
-                                    "(" << request.lamportTime << " vs " << myRequestLamportTime << ")";
-            Logger::log(acceptanceLoggerMessage.str());
+        LamportTime myRequestLamportTime = mutex.requestLamportTime;
+        if (requestLamportTime < myRequestLamportTime) {
+            if (Logger::isEnabled()) {
+                logAgreement(request, mutexName, "incoming request has lower TS (" +
+                                                 std::to_string(requestLamportTime) + " vs " +
+                                                 std::to_string(myRequestLamportTime) + ")");
+            }
             return true;
         }
 
         /** Request's logical clock is the same as the my logical clock and I have the higher process ID **/
-        if ((request.lamportTime == myRequestLamportTime) and (request.source < communicationManager->getProcessId())) {
-            acceptanceLoggerMessage << "sender has lower ID";
-            Logger::log(acceptanceLoggerMessage.str());
+        if ((requestLamportTime == myRequestLamportTime) and (request.source < communicationManager->getProcessId())) {
+            if (Logger::isEnabled()) {
+                logAgreement(request, mutexName, "sender has lower ID");
+            }
             return true;
         }
 
-        Logger::log("Delaying the agreement to process " + std::to_string(request.source));
+        if (Logger::isEnabled()) {
+            Logger::log("Delaying the agreement to process " + std::to_string(request.source));
+        }
         return false;
     }
 
-    /** Accessed by Main and Receiving threads **/
-    void sendAgreement(const Packet& request) {
-        ProcessId processId = request.source;
-        const MutexName& mutexName = request.message;
-        communicationManager->send(MessageType::MUTEX_AGREEMENT, mutexName, processId);
+    static void logAgreement(const Packet& request, const MutexName& mutexName, const std::string& reason) {
+        Logger::log("Allowing process " + std::to_string(request.source) + " to acquire mutex " + mutexName +
+                    " because " + reason);
     }
 
-    /** Accessed by Main and Receiving thread - protected by allAgreementsMutex **/
-    bool areAgreementsComplete(const std::unordered_set<Packet>& receivedAgreements) {
-        return receivedAgreements.size() == static_cast<std::size_t>(communicationManager->getNumberOfProcesses()) - 1;
+    /** Accessed by Main and Receiving threads - protected by mutexesMutex **/
+    void sendAgreement(const MutexName& mutexName, PermissionMutex& mutex, ProcessId processId) {
+        bool permissionRevoked = mutex.heldPermissions.contains(processId);
+        mutex.heldPermissions.erase(processId);
+        replyAgreement(mutexName, processId);
+        if (permissionRevoked and mutex.queued) {
+            /** I gave away an agreement I was counting on while still waiting - I need to ask for it again **/
+            std::string requestLamportTime;
+            appendNumber(requestLamportTime, mutex.requestLamportTime);
+            communicationManager->send(MessageType::MUTEX_RENEWAL, packNamedMessage(mutexName, requestLamportTime),
+                                       processId);
+        }
     }
 
-    std::unordered_set<MutexName> registeredMutexes;
-    std::map<MutexName, LamportTime> queuedMutexes;
-    std::map<MutexName, std::unordered_set<Packet>> receivedRequests;
+    /** Accessed by Main and Receiving threads - protected by mutexesMutex **/
+    void replyAgreement(const MutexName& mutexName, ProcessId processId) {
+        if (directReceive) {
+            communicationManager->sendDirectly(MessageType::MUTEX_AGREEMENT, mutexName, processId);
+        } else {
+            communicationManager->send(MessageType::MUTEX_AGREEMENT, mutexName, processId);
+        }
+    }
 
-    std::mutex registeredMutexesMutex;
-    std::mutex receivedRequestsMutex;
-    std::mutex queuedMutexesMutex;
+    /** Accessed by Main and Receiving threads - protected by mutexesMutex **/
+    bool arePermissionsComplete(const PermissionMutex& mutex) {
+        return mutex.heldPermissions.size() ==
+               static_cast<std::size_t>(communicationManager->getNumberOfProcesses()) - 1;
+    }
 
-    std::shared_ptr<CommunicationManager> communicationManager;
+    /** Accessed by Receiving Thread - protected by mutexesMutex **/
+    std::unordered_map<MutexName, PermissionMutex>::iterator findMutex(std::string_view mutexName) {
+        lookupName.assign(mutexName);
+        return mutexes.find(lookupName);
+    }
+
+    /** Threads waiting for agreements share a few condition variables instead of having one per mutex **/
+    std::condition_variable& getAgreementsCondition(const MutexName& mutexName) {
+        return agreementsConditions[std::hash<MutexName>()(mutexName) % agreementsConditions.size()];
+    }
 
+    std::unordered_map<MutexName, PermissionMutex> mutexes;
+    std::mutex mutexesMutex;
+    /** Reused by every lookup of a received mutex name, so that it does not allocate **/
+    MutexName lookupName;
+    /** Reused by every request sent to a part of the processes **/
+    ProcessSet missingPermissions;
+    std::array<std::condition_variable, 16> agreementsConditions;
+    std::vector<SubscriptionId> subscriptions;
+
+    std::shared_ptr<CommunicationManager> communicationManager;
+    bool retainPermissions;
+    bool directReceive;
 };
 
 #endif //DISTRIBUTEDMONITOR_RICARTAGRAWALAEXCLUSIONALGORITHM_H
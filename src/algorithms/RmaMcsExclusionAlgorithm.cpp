@@ -0,0 +1,160 @@
+#include <thread>
+#include <logging/Logger.h>
+#include "RmaMcsExclusionAlgorithm.h"
+
+RmaMcsExclusionAlgorithm::RmaMcsExclusionAlgorithm(std::shared_ptr<CommunicationManager> communicationManager)
+        : communicationManager(std::move(communicationManager)) { }
+
+void RmaMcsExclusionAlgorithm::registerMutex(const MutexName& mutexName) {
+    auto numberOfProcesses = communicationManager->getNumberOfProcesses();
+    auto slots = SENT_PACKETS + numberOfProcesses;
+    auto mutex = std::make_unique<RmaMutex>(RmaMutex {
+            .window = MPI_WIN_NULL,
+            .home = static_cast<ProcessId>(std::hash<MutexName>()(mutexName) % numberOfProcesses),
+            .sentPackets = std::vector<Slot>(static_cast<std::size_t>(numberOfProcesses))
+    });
+    Slot* base;
+    MPI_Win_allocate(slots * sizeof(Slot), sizeof(Slot), MPI_INFO_NULL, MPI_COMM_WORLD, &base, &mutex->window);
+    base[TAIL] = NO_PROCESS;
+    base[LAST_OWNER] = NO_PROCESS;
+    base[NEXT] = NO_PROCESS;
+    base[BLOCKED] = 0;
+    std::fill(base + SENT_PACKETS, base + slots, 0);
+    /** Nobody may touch the window before every process has initialized its part **/
+    MPI_Barrier(MPI_COMM_WORLD);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, mutex->window);
+
+    std::lock_guard<std::mutex> lock(mutexesMutex);
+    mutexes[mutexName] = std::move(mutex);
+}
+
+void RmaMcsExclusionAlgorithm::unregisterMutex(const MutexName& mutexName) {
+    std::unique_ptr<RmaMutex> mutex;
+    {
+        std::lock_guard<std::mutex> lock(mutexesMutex);
+        auto registered = mutexes.find(mutexName);
+        mutex = std::move(registered->second);
+        mutexes.erase(registered);
+    }
+    MPI_Win_unlock_all(mutex->window);
+    MPI_Win_free(&mutex->window);
+}
+
+void RmaMcsExclusionAlgorithm::acquireMutex(const MutexName& mutexName) {
+    const RmaMutex& mutex = getMutex(mutexName);
+    const Slot myProcessId = getProcessId();
+
+    atomicWrite(mutex.window, myProcessId, NEXT, NO_PROCESS);
+    atomicWrite(mutex.window, myProcessId, BLOCKED, 1);
+    Slot predecessor = atomicSwap(mutex.window, mutex.home, TAIL, myProcessId);
+    if (predecessor != NO_PROCESS) {
+        /** Enqueue behind the predecessor and spin on my own slot until it hands the lock off **/
+        atomicWrite(mutex.window, predecessor, NEXT, myProcessId);
+        while (atomicRead(mutex.window, myProcessId, BLOCKED) != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    awaitPreviousOwner(mutexName, mutex);
+    Logger::log("Mutex '" + mutexName + "' acquired", rang::fg::blue);
+}
+
+bool RmaMcsExclusionAlgorithm::tryAcquireMutex(const MutexName& mutexName, Deadline deadline) {
+    const RmaMutex& mutex = getMutex(mutexName);
+    const Slot myProcessId = getProcessId();
+
+    /** Become the tail only if there is none - nobody holds the lock or waits for it then **/
+    atomicWrite(mutex.window, myProcessId, NEXT, NO_PROCESS);
+    while (compareAndSwap(mutex.window, mutex.home, TAIL, NO_PROCESS, myProcessId) != NO_PROCESS) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            Logger::log("Gave up acquiring mutex '" + mutexName + "'", rang::fg::yellow);
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    awaitPreviousOwner(mutexName, mutex);
+    Logger::log("Mutex '" + mutexName + "' acquired", rang::fg::blue);
+    return true;
+}
+
+void RmaMcsExclusionAlgorithm::awaitPreviousOwner(const MutexName& mutexName, const RmaMutex& mutex) {
+    const Slot myProcessId = getProcessId();
+    /** Make sure everything the previous owner has sent to me (e.g. SYNC) has been processed **/
+    Slot lastOwner = atomicRead(mutex.window, mutex.home, LAST_OWNER);
+    if (lastOwner != NO_PROCESS and lastOwner != myProcessId) {
+        Slot sentPackets = atomicRead(mutex.window, lastOwner, SENT_PACKETS + myProcessId);
+        communicationManager->awaitDispatchedPackets(lastOwner, sentPackets,
+                                                     communicationManager->getChannel(mutexName));
+    }
+}
+
+void RmaMcsExclusionAlgorithm::releaseMutex(const MutexName& mutexName) {
+    RmaMutex& mutex = getMutex(mutexName);
+    const Slot myProcessId = getProcessId();
+
+    publishSentPackets(mutex, communicationManager->getChannel(mutexName));
+    atomicWrite(mutex.window, mutex.home, LAST_OWNER, myProcessId);
+
+    Slot successor = atomicRead(mutex.window, myProcessId, NEXT);
+    if (successor == NO_PROCESS) {
+        /** Nobody is queued behind me as long as I am still the tail **/
+        if (compareAndSwap(mutex.window, mutex.home, TAIL, myProcessId, NO_PROCESS) == myProcessId) {
+            Logger::log("Mutex '" + mutexName + "' released", rang::fg::yellow);
+            return;
+        }
+        /** Someone has just swapped the tail but has not linked itself yet **/
+        while ((successor = atomicRead(mutex.window, myProcessId, NEXT)) == NO_PROCESS) {
+            std::this_thread::yield();
+        }
+    }
+    atomicWrite(mutex.window, successor, BLOCKED, 0);
+    Logger::log("Mutex '" + mutexName + "' released and handed off to process " + std::to_string(successor),
+                rang::fg::yellow);
+}
+
+ProcessId RmaMcsExclusionAlgorithm::getProcessId() {
+    return communicationManager->getProcessId();
+}
+
+RmaMcsExclusionAlgorithm::RmaMutex& RmaMcsExclusionAlgorithm::getMutex(const MutexName& mutexName) {
+    std::lock_guard<std::mutex> lock(mutexesMutex);
+    return *mutexes.at(mutexName);
+}
+
+RmaMcsExclusionAlgorithm::Slot RmaMcsExclusionAlgorithm::atomicRead(MPI_Win window, ProcessId target, MPI_Aint slot) {
+    Slot result;
+    MPI_Fetch_and_op(nullptr, &result, slotDatatype(), target, slot, MPI_NO_OP, window);
+    MPI_Win_flush(target, window);
+    return result;
+}
+
+void RmaMcsExclusionAlgorithm::atomicWrite(MPI_Win window, ProcessId target, MPI_Aint slot, Slot value) {
+    MPI_Accumulate(&value, 1, slotDatatype(), target, slot, 1, slotDatatype(), MPI_REPLACE, window);
+    MPI_Win_flush(target, window);
+}
+
+RmaMcsExclusionAlgorithm::Slot RmaMcsExclusionAlgorithm::atomicSwap(MPI_Win window, ProcessId target, MPI_Aint slot,
+                                                                    Slot value) {
+    Slot result;
+    MPI_Fetch_and_op(&value, &result, slotDatatype(), target, slot, MPI_REPLACE, window);
+    MPI_Win_flush(target, window);
+    return result;
+}
+
+RmaMcsExclusionAlgorithm::Slot RmaMcsExclusionAlgorithm::compareAndSwap(MPI_Win window, ProcessId target,
+                                                                        MPI_Aint slot, Slot expected, Slot value) {
+    Slot result;
+    MPI_Compare_and_swap(&value, &expected, &result, slotDatatype(), target, slot, window);
+    MPI_Win_flush(target, window);
+    return result;
+}
+
+void RmaMcsExclusionAlgorithm::publishSentPackets(RmaMutex& mutex, std::size_t channel) {
+    auto numberOfProcesses = communicationManager->getNumberOfProcesses();
+    for (ProcessId processId = 0; processId < numberOfProcesses; ++processId) {
+        mutex.sentPackets[processId] = static_cast<Slot>(communicationManager->getSentPacketsCount(processId, channel));
+    }
+    MPI_Accumulate(mutex.sentPackets.data(), numberOfProcesses, slotDatatype(), getProcessId(), SENT_PACKETS,
+                   numberOfProcesses, slotDatatype(), MPI_REPLACE, mutex.window);
+    MPI_Win_flush(getProcessId(), mutex.window);
+}
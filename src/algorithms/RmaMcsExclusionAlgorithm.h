@@ -0,0 +1,99 @@
+#ifndef DISTRIBUTEDMONITOR_RMAMCSEXCLUSIONALGORITHM_H
+#define DISTRIBUTEDMONITOR_RMAMCSEXCLUSIONALGORITHM_H
+
+#include <mpi.h>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include <communication/CommunicationManager.h>
+#include "IDistributedExclusionAlgorithm.h"
+
+/**
+ * MCS queue lock built on MPI one-sided atomics.
+ *
+ * Every mutex is backed by its own MPI window. The queue tail lives on the mutex's home process (chosen by hashing the
+ * mutex name). Each waiter spins on a slot in its own part of the window and the releasing process hands the lock off
+ * with a single remote write, so the receiving threads of other processes take no part in passing the lock.
+ *
+ * Because the lock does not travel through CommunicationManager, the FIFO ordering between the SYNC message and the
+ * lock handoff no longer comes for free. The owner therefore publishes how many packets it has sent to every process
+ * and the next owner waits until it has dispatched that many packets from the previous owner before entering.
+ *
+ * Windows are created and freed collectively over MPI_COMM_WORLD - every process has to register and unregister
+ * mutexes in the same order. It requires an MPI_Init_thread'ed communicator such as MpiSimpleCommunicator.
+ */
+class RmaMcsExclusionAlgorithm : public IDistributedExclusionAlgorithm {
+public:
+
+    explicit RmaMcsExclusionAlgorithm(std::shared_ptr<CommunicationManager> communicationManager);
+
+    /** Collective - creates the MPI window for the mutex **/
+    void registerMutex(const MutexName& mutexName) override;
+
+    /** Collective - frees the MPI window of the mutex **/
+    void unregisterMutex(const MutexName& mutexName) override;
+
+    void acquireMutex(const MutexName& mutexName) override;
+
+    /**
+     * Succeeds only if nobody holds or waits for the mutex. Until the deadline it keeps trying without joining the
+     * queue, since a waiter cannot leave it once its predecessor may hand the mutex off to it - so it may keep losing
+     * to the queued waiters.
+     */
+    bool tryAcquireMutex(const MutexName& mutexName, Deadline deadline) override;
+
+    void releaseMutex(const MutexName& mutexName) override;
+
+    ProcessId getProcessId() override;
+
+private:
+
+    using Slot = std::int64_t;
+
+    /** MPI datatype of a Slot **/
+    static MPI_Datatype slotDatatype() {
+        static_assert(std::is_same_v<Slot, std::int64_t>, "The MPI datatype has to match the Slot");
+        return MPI_INT64_T;
+    }
+
+    static constexpr Slot NO_PROCESS = -1;
+
+    /** Window layout. TAIL and LAST_OWNER are meaningful only on the home process **/
+    enum SlotIndex : MPI_Aint {
+        TAIL, LAST_OWNER, NEXT, BLOCKED, SENT_PACKETS
+    };
+
+    struct RmaMutex {
+        MPI_Win window;
+        ProcessId home;
+        /** Accessed by the owner - the counts published on release, kept so that releasing does not allocate **/
+        std::vector<Slot> sentPackets;
+    };
+
+    /**
+     * The entry stays in place until the mutex is unregistered, which happens only once no thread uses it, so it can
+     * be used after mutexesMutex is released
+     */
+    RmaMutex& getMutex(const MutexName& mutexName);
+
+    /** Waits until everything the previous owner has sent to this process before releasing the mutex is dispatched **/
+    void awaitPreviousOwner(const MutexName& mutexName, const RmaMutex& mutex);
+
+    Slot atomicRead(MPI_Win window, ProcessId target, MPI_Aint slot);
+
+    void atomicWrite(MPI_Win window, ProcessId target, MPI_Aint slot, Slot value);
+
+    Slot atomicSwap(MPI_Win window, ProcessId target, MPI_Aint slot, Slot value);
+
+    Slot compareAndSwap(MPI_Win window, ProcessId target, MPI_Aint slot, Slot expected, Slot value);
+
+    /** Writes the number of packets sent to every process into my part of the window **/
+    void publishSentPackets(RmaMutex& mutex, std::size_t channel);
+
+    std::map<MutexName, std::unique_ptr<RmaMutex>> mutexes;
+    std::mutex mutexesMutex;
+
+    std::shared_ptr<CommunicationManager> communicationManager;
+};
+
+#endif //DISTRIBUTEDMONITOR_RMAMCSEXCLUSIONALGORITHM_H
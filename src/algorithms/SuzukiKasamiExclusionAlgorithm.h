@@ -0,0 +1,242 @@
+#ifndef DISTRIBUTEDMONITOR_SUZUKIKASAMIEXCLUSIONALGORITHM_H
+#define DISTRIBUTEDMONITOR_SUZUKIKASAMIEXCLUSIONALGORITHM_H
+
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <communication/CommunicationManager.h>
+#include <logging/Logger.h>
+#include <util/MessagePacking.h>
+#include <util/Utils.h>
+#include "IDistributedExclusionAlgorithm.h"
+
+/**
+ * Suzuki-Kasami token based mutual exclusion algorithm.
+ *
+ * Each mutex has a single token, initially held by the process chosen by hashing the mutex name. A process which
+ * wants to enter broadcasts a request with its sequence number and enters once the token arrives. The token carries
+ * the sequence numbers of the last granted requests and the queue of waiting processes, so a releasing process knows
+ * whom to pass it to. The token holder can re-enter the mutex without sending any messages, so try_lock() succeeds
+ * only there.
+ *
+ * A request cannot be withdrawn once other processes have received it, so a timed acquisition which runs out of time
+ * abandons it instead - the token is passed on (or kept idle) as soon as it arrives, unless the mutex is requested
+ * again in the meantime, which takes over the outstanding request instead of sending another one.
+ */
+class SuzukiKasamiExclusionAlgorithm : public IDistributedExclusionAlgorithm {
+public:
+
+    explicit SuzukiKasamiExclusionAlgorithm(std::shared_ptr<CommunicationManager> communicationManager)
+            : communicationManager(std::move(communicationManager)) { }
+
+    void registerMutex(const MutexName& mutexName) override {
+        std::lock_guard<std::mutex> guard(mutexesMutex);
+        auto numberOfProcesses = static_cast<std::size_t>(communicationManager->getNumberOfProcesses());
+        auto [mutexIterator, inserted] = mutexes.try_emplace(mutexName, numberOfProcesses);
+        if (not inserted) {
+            return;
+        }
+        TokenMutex& mutex = mutexIterator->second;
+        mutex.hasToken = getInitialTokenHolder(mutexName) == communicationManager->getProcessId();
+        /** Token requests handling **/
+        mutex.subscriptions.push_back(communicationManager->subscribe(
+                MessageType::TOKEN_REQUEST, mutexName, [this, &mutex](const Packet& request) {
+                    processRequest(request, mutex);
+                }
+        ));
+        /** Token handling **/
+        mutex.subscriptions.push_back(communicationManager->subscribe(
+                MessageType::TOKEN, mutexName, [this, &mutex](const Packet& token) {
+                    processToken(token, mutex);
+                }
+        ));
+    }
+
+    void unregisterMutex(const MutexName& mutexName) override {
+        std::vector<SubscriptionId> subscriptions;
+        {
+            std::lock_guard<std::mutex> guard(mutexesMutex);
+            auto mutex = mutexes.find(mutexName);
+            if (mutex == mutexes.end()) {
+                return;
+            }
+            subscriptions = mutex->second.subscriptions;
+        }
+        for (SubscriptionId subscription : subscriptions) {
+            communicationManager->unsubscribe(subscription);
+        }
+        std::lock_guard<std::mutex> guard(mutexesMutex);
+        mutexes.erase(mutexName);
+    }
+
+    /** Accessed by Main Thread **/
+    void acquireMutex(const MutexName& mutexName) override {
+        std::unique_lock<std::mutex> lock(mutexesMutex);
+        TokenMutex& mutex = mutexes.at(mutexName);
+        if (mutex.hasToken) {
+            mutex.inCriticalSection = true;
+            Logger::log("Mutex '" + mutexName + "' acquired with the token I already held", rang::fg::blue);
+            return;
+        }
+        requestToken(mutexName, mutex);
+        mutex.tokenArrived.wait(lock, [&]() { return mutex.hasToken; });
+        Logger::log("Mutex '" + mutexName + "' acquired", rang::fg::blue);
+        // Mutex acquired - can enter critical section
+    }
+
+    /** Accessed by Main Thread **/
+    bool tryAcquireMutex(const MutexName& mutexName, Deadline deadline) override {
+        std::unique_lock<std::mutex> lock(mutexesMutex);
+        TokenMutex& mutex = mutexes.at(mutexName);
+        if (mutex.hasToken) {
+            mutex.inCriticalSection = true;
+            Logger::log("Mutex '" + mutexName + "' acquired with the token I already held", rang::fg::blue);
+            return true;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        requestToken(mutexName, mutex);
+        if (not mutex.tokenArrived.wait_until(lock, deadline, [&]() { return mutex.hasToken; })) {
+            Logger::log("Gave up acquiring mutex '" + mutexName + "'", rang::fg::yellow);
+            mutex.requestAbandoned = true;
+            return false;
+        }
+        Logger::log("Mutex '" + mutexName + "' acquired", rang::fg::blue);
+        return true;
+    }
+
+    /** Accessed by Main Thread **/
+    void releaseMutex(const MutexName& mutexName) override {
+        std::lock_guard<std::mutex> lock(mutexesMutex);
+        Logger::log("Mutex '" + mutexName + "' released", rang::fg::yellow);
+        passToken(mutexName, mutexes.at(mutexName));
+    }
+
+    ProcessId getProcessId() override {
+        return communicationManager->getProcessId();
+    }
+
+private:
+
+    struct TokenMutex {
+        explicit TokenMutex(std::size_t numberOfProcesses)
+                : requestNumbers(numberOfProcesses, 0), lastGrantedRequests(numberOfProcesses, 0) { }
+
+        /** Highest request number received from each process **/
+        std::vector<std::uint64_t> requestNumbers;
+        /** Part of the token - the number of the last granted request of each process **/
+        std::vector<std::uint64_t> lastGrantedRequests;
+        /** Part of the token - processes waiting for it **/
+        std::deque<ProcessId> queue;
+        bool hasToken = false;
+        bool inCriticalSection = false;
+        /** The request of this process timed out - the token is passed on as soon as it arrives **/
+        bool requestAbandoned = false;
+        std::condition_variable tokenArrived;
+        std::vector<SubscriptionId> subscriptions;
+    };
+
+    /** Accessed by Main Thread - protected by mutexesMutex. Takes over an abandoned request if there is one. **/
+    void requestToken(const MutexName& mutexName, TokenMutex& mutex) {
+        if (mutex.requestAbandoned) {
+            mutex.requestAbandoned = false;
+            return;
+        }
+        std::string request;
+        appendNumber(request, ++mutex.requestNumbers[communicationManager->getProcessId()]);
+        communicationManager->sendOthers(MessageType::TOKEN_REQUEST, packNamedMessage(mutexName, request));
+    }
+
+    /**
+     * Accessed by Main and Receiving threads - protected by mutexesMutex. Leaves the critical section and passes the
+     * token to the next waiting process, if any.
+     */
+    void passToken(const MutexName& mutexName, TokenMutex& mutex) {
+        ProcessId myProcessId = communicationManager->getProcessId();
+        mutex.inCriticalSection = false;
+        mutex.lastGrantedRequests[myProcessId] = mutex.requestNumbers[myProcessId];
+        for (ProcessId processId = 0; processId < communicationManager->getNumberOfProcesses(); ++processId) {
+            if (isWaiting(mutex, processId) and
+                std::find(mutex.queue.begin(), mutex.queue.end(), processId) == mutex.queue.end()) {
+                mutex.queue.push_back(processId);
+            }
+        }
+        if (not mutex.queue.empty()) {
+            ProcessId nextProcessId = mutex.queue.front();
+            mutex.queue.pop_front();
+            sendToken(mutexName, mutex, nextProcessId);
+        }
+    }
+
+    /** Accessed by Receiving Thread **/
+    void processRequest(const Packet& request, TokenMutex& mutex) {
+        MutexName mutexName(extractName(request.message));
+        std::uint64_t requestNumber = readNumber(extractData(request.message), 0);
+        std::lock_guard<std::mutex> lock(mutexesMutex);
+        mutex.requestNumbers[request.source] = std::max(mutex.requestNumbers[request.source], requestNumber);
+        if (mutex.hasToken and not mutex.inCriticalSection and isWaiting(mutex, request.source)) {
+            sendToken(mutexName, mutex, request.source);
+        }
+    }
+
+    /**
+     * Accessed by Receiving Thread
+     * The mutex is considered entered right away, so that any request received before the main thread wakes up
+     * does not take the token away. The token of an abandoned request is passed on right away instead.
+     */
+    void processToken(const Packet& token, TokenMutex& mutex) {
+        std::string_view data = extractData(token.message);
+        {
+            std::lock_guard<std::mutex> lock(mutexesMutex);
+            std::size_t numberOfProcesses = mutex.lastGrantedRequests.size();
+            for (std::size_t i = 0; i < numberOfProcesses; ++i) {
+                mutex.lastGrantedRequests[i] = readNumber(data, i);
+            }
+            mutex.queue.clear();
+            for (std::size_t i = numberOfProcesses; i < countNumbers(data); ++i) {
+                mutex.queue.push_back(static_cast<ProcessId>(readNumber(data, i)));
+            }
+            mutex.hasToken = true;
+            mutex.inCriticalSection = true;
+            if (mutex.requestAbandoned) {
+                MutexName mutexName(extractName(token.message));
+                mutex.requestAbandoned = false;
+                Logger::log("Passing on the token of mutex '" + mutexName + "' requested in vain");
+                passToken(mutexName, mutex);
+                return;
+            }
+        }
+        mutex.tokenArrived.notify_one();
+    }
+
+    /** Accessed by Main and Receiving threads - protected by mutexesMutex **/
+    void sendToken(const MutexName& mutexName, TokenMutex& mutex, ProcessId recipient) {
+        std::string token;
+        for (std::uint64_t lastGrantedRequest : mutex.lastGrantedRequests) {
+            appendNumber(token, lastGrantedRequest);
+        }
+        for (ProcessId processId : mutex.queue) {
+            appendNumber(token, static_cast<std::uint64_t>(processId));
+        }
+        mutex.hasToken = false;
+        mutex.queue.clear();
+        communicationManager->send(MessageType::TOKEN, packNamedMessage(mutexName, token), recipient);
+    }
+
+    /** Accessed by Main and Receiving threads - protected by mutexesMutex **/
+    static bool isWaiting(const TokenMutex& mutex, ProcessId processId) {
+        return mutex.requestNumbers[processId] == mutex.lastGrantedRequests[processId] + 1;
+    }
+
+    ProcessId getInitialTokenHolder(const MutexName& mutexName) {
+        return static_cast<ProcessId>(std::hash<MutexName>()(mutexName) % communicationManager->getNumberOfProcesses());
+    }
+
+    std::map<MutexName, TokenMutex> mutexes;
+    std::mutex mutexesMutex;
+
+    std::shared_ptr<CommunicationManager> communicationManager;
+};
+
+#endif //DISTRIBUTEDMONITOR_SUZUKIKASAMIEXCLUSIONALGORITHM_H
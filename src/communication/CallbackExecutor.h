@@ -0,0 +1,178 @@
+#ifndef COMMUNICATION_CALLBACKEXECUTOR_H
+#define COMMUNICATION_CALLBACKEXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <logging/Logger.h>
+#include "ICommunicator.h"
+
+/**
+ * Runs packet handlers on a pool of worker threads instead of the receiving thread.
+ *
+ * Packets are put into serial queues chosen by a key (the name of the object they concern). Packets of one queue are
+ * handled one at a time in the order they were put, while different queues are handled in parallel, so a slow handler
+ * of one monitor does not delay the others.
+ */
+class CallbackExecutor {
+public:
+
+    /** Called by a worker for every packet, along with the sequence number it was put with and the worker's index **/
+    using Handler = std::function<void(const Packet&, std::uint64_t sequence, std::size_t worker)>;
+
+    CallbackExecutor(std::size_t numberOfWorkers, Handler handler) : handler(std::move(handler)) {
+        for (std::size_t worker = 0; worker < numberOfWorkers; ++worker) {
+            workers.emplace_back([this, worker]() { workerFunction(worker); });
+        }
+    }
+
+    ~CallbackExecutor() {
+        {
+            std::lock_guard<std::mutex> lock(readyQueuesMutex);
+            terminate = true;
+        }
+        readyQueuesCondition.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    /** Accessed by Receiving Threads **/
+    void execute(std::size_t key, Packet packet, std::uint64_t sequence) {
+        SerialQueue* queue;
+        {
+            std::lock_guard<std::mutex> lock(queuesMutex);
+            std::unique_ptr<SerialQueue>& queuePtr = queues[key];
+            if (not queuePtr) {
+                queuePtr = std::make_unique<SerialQueue>();
+            }
+            queue = queuePtr.get();
+        }
+        queue->push(new Node {{nullptr}, std::move(packet), sequence});
+        /** Only the packet which makes the queue non-empty hands it over to a worker **/
+        if (queue->pending.fetch_add(1, std::memory_order_acq_rel) == 0) {
+            schedule(queue);
+        }
+    }
+
+    std::size_t getNumberOfWorkers() const {
+        return workers.size();
+    }
+
+private:
+
+    struct Node {
+        std::atomic<Node*> next;
+        Packet packet;
+        std::uint64_t sequence;
+    };
+
+    /**
+     * Lock-free multiple producers, single consumer queue (D. Vyukov). Single consumer is guaranteed by the 'pending'
+     * counter - a queue is handed over to a worker when its first packet is counted and the worker keeps it until it
+     * has handled the last counted packet, so only the worker owning the queue ever touches 'tail'.
+     */
+    struct SerialQueue {
+        SerialQueue() : head(&stub), tail(&stub) { }
+
+        ~SerialQueue() {
+            while (Node* node = pop()) {
+                delete node;
+            }
+        }
+
+        void push(Node* node) {
+            node->next.store(nullptr, std::memory_order_relaxed);
+            Node* previous = head.exchange(node, std::memory_order_acq_rel);
+            previous->next.store(node, std::memory_order_release);
+        }
+
+        /** Returns nullptr if the queue is empty or a push is still in progress **/
+        Node* pop() {
+            Node* first = tail;
+            Node* next = first->next.load(std::memory_order_acquire);
+            if (first == &stub) {
+                if (next == nullptr) {
+                    return nullptr;
+                }
+                tail = next;
+                first = next;
+                next = next->next.load(std::memory_order_acquire);
+            }
+            if (next != nullptr) {
+                tail = next;
+                return first;
+            }
+            if (first != head.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+            push(&stub);
+            next = first->next.load(std::memory_order_acquire);
+            if (next != nullptr) {
+                tail = next;
+                return first;
+            }
+            return nullptr;
+        }
+
+        std::atomic<Node*> head;
+        Node* tail;
+        Node stub {{nullptr}, {}, 0};
+        /** Packets pushed and not handled yet - non-zero while the queue waits for a worker or is owned by one **/
+        std::atomic<std::size_t> pending = 0;
+    };
+
+    void schedule(SerialQueue* queue) {
+        {
+            std::lock_guard<std::mutex> lock(readyQueuesMutex);
+            readyQueues.push_back(queue);
+        }
+        readyQueuesCondition.notify_one();
+    }
+
+    /** Accessed by Worker Threads **/
+    void workerFunction(std::size_t worker) {
+        Logger::registerThread("Exec" + std::to_string(worker), rang::fg::green);
+        while (true) {
+            SerialQueue* queue;
+            {
+                std::unique_lock<std::mutex> lock(readyQueuesMutex);
+                readyQueuesCondition.wait(lock, [&]() { return terminate or not readyQueues.empty(); });
+                if (terminate) {
+                    return;
+                }
+                queue = readyQueues.front();
+                readyQueues.pop_front();
+            }
+            do {
+                Node* node;
+                while (not (node = queue->pop())) {
+                    /** Every counted packet has been pushed, but a push of another one may still be in progress **/
+                    std::this_thread::yield();
+                }
+                handler(node->packet, node->sequence, worker);
+                delete node;
+            } while (queue->pending.fetch_sub(1, std::memory_order_acq_rel) > 1);
+        }
+    }
+
+    Handler handler;
+
+    std::unordered_map<std::size_t, std::unique_ptr<SerialQueue>> queues;
+    std::mutex queuesMutex;
+
+    std::deque<SerialQueue*> readyQueues;
+    std::mutex readyQueuesMutex;
+    std::condition_variable readyQueuesCondition;
+    bool terminate = false;
+
+    std::vector<std::thread> workers;
+};
+
+#endif //COMMUNICATION_CALLBACKEXECUTOR_H
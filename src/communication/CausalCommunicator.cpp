@@ -0,0 +1,130 @@
+#include <chrono>
+#include <util/MessagePacking.h>
+#include "CausalCommunicator.h"
+
+CausalCommunicator::CausalCommunicator(std::shared_ptr<ICommunicator> communicator)
+        : communicator(std::move(communicator)),
+          deliveredBroadcasts(static_cast<std::size_t>(this->communicator->getNumberOfProcesses()), 0) { }
+
+Packet CausalCommunicator::send(MessageType messageType, const std::string& message, const Recipients& recipients) {
+    ProcessId myProcessId = getProcessId();
+    bool broadcast = recipients.size() + 1 == deliveredBroadcasts.size() and not recipients.contains(myProcessId);
+    Packet packet = communicator->send(messageType, stamp(message, broadcast), recipients);
+    packet.message = message;
+    return packet;
+}
+
+Packet CausalCommunicator::sendOthers(MessageType messageType, const std::string& message) {
+    Packet packet = communicator->sendOthers(messageType, stamp(message, true));
+    packet.message = message;
+    return packet;
+}
+
+Packet CausalCommunicator::receive() {
+    if (std::optional<Packet> heldBackPacket = deliverHeldBack()) {
+        return std::move(*heldBackPacket);
+    }
+    while (true) {
+        Packet packet = communicator->receive();
+        if (deliver(packet)) {
+            return packet;
+        }
+        heldBackPackets.push_back(std::move(packet));
+    }
+}
+
+std::optional<Packet> CausalCommunicator::receive(long timeoutMillis) {
+    using namespace std::chrono;
+    if (std::optional<Packet> heldBackPacket = deliverHeldBack()) {
+        return heldBackPacket;
+    }
+    auto deadline = steady_clock::now() + milliseconds(timeoutMillis);
+    while (true) {
+        long remainingMillis = duration_cast<milliseconds>(deadline - steady_clock::now()).count();
+        std::optional<Packet> packet = communicator->receive(std::max(remainingMillis, 0L));
+        if (not packet or deliver(*packet)) {
+            return packet;
+        }
+        heldBackPackets.push_back(std::move(*packet));
+    }
+}
+
+ProcessId CausalCommunicator::getProcessId() {
+    return communicator->getProcessId();
+}
+
+ProcessId CausalCommunicator::getNumberOfProcesses() {
+    return communicator->getNumberOfProcesses();
+}
+
+LamportTime CausalCommunicator::getCurrentLamportTime() {
+    return communicator->getCurrentLamportTime();
+}
+
+void CausalCommunicator::internName(std::string_view name) {
+    communicator->internName(name);
+}
+
+std::size_t CausalCommunicator::getSentBytes() {
+    return communicator->getSentBytes();
+}
+
+bool CausalCommunicator::isCausallyOrdered() {
+    return true;
+}
+
+std::string CausalCommunicator::stamp(const std::string& message, bool broadcast) {
+    std::string stampedMessage = message;
+    std::size_t messageLength = stampedMessage.size();
+    {
+        std::lock_guard<std::mutex> lock(deliveredBroadcastsMutex);
+        if (broadcast) {
+            ++deliveredBroadcasts[static_cast<std::size_t>(getProcessId())];
+        }
+        for (std::size_t processId = 0; processId < deliveredBroadcasts.size(); ++processId) {
+            if (deliveredBroadcasts[processId] != 0) {
+                appendVarint(stampedMessage, processId);
+                appendVarint(stampedMessage, deliveredBroadcasts[processId]);
+            }
+        }
+    }
+    appendNumber(stampedMessage, (stampedMessage.size() - messageLength) << 1 | (broadcast ? 1 : 0));
+    return stampedMessage;
+}
+
+bool CausalCommunicator::deliver(Packet& packet) {
+    std::string_view message = packet.message;
+    std::uint64_t trailer = readNumber(message.substr(message.size() - sizeof(std::uint64_t)), 0);
+    bool broadcast = trailer & 1;
+    auto timestampLength = static_cast<std::size_t>(trailer >> 1);
+    std::size_t offset = message.size() - sizeof(std::uint64_t) - timestampLength;
+    std::string_view timestamp = message.substr(0, message.size() - sizeof(std::uint64_t));
+    auto source = static_cast<std::size_t>(packet.source);
+
+    std::lock_guard<std::mutex> lock(deliveredBroadcastsMutex);
+    while (offset < timestamp.size()) {
+        auto processId = static_cast<std::size_t>(readVarint(timestamp, offset));
+        std::uint64_t broadcasts = readVarint(timestamp, offset);
+        /** A broadcast has to follow the previous broadcast of its sender, everything else only what it depends on **/
+        std::uint64_t delivered = deliveredBroadcasts[processId] + (broadcast and processId == source ? 1 : 0);
+        if (broadcasts > delivered) {
+            return false;
+        }
+    }
+    if (broadcast) {
+        ++deliveredBroadcasts[source];
+    }
+    packet.message.removeSuffix(timestampLength + sizeof(std::uint64_t));
+    return true;
+}
+
+std::optional<Packet> CausalCommunicator::deliverHeldBack() {
+    for (auto packet = heldBackPackets.begin(); packet != heldBackPackets.end(); ++packet) {
+        if (deliver(*packet)) {
+            Packet deliveredPacket = std::move(*packet);
+            heldBackPackets.erase(packet);
+            return deliveredPacket;
+        }
+    }
+    return std::nullopt;
+}
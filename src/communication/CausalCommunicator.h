@@ -0,0 +1,68 @@
+#ifndef COMMUNICATION_CAUSALCOMMUNICATOR_H
+#define COMMUNICATION_CAUSALCOMMUNICATOR_H
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "ICommunicator.h"
+
+/**
+ * Delivers broadcasts (messages sent to all other processes) in causal order with respect to all messages: a packet is
+ * not returned by receive() before every broadcast its sender had sent or delivered before sending it. Other packets
+ * keep the order of the wrapped communicator.
+ *
+ * Every packet carries the numbers of broadcasts of each process its sender has delivered (vector timestamp), appended
+ * to the message: [message][(process, broadcasts) pairs - varints][length of the pairs << 1 | is broadcast - 8 bytes]
+ * Only processes which have broadcast anything are listed. Packets received too early are held back until the
+ * broadcasts they depend on are delivered.
+ *
+ * All processes have to wrap their communicators. Packets sent to a part of the processes are not ordered with respect
+ * to each other, so messages of a GroupCommunicationManager are not causally ordered unless the group has all of
+ * them.
+ */
+class CausalCommunicator : public ICommunicator {
+public:
+
+    explicit CausalCommunicator(std::shared_ptr<ICommunicator> communicator);
+
+    Packet send(MessageType messageType, const std::string& message, const Recipients& recipients) override;
+
+    Packet sendOthers(MessageType messageType, const std::string& message) override;
+
+    Packet receive() override;
+
+    std::optional<Packet> receive(long timeoutMillis) override;
+
+    ProcessId getProcessId() override;
+
+    ProcessId getNumberOfProcesses() override;
+
+    LamportTime getCurrentLamportTime() override;
+
+    void internName(std::string_view name) override;
+
+    std::size_t getSentBytes() override;
+
+    bool isCausallyOrdered() override;
+
+private:
+
+    /** Appends the vector timestamp - a broadcast counts itself **/
+    std::string stamp(const std::string& message, bool broadcast);
+
+    /** Accessed by Receiving Thread - removes the vector timestamp and returns true if the packet can be delivered **/
+    bool deliver(Packet& packet);
+
+    /** Accessed by Receiving Thread **/
+    std::optional<Packet> deliverHeldBack();
+
+    std::shared_ptr<ICommunicator> communicator;
+    /** Broadcasts of each process delivered so far - my own ones are counted when sent **/
+    std::vector<std::uint64_t> deliveredBroadcasts;
+    std::mutex deliveredBroadcastsMutex;
+    /** Accessed by Receiving Thread - packets waiting for the broadcasts they depend on, in the order of arrival **/
+    std::deque<Packet> heldBackPackets;
+};
+
+#endif //COMMUNICATION_CAUSALCOMMUNICATOR_H
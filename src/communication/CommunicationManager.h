@@ -6,110 +6,714 @@
 #include <mutex>
 #include <logging/Logger.h>
 #include <util/StringConcat.h>
+#include <util/MessagePacking.h>
 #include <util/Utils.h>
 #include <unordered_map>
 #include <functional>
+#include <condition_variable>
+#include <vector>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <set>
+#include "CallbackExecutor.h"
 #include "ICommunicator.h"
+#include "ITaggedCommunicator.h"
 
 using SubscriptionId = std::size_t;
 using SubscriptionPredicate = std::function<bool(const Packet&)>;
 using SubscriptionCallback = std::function<void(const Packet&)>;
+/** Returns whether the packet concerned any of the subscriber's objects **/
+using RegistryCallback = std::function<bool(const Packet&)>;
 
 class CommunicationManager {
 public:
 
-    explicit CommunicationManager(std::shared_ptr<ICommunicator> communicator) : communicator(
-            std::move(communicator)) {};
+    /**
+     * @param callbackWorkers when non-zero, callbacks are not run by the receiving thread but by that many workers.
+     * Packets concerning one object (mutex, CV, monitor) are still handled one at a time, in the order of arrival.
+     * @param channels when greater than 1, objects are spread by their names over that many channels, each one being
+     * a separate MPI tag with its own receiving thread. Requires a tagged communicator and the same number of channels
+     * in every process. Packets concerning one object always travel through the same channel, so they stay FIFO.
+     * @param directTags when non-zero, enables sendDirectly() and receiveDirectly(). Objects are spread by their names
+     * over that many additional MPI tags. Requires a tagged communicator and the same number in every process.
+     */
+    explicit CommunicationManager(std::shared_ptr<ICommunicator> communicator, std::size_t callbackWorkers = 0,
+                                  std::size_t channels = 1, std::size_t directTags = 0)
+            : communicator(std::move(communicator)), callbackWorkers(callbackWorkers), channels(channels),
+              directTags(directTags), directTagStates(directTags) {
+        if (channels == 0) {
+            throw std::runtime_error("There has to be at least one channel");
+        }
+        if (channels > 1 or directTags > 0) {
+            taggedCommunicator = std::dynamic_pointer_cast<ITaggedCommunicator<int>>(this->communicator);
+            if (not taggedCommunicator) {
+                throw std::runtime_error("Multiple channels and direct tags require a tagged communicator");
+            }
+        }
+        auto numberOfProcesses = static_cast<std::size_t>(this->communicator->getNumberOfProcesses());
+        sentPackets.resize(channels, std::vector<std::size_t>(numberOfProcesses, 0));
+        receivedPackets.resize(channels, std::vector<std::uint64_t>(numberOfProcesses, 0));
+        dispatchedPackets.resize(channels, std::vector<std::size_t>(numberOfProcesses, 0));
+        outOfOrderDispatchedPackets.resize(channels, std::vector<std::set<std::uint64_t>>(numberOfProcesses));
+        /**
+         * Every receiving thread, every worker and the thread currently receiving on each direct tag announce which
+         * table version they dispatch with
+         */
+        dispatchedTableVersions = std::vector<std::atomic<std::uint64_t>>(channels + callbackWorkers + directTags);
+        for (auto& dispatchedTableVersion : dispatchedTableVersions) {
+            dispatchedTableVersion = IDLE;
+        }
+    };
 
     virtual ~CommunicationManager() {
         terminate = true;
-        if (receivingThread and receivingThread->joinable()) {
-            receivingThread->join();
+        for (std::size_t channel = 0; channel < receivingThreads.size(); ++channel) {
+            /** The receiving thread is most likely blocked waiting for a packet - send it one **/
+            transmit(MessageType::SHUTDOWN, "", {communicator->getProcessId()}, channel);
+            receivingThreads[channel].join();
         }
+        executor.reset();
+        for (const RetiredObject& retired : retiredObjects) {
+            retired.free();
+        }
+        delete indexBuckets.load();
+        for (auto& registry : registries) {
+            delete registry.load();
+        }
+        delete predicated.load();
     }
 
-    void listen() {
-        if (not receivingThread) {
-            receivingThread = std::make_unique<std::thread>(threadFunction);
+    virtual void listen() {
+        if (receivingThreads.empty()) {
+            if (callbackWorkers > 0) {
+                executor = std::make_unique<CallbackExecutor>(
+                        callbackWorkers, [this](const Packet& packet, std::uint64_t sequence, std::size_t worker) {
+                            isDispatchingThread = true;
+                            dispatch(packet, dispatchedTableVersions[channels + worker]);
+                            countDispatchedPacket(getChannel(packet.messageType, packet.message), packet.source,
+                                                  sequence);
+                        });
+            }
+            for (std::size_t channel = 0; channel < channels; ++channel) {
+                receivingThreads.emplace_back([this, channel]() { receive(channel); });
+            }
         }
     }
 
-    SubscriptionId subscribe(const SubscriptionPredicate& predicate, const SubscriptionCallback& callback) {
+    /**
+     * Subscribes to packets matching the predicate. Every predicate is evaluated for every received packet, so it is
+     * meant for subscriptions which cannot be expressed by the message type and the object name.
+     */
+    virtual SubscriptionId subscribe(const SubscriptionPredicate& predicate, const SubscriptionCallback& callback) {
         std::lock_guard<std::mutex> lock(subscriptionMutex);
-        subscriptions[subscriptionSeqNo] = {predicate, callback};
+        reclaim();
+        auto subscriptions = copyList(predicated);
+        subscriptions->push_back({subscriptionSeqNo, predicate, callback});
+        replaceList(predicated, std::move(subscriptions));
         return subscriptionSeqNo++;
     }
 
-    void unsubscribe(SubscriptionId id) {
+    /**
+     * Announces the name of a mutex, CV or monitor kept in a registry (see the registry subscriptions below), so that
+     * the communicator can send it compactly. Subscriptions by the object name announce it themselves.
+     */
+    virtual void internName(std::string_view objectName) {
+        communicator->internName(objectName);
+    }
+
+    /** Subscribes to packets of the given type concerning the given mutex, CV or monitor. Found in constant time. **/
+    virtual SubscriptionId subscribe(MessageType messageType, std::string_view objectName,
+                                     const SubscriptionCallback& callback) {
+        internName(objectName);
         std::lock_guard<std::mutex> lock(subscriptionMutex);
-        subscriptions.erase(id);
+        reclaim();
+        if (indexedSubscriptionKeys.size() >= indexBuckets.load()->buckets.size()) {
+            growIndex();
+        }
+        std::size_t key = indexKey(messageType, objectName);
+        auto& bucket = getBucket(*indexBuckets.load(), key);
+        auto subscriptions = copyList(bucket);
+        subscriptions->push_back({subscriptionSeqNo, messageType, std::string(objectName), callback});
+        replaceList(bucket, std::move(subscriptions));
+        indexedSubscriptionKeys[subscriptionSeqNo] = key;
+        return subscriptionSeqNo++;
+    }
+
+    /**
+     * Subscribes to all packets of the given type, for subscribers keeping their own registry of objects - e.g. an
+     * algorithm handling thousands of mutexes, which would otherwise need a subscription for each one of them. Found in
+     * constant time. A packet none of the callbacks returns true for is treated as if nobody subscribed to it.
+     */
+    virtual SubscriptionId subscribe(MessageType messageType, const RegistryCallback& callback) {
+        std::lock_guard<std::mutex> lock(subscriptionMutex);
+        reclaim();
+        auto& registry = registries[static_cast<std::size_t>(messageType)];
+        auto subscriptions = copyList(registry);
+        subscriptions->push_back({subscriptionSeqNo, callback});
+        replaceList(registry, std::move(subscriptions));
+        return subscriptionSeqNo++;
+    }
+
+    /**
+     * Once it returns, the callback is not executed anymore. When called outside the callbacks it waits for the callback
+     * to finish, so it must not be called while holding a lock the callback takes.
+     */
+    virtual void unsubscribe(SubscriptionId id) {
+        std::uint64_t version;
+        {
+            std::lock_guard<std::mutex> lock(subscriptionMutex);
+            reclaim();
+            auto indexedSubscriptionKey = indexedSubscriptionKeys.find(id);
+            if (indexedSubscriptionKey != indexedSubscriptionKeys.end()) {
+                version = removeFromList(getBucket(*indexBuckets.load(), indexedSubscriptionKey->second), id);
+                indexedSubscriptionKeys.erase(indexedSubscriptionKey);
+            } else {
+                version = removeFromList(predicated, id);
+                for (auto& registry : registries) {
+                    version = std::max(version, removeFromList(registry, id));
+                }
+            }
+        }
+        if (not isDispatchingThread) {
+            awaitDispatchOf(version);
+        }
+    }
+
+    virtual Packet send(MessageType messageType, const std::string& message, ProcessId recipient) {
+        if (Logger::isEnabled()) {
+            Logger::log(util::concat("Sending to process ", recipient, " ", printPacket(messageType, message)));
+        }
+        std::size_t channel = getChannel(messageType, message);
+        Packet packet = transmit(messageType, message, recipient, channel);
+        countSentPacket(recipient, channel);
+        return packet;
+    }
+
+    virtual Packet send(MessageType messageType, const std::string& message, const Recipients& recipients) {
+        if (Logger::isEnabled()) {
+            Logger::log(util::concat("Sending to processes ", printRecipients(recipients), " ",
+                                     printPacket(messageType, message)));
+        }
+        std::size_t channel = getChannel(messageType, message);
+        Packet packet = transmit(messageType, message, recipients, channel);
+        countSentPackets(recipients, channel);
+        return packet;
+    }
+
+    virtual Packet sendOthers(MessageType messageType, const std::string& message) {
+        if (Logger::isEnabled()) {
+            Logger::log("Sending to other processes " + printPacket(messageType, message));
+        }
+        std::size_t channel = getChannel(messageType, message);
+        Packet packet = taggedCommunicator
+                        ? taggedCommunicator->sendOthers(messageType, message, getTag(channel))
+                        : communicator->sendOthers(messageType, message);
+        countSentPackets(ProcessRange::allExcept(getProcessId(), getNumberOfProcesses()), channel);
+        return packet;
+    }
+
+    /** Number of packets sent to the given process through the given channel so far **/
+    virtual std::size_t getSentPacketsCount(ProcessId recipient, std::size_t channel = 0) {
+        std::lock_guard<std::mutex> lock(packetCountersMutex);
+        return sentPackets[channel][recipient];
+    }
+
+    /**
+     * Blocks until at least 'count' packets received from the given process through the given channel have been
+     * dispatched. Since the channels are FIFO, it lets an algorithm which does not pass the lock through this manager
+     * make sure that everything the previous owner had sent (e.g. the SYNC message) has been processed.
+     */
+    virtual void awaitDispatchedPackets(ProcessId source, std::size_t count, std::size_t channel = 0) {
+        std::unique_lock<std::mutex> lock(packetCountersMutex);
+        packetsDispatchedCondition.wait(lock, [&]() { return dispatchedPackets[channel][source] >= count; });
     }
 
-    Packet send(MessageType messageType, const std::string& message, ProcessId recipient) {
-        Logger::log(util::concat("Sending to process ", recipient, " ", printPacket(messageType, message)));
-        return communicator->send(messageType, message, recipient);
+    /**
+     * Sends a packet to be received by the recipient's thread blocked in receiveDirectly() for the object the packet
+     * concerns, so that the packet does not have to pass through the receiving thread. The protocol has to guarantee
+     * that the recipient is waiting for the packet.
+     *
+     * The packet carries the number of packets sent to the recipient through the object's channel so far and is not
+     * dispatched before they are, so it cannot overtake e.g. a SYNC message sent before it.
+     */
+    virtual Packet sendDirectly(MessageType messageType, const std::string& message, ProcessId recipient) {
+        if (Logger::isEnabled()) {
+            Logger::log(util::concat("Sending directly to process ", recipient, " ",
+                                     printPacket(messageType, message)));
+        }
+        std::string directMessage = message;
+        appendNumber(directMessage, getSentPacketsCount(recipient, getChannel(messageType, message)));
+        Packet packet = taggedCommunicator->send(messageType, directMessage, recipient,
+                                                 getDirectTag(extractObjectName(messageType, message)));
+        packet.message = message;
+        return packet;
     }
 
-    Packet send(MessageType messageType, const std::string& message, const std::unordered_set<ProcessId>& recipients) {
-        Logger::log(util::concat("Sending to processes ", printContainer(recipients), " ",
-                                 printPacket(messageType, message)));
-        return communicator->send(messageType, message, recipients);
+    /**
+     * Accessed by Main Thread
+     * Blocks until 'done' returns true. Meanwhile the calling thread receives the packets sent directly to this
+     * process concerning the given object and dispatches them itself. Objects sharing the direct tag are served too -
+     * only one of the threads waiting on a tag receives at a time, the others are woken up after every packet.
+     * 'done' is called without any lock held.
+     *
+     * With a deadline it stops receiving when the deadline passes and returns what 'done' returns then. Packets sent
+     * directly afterwards are dispatched by the next thread receiving on the tag.
+     */
+    virtual bool receiveDirectly(std::string_view objectName, const std::function<bool()>& done,
+                                 std::optional<Deadline> deadline = std::nullopt) {
+        std::size_t directTagIndex = getDirectTagIndex(objectName);
+        DirectTag& directTag = directTagStates[directTagIndex];
+        auto deadlinePassed = [&]() { return deadline and std::chrono::steady_clock::now() >= *deadline; };
+        while (true) {
+            std::uint64_t dispatchedBefore;
+            {
+                std::lock_guard<std::mutex> lock(directTag.mutex);
+                dispatchedBefore = directTag.dispatchedPackets;
+            }
+            if (done()) {
+                return true;
+            }
+            if (deadlinePassed()) {
+                return false;
+            }
+            std::unique_lock<std::mutex> lock(directTag.mutex);
+            if (directTag.receiving) {
+                auto packetDispatched = [&]() {
+                    return not directTag.receiving or directTag.dispatchedPackets != dispatchedBefore;
+                };
+                if (deadline) {
+                    directTag.packetDispatched.wait_until(lock, *deadline, packetDispatched);
+                } else {
+                    directTag.packetDispatched.wait(lock, packetDispatched);
+                }
+                continue;
+            }
+            directTag.receiving = true;
+            lock.unlock();
+
+            /** Polls instead of blocking in MPI, not to starve the receiving thread of an oversubscribed core **/
+            std::optional<Packet> polled;
+            while (not (polled = taggedCommunicator->receive(0, getTag(channels + directTagIndex)))) {
+                if (deadlinePassed()) {
+                    lock.lock();
+                    directTag.receiving = false;
+                    lock.unlock();
+                    directTag.packetDispatched.notify_all();
+                    return done();
+                }
+                std::this_thread::yield();
+            }
+            Packet packet = std::move(*polled);
+            std::size_t fence = readNumber(std::string_view(packet.message).substr(packet.message.size() -
+                                                                                   sizeof(std::uint64_t)), 0);
+            packet.message.removeSuffix(sizeof(std::uint64_t));
+            if (Logger::isEnabled()) {
+                Logger::log(util::concat("Received packet directly from process ", packet.source, " ",
+                                         printPacket(packet.messageType, packet.message)));
+            }
+            awaitDispatchedPackets(packet.source, fence, getChannel(packet.messageType, packet.message));
+            isDispatchingThread = true;
+            dispatch(packet, dispatchedTableVersions[channels + callbackWorkers + directTagIndex]);
+            isDispatchingThread = false;
+
+            lock.lock();
+            directTag.receiving = false;
+            ++directTag.dispatchedPackets;
+            lock.unlock();
+            directTag.packetDispatched.notify_all();
+        }
     }
 
-    Packet sendOthers(MessageType messageType, const std::string& message) {
-        Logger::log("Sending to other processes " + printPacket(messageType, message));
-        return communicator->sendOthers(messageType, message);
+    /** Whether sendDirectly() and receiveDirectly() may be used **/
+    virtual bool isDirectReceiveEnabled() {
+        return directTags > 0;
     }
 
-    ProcessId getProcessId() {
+    /**
+     * Whether a packet is not dispatched before the broadcasts (sendOthers) its sender had sent or dispatched before
+     * sending it, e.g. a COND_WAIT_END sent before releasing a mutex is dispatched by the next owner before the mutex is
+     * passed. Requires a communicator delivering in causal order and dispatching by the receiving thread.
+     */
+    virtual bool isCausallyOrdered() {
+        return communicator->isCausallyOrdered() and callbackWorkers == 0;
+    }
+
+    /** The channel packets concerning the given mutex, CV or monitor travel through **/
+    virtual std::size_t getChannel(std::string_view objectName) {
+        return channels == 1 ? 0 : std::hash<std::string_view>()(objectName) % channels;
+    }
+
+    virtual std::size_t getNumberOfChannels() {
+        return channels;
+    }
+
+    virtual ProcessId getProcessId() {
         return communicator->getProcessId();
     }
 
-    ProcessId getNumberOfProcesses() {
+    virtual ProcessId getNumberOfProcesses() {
         return communicator->getNumberOfProcesses();
     }
 
-    LamportTime getCurrentLamportTime() {
+    virtual LamportTime getCurrentLamportTime() {
         return communicator->getCurrentLamportTime();
     }
 
 protected:
 
-    std::function<void()> threadFunction = [&]() {
-        Logger::registerThread("Recv", rang::fg::yellow);
+    /** For views which delegate everything to another manager **/
+    CommunicationManager() = default;
+
+    /** Accessed by Receiving Threads - one per channel **/
+    void receive(std::size_t channel) {
+        Logger::registerThread(channels == 1 ? "Recv" : "Recv" + std::to_string(channel), rang::fg::yellow);
+        isDispatchingThread = true;
+        std::vector<std::uint64_t>& channelReceivedPackets = receivedPackets[channel];
         while (not terminate.load()) {
 
-            Packet packet = communicator->receive();
-            Logger::log(util::concat("Received packet from process ", packet.source, " ",
-                                     printPacket(packet.messageType, packet.message)));
-            std::lock_guard<std::mutex> lock(subscriptionMutex);
-            bool anyCallbackInvoked = false;
-            for (const auto& subscription : subscriptions) {
-                const auto&[predicate, callback] = subscription.second;
-                if (predicate(packet)) {
-                    callback(packet);
+            Packet packet = taggedCommunicator ? taggedCommunicator->receive(getTag(channel)) : communicator->receive();
+            if (terminate.load()) {
+                break;
+            }
+            if (Logger::isEnabled()) {
+                Logger::log(util::concat("Received packet from process ", packet.source, " ",
+                                         printPacket(packet.messageType, packet.message)));
+            }
+            /** The number of packets received from the source through this channel before this one **/
+            std::uint64_t sequence = channelReceivedPackets[packet.source]++;
+            if (executor) {
+                std::size_t key = std::hash<std::string_view>()(extractObjectName(packet.messageType, packet.message));
+                executor->execute(key, std::move(packet), sequence);
+            } else {
+                dispatch(packet, dispatchedTableVersions[channel]);
+                countDispatchedPacket(channel, packet.source, sequence);
+            }
+        }
+    }
+
+    /**
+     * Accessed by Receiving Threads, Worker Threads or threads receiving directly
+     * 'dispatchedTableVersion' is the slot the calling thread announces the table version it uses in.
+     */
+    void dispatch(const Packet& packet, std::atomic<std::uint64_t>& dispatchedTableVersion) {
+        /**
+         * Announce the version before reading the lists, so that unsubscribe() knows whether to wait for me and the
+         * lists replaced since then are not freed while I use them
+         */
+        dispatchedTableVersion = tableVersion.load();
+        bool anyCallbackInvoked = false;
+        std::string_view objectName = extractObjectName(packet.messageType, packet.message);
+        std::size_t key = indexKey(packet.messageType, objectName);
+        if (const auto* indexedSubscriptions = getBucket(*indexBuckets.load(), key).load()) {
+            for (const IndexedSubscription& subscription : *indexedSubscriptions) {
+                if (subscription.messageType == packet.messageType and subscription.objectName == objectName) {
+                    subscription.callback(packet);
+                    anyCallbackInvoked = true;
+                }
+            }
+        }
+        if (const auto* registry = registries[static_cast<std::size_t>(packet.messageType)].load()) {
+            for (const RegistrySubscription& subscription : *registry) {
+                if (subscription.callback(packet)) {
                     anyCallbackInvoked = true;
                 }
             }
-            if (not anyCallbackInvoked) {
-                auto error = "WARNING! No callback invoked for packet with TS " + std::to_string(packet.lamportTime) +
-                             " " + printPacket(packet.messageType, packet.message);
-                Logger::log(error);
-                throw std::runtime_error(error);
+        }
+        if (const auto* predicatedSubscriptions = predicated.load()) {
+            for (const PredicatedSubscription& subscription : *predicatedSubscriptions) {
+                if (subscription.predicate(packet)) {
+                    subscription.callback(packet);
+                    anyCallbackInvoked = true;
+                }
+            }
+        }
+        dispatchedTableVersion = IDLE;
+        if (not anyCallbackInvoked) {
+            auto error = "WARNING! No callback invoked for packet with TS " + std::to_string(packet.lamportTime) +
+                         " " + printPacket(packet.messageType, packet.message);
+            Logger::log(error);
+            throw std::runtime_error(error);
+        }
+    }
+
+    /**
+     * Workers may finish packets of one source out of order - only the packets all of whose predecessors have been
+     * dispatched as well are counted, so that awaitDispatchedPackets() keeps its meaning.
+     */
+    void countDispatchedPacket(std::size_t channel, ProcessId source, std::uint64_t sequence) {
+        {
+            std::lock_guard<std::mutex> countersLock(packetCountersMutex);
+            std::set<std::uint64_t>& outOfOrder = outOfOrderDispatchedPackets[channel][source];
+            std::size_t& dispatched = dispatchedPackets[channel][source];
+            if (sequence != dispatched) {
+                outOfOrder.insert(sequence);
+                return;
+            }
+            ++dispatched;
+            while (not outOfOrder.empty() and *outOfOrder.begin() == dispatched) {
+                outOfOrder.erase(outOfOrder.begin());
+                ++dispatched;
             }
         }
+        packetsDispatchedCondition.notify_all();
+    }
+
+    struct IndexedSubscription {
+        SubscriptionId id;
+        MessageType messageType;
+        std::string objectName;
+        SubscriptionCallback callback;
+    };
+
+    struct RegistrySubscription {
+        SubscriptionId id;
+        RegistryCallback callback;
+    };
+
+    struct PredicatedSubscription {
+        SubscriptionId id;
+        SubscriptionPredicate predicate;
+        SubscriptionCallback callback;
     };
 
-    static std::string printPacket(MessageType messageType, const std::string& message) {
+    /**
+     * Subscriptions are kept in lists which are never modified once published - a change copies the one list it
+     * concerns and replaces it, so the dispatching threads read them without taking any lock. Replaced lists are
+     * retired and freed once no thread dispatches with a version older than their replacement (see reclaim()).
+     */
+    template <typename Subscription>
+    using SubscriptionList = std::atomic<const std::vector<Subscription>*>;
+    static_assert(std::atomic<const void*>::is_always_lock_free, "Dispatching has to be lock-free");
+
+    /** Indexed subscriptions by the hash of the message type and the object name **/
+    struct IndexBuckets {
+        explicit IndexBuckets(std::size_t size) : buckets(size) {
+            for (auto& bucket : buckets) {
+                bucket = nullptr;
+            }
+        }
+
+        ~IndexBuckets() {
+            for (auto& bucket : buckets) {
+                delete bucket.load();
+            }
+        }
+
+        std::vector<SubscriptionList<IndexedSubscription>> buckets;
+    };
+
+    static std::size_t indexKey(MessageType messageType, std::string_view objectName) {
+        std::size_t key = std::hash<std::string_view>()(objectName);
+        hashCombine(key, messageType);
+        return key;
+    }
+
+    static SubscriptionList<IndexedSubscription>& getBucket(IndexBuckets& index, std::size_t key) {
+        return index.buckets[key % index.buckets.size()];
+    }
+
+    /** Protected by subscriptionMutex **/
+    template <typename Subscription>
+    static std::unique_ptr<std::vector<Subscription>> copyList(const SubscriptionList<Subscription>& list) {
+        const std::vector<Subscription>* subscriptions = list.load();
+        return subscriptions == nullptr ? std::make_unique<std::vector<Subscription>>()
+                                        : std::make_unique<std::vector<Subscription>>(*subscriptions);
+    }
+
+    /** Protected by subscriptionMutex. An empty list is replaced by nothing. Returns the version of the change. **/
+    template <typename Subscription>
+    std::uint64_t replaceList(SubscriptionList<Subscription>& list,
+                              std::unique_ptr<std::vector<Subscription>> subscriptions) {
+        if (subscriptions->empty()) {
+            subscriptions.reset();
+        }
+        const std::vector<Subscription>* replaced = list.exchange(subscriptions.release());
+        std::uint64_t version = ++tableVersion;
+        retire(replaced, version);
+        return version;
+    }
+
+    /** Protected by subscriptionMutex. Returns the version of the change, or 0 if the list has no such subscription. **/
+    template <typename Subscription>
+    std::uint64_t removeFromList(SubscriptionList<Subscription>& list, SubscriptionId id) {
+        const std::vector<Subscription>* subscriptions = list.load();
+        auto hasId = [id](const Subscription& subscription) { return subscription.id == id; };
+        if (subscriptions == nullptr or std::none_of(subscriptions->begin(), subscriptions->end(), hasId)) {
+            return 0;
+        }
+        auto remaining = std::make_unique<std::vector<Subscription>>();
+        std::remove_copy_if(subscriptions->begin(), subscriptions->end(), std::back_inserter(*remaining), hasId);
+        return replaceList(list, std::move(remaining));
+    }
+
+    /** Protected by subscriptionMutex. Doubles the buckets, so that a bucket keeps about one subscription. **/
+    void growIndex() {
+        IndexBuckets* index = indexBuckets.load();
+        auto grown = std::make_unique<IndexBuckets>(index->buckets.size() * 2);
+        std::vector<std::vector<IndexedSubscription>> buckets(grown->buckets.size());
+        for (const auto& bucket : index->buckets) {
+            if (const auto* subscriptions = bucket.load()) {
+                for (const IndexedSubscription& subscription : *subscriptions) {
+                    std::size_t key = indexKey(subscription.messageType, subscription.objectName);
+                    buckets[key % buckets.size()].push_back(subscription);
+                }
+            }
+        }
+        for (std::size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+            if (not buckets[bucket].empty()) {
+                grown->buckets[bucket] = new std::vector<IndexedSubscription>(std::move(buckets[bucket]));
+            }
+        }
+        IndexBuckets* replaced = indexBuckets.exchange(grown.release());
+        retire(replaced, ++tableVersion);
+    }
+
+    /** Protected by subscriptionMutex **/
+    template <typename Object>
+    void retire(const Object* object, std::uint64_t version) {
+        if (object != nullptr) {
+            retiredObjects.push_back({version, [object]() { delete object; }});
+        }
+    }
+
+    /** Protected by subscriptionMutex. Frees the retired objects no dispatching thread can be using anymore. **/
+    void reclaim() {
+        if (retiredObjects.empty()) {
+            return;
+        }
+        std::uint64_t oldestDispatchedVersion = IDLE;
+        for (const auto& dispatchedTableVersion : dispatchedTableVersions) {
+            oldestDispatchedVersion = std::min(oldestDispatchedVersion, dispatchedTableVersion.load());
+        }
+        auto reclaimable = std::partition(retiredObjects.begin(), retiredObjects.end(),
+                                          [&](const RetiredObject& retired) {
+                                              return retired.version > oldestDispatchedVersion;
+                                          });
+        for (auto retired = reclaimable; retired != retiredObjects.end(); ++retired) {
+            retired->free();
+        }
+        retiredObjects.erase(reclaimable, retiredObjects.end());
+    }
+
+    /** Waits until no thread dispatches packets using a table older than the given version **/
+    void awaitDispatchOf(std::uint64_t version) {
+        for (const auto& dispatchedTableVersion : dispatchedTableVersions) {
+            while (dispatchedTableVersion.load() < version) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void countSentPacket(ProcessId recipient, std::size_t channel) {
+        std::lock_guard<std::mutex> lock(packetCountersMutex);
+        ++sentPackets[channel][recipient];
+    }
+
+    void countSentPackets(const Recipients& recipients, std::size_t channel) {
+        std::lock_guard<std::mutex> lock(packetCountersMutex);
+        std::vector<std::size_t>& channelPackets = sentPackets[channel];
+        recipients.forEach([&](ProcessId recipient) {
+            ++channelPackets[recipient];
+        });
+    }
+
+    /** Messages which do not concern any object (e.g. SHUTDOWN) use the first channel **/
+    std::size_t getChannel(MessageType messageType, std::string_view message) {
+        return channels == 1 or message.empty() ? 0 : getChannel(extractObjectName(messageType, message));
+    }
+
+    /** Channels use the tags following the default one, direct tags follow the channels **/
+    int getTag(std::size_t channel) const {
+        return taggedCommunicator->getDefaultTag() + static_cast<int>(channel);
+    }
+
+    std::size_t getDirectTagIndex(std::string_view objectName) const {
+        if (directTags == 0) {
+            throw std::runtime_error("Direct receive is not enabled");
+        }
+        return std::hash<std::string_view>()(objectName) % directTags;
+    }
+
+    int getDirectTag(std::string_view objectName) const {
+        return getTag(channels + getDirectTagIndex(objectName));
+    }
+
+    Packet transmit(MessageType messageType, const std::string& message, const Recipients& recipients,
+                    std::size_t channel) {
+        return taggedCommunicator ? taggedCommunicator->send(messageType, message, recipients, getTag(channel))
+                                  : communicator->send(messageType, message, recipients);
+    }
+
+    Packet transmit(MessageType messageType, const std::string& message, ProcessId recipient, std::size_t channel) {
+        return taggedCommunicator ? taggedCommunicator->send(messageType, message, recipient, getTag(channel))
+                                  : communicator->send(messageType, message, recipient);
+    }
+
+    static std::string printRecipients(const Recipients& recipients) {
+        std::string result;
+        recipients.forEach([&](ProcessId recipient) {
+            result += result.empty() ? "{" : ",";
+            result += std::to_string(recipient);
+        });
+        return result.empty() ? "{}" : result + '}';
+    }
+
+    static std::string printPacket(MessageType messageType, std::string_view message) {
         return util::concat("[messageType: ", messageType, ", message: ", message, ']');
     }
 
-    std::unordered_map<SubscriptionId, std::pair<SubscriptionPredicate, SubscriptionCallback>> subscriptions;
+    static constexpr std::uint64_t IDLE = std::numeric_limits<std::uint64_t>::max();
+
+    struct DirectTag {
+        std::mutex mutex;
+        /** Set while one of the waiting threads receives on the tag **/
+        bool receiving = false;
+        std::uint64_t dispatchedPackets = 0;
+        std::condition_variable packetDispatched;
+    };
+
+    struct RetiredObject {
+        std::uint64_t version;
+        std::function<void()> free;
+    };
+
+    static constexpr std::size_t INITIAL_INDEX_BUCKETS = 16;
+
+    std::atomic<IndexBuckets*> indexBuckets = new IndexBuckets(INITIAL_INDEX_BUCKETS);
+    /** Indexed by MessageType **/
+    std::array<SubscriptionList<RegistrySubscription>, messageTypeString.size()> registries {};
+    SubscriptionList<PredicatedSubscription> predicated = nullptr;
+    /** Protected by subscriptionMutex **/
+    std::vector<RetiredObject> retiredObjects;
+    std::unordered_map<SubscriptionId, std::size_t> indexedSubscriptionKeys;
+    std::atomic<std::uint64_t> tableVersion = 0;
+    std::vector<std::atomic<std::uint64_t>> dispatchedTableVersions;
+    static inline thread_local bool isDispatchingThread = false;
     SubscriptionId subscriptionSeqNo = 0;
     std::shared_ptr<ICommunicator> communicator;
-    std::unique_ptr<std::thread> receivingThread;
+    /** Set only when there is more than one channel **/
+    std::shared_ptr<ITaggedCommunicator<int>> taggedCommunicator;
+    std::vector<std::thread> receivingThreads;
+    std::size_t callbackWorkers = 0;
+    std::size_t channels = 1;
+    std::size_t directTags = 0;
+    std::vector<DirectTag> directTagStates;
+    std::unique_ptr<CallbackExecutor> executor;
     std::atomic<bool> terminate = false;
     std::mutex subscriptionMutex;
+
+    /** Packet counters are indexed by the channel first, then by the process **/
+    std::vector<std::vector<std::size_t>> sentPackets;
+    /** Accessed by Receiving Threads only - each one uses the row of its channel **/
+    std::vector<std::vector<std::uint64_t>> receivedPackets;
+    std::vector<std::vector<std::size_t>> dispatchedPackets;
+    std::vector<std::vector<std::set<std::uint64_t>>> outOfOrderDispatchedPackets;
+    std::mutex packetCountersMutex;
+    std::condition_variable packetsDispatchedCondition;
 };
 
 
@@ -0,0 +1,170 @@
+#ifndef COMMUNICATION_GROUPCOMMUNICATIONMANAGER_H
+#define COMMUNICATION_GROUPCOMMUNICATIONMANAGER_H
+
+#include <algorithm>
+#include <vector>
+#include "CommunicationManager.h"
+
+/**
+ * A view of another CommunicationManager restricted to a subgroup of processes. Processes of the group are numbered
+ * from 0 to the size of the group, so any algorithm can run among them unchanged.
+ *
+ * The view has no receiving thread of its own - it translates packets dispatched by the parent manager. Since both use
+ * the same channels, messages sent through the view and through the parent remain FIFO with respect to each other.
+ */
+class GroupCommunicationManager : public CommunicationManager {
+public:
+
+    /** 'members' are ids of the group's processes in the parent manager. This process has to be one of them. **/
+    GroupCommunicationManager(std::shared_ptr<CommunicationManager> parent, std::vector<ProcessId> members)
+            : parent(std::move(parent)), members(std::move(members)) {
+        auto parentProcesses = static_cast<std::size_t>(this->parent->getNumberOfProcesses());
+        groupIds.assign(parentProcesses, NOT_A_MEMBER);
+        parentRecipients = ProcessSet(parentProcesses);
+        for (std::size_t groupId = 0; groupId < this->members.size(); ++groupId) {
+            groupIds.at(static_cast<std::size_t>(this->members[groupId])) = static_cast<ProcessId>(groupId);
+        }
+        myGroupId = toGroupId(this->parent->getProcessId());
+        if (myGroupId == NOT_A_MEMBER) {
+            throw std::runtime_error("This process does not belong to the group");
+        }
+        for (ProcessId member : this->members) {
+            if (member != this->parent->getProcessId()) {
+                otherMembers.insert(member);
+            }
+        }
+    }
+
+    void listen() override {
+        parent->listen();
+    }
+
+    void internName(std::string_view objectName) override {
+        parent->internName(objectName);
+    }
+
+    SubscriptionId subscribe(const SubscriptionPredicate& predicate, const SubscriptionCallback& callback) override {
+        return parent->subscribe(
+                [this, predicate](const Packet& packet) {
+                    return toGroupId(packet.source) != NOT_A_MEMBER and predicate(toGroupPacket(packet));
+                },
+                [this, callback](const Packet& packet) {
+                    callback(toGroupPacket(packet));
+                }
+        );
+    }
+
+    SubscriptionId subscribe(MessageType messageType, std::string_view objectName,
+                             const SubscriptionCallback& callback) override {
+        return parent->subscribe(messageType, objectName, [this, callback](const Packet& packet) {
+            if (toGroupId(packet.source) != NOT_A_MEMBER) {
+                callback(toGroupPacket(packet));
+            }
+        });
+    }
+
+    SubscriptionId subscribe(MessageType messageType, const RegistryCallback& callback) override {
+        return parent->subscribe(messageType, [this, callback](const Packet& packet) {
+            return toGroupId(packet.source) != NOT_A_MEMBER and callback(toGroupPacket(packet));
+        });
+    }
+
+    void unsubscribe(SubscriptionId id) override {
+        parent->unsubscribe(id);
+    }
+
+    Packet send(MessageType messageType, const std::string& message, ProcessId recipient) override {
+        return toGroupPacket(parent->send(messageType, message, members.at(recipient)));
+    }
+
+    Packet send(MessageType messageType, const std::string& message, const Recipients& recipients) override {
+        std::lock_guard<std::mutex> lock(parentRecipientsMutex);
+        parentRecipients.clear();
+        recipients.forEach([&](ProcessId recipient) {
+            parentRecipients.insert(members.at(recipient));
+        });
+        return toGroupPacket(parent->send(messageType, message, parentRecipients));
+    }
+
+    Packet sendOthers(MessageType messageType, const std::string& message) override {
+        return toGroupPacket(parent->send(messageType, message, otherMembers));
+    }
+
+    std::size_t getSentPacketsCount(ProcessId recipient, std::size_t channel = 0) override {
+        return parent->getSentPacketsCount(members.at(recipient), channel);
+    }
+
+    void awaitDispatchedPackets(ProcessId source, std::size_t count, std::size_t channel = 0) override {
+        parent->awaitDispatchedPackets(members.at(source), count, channel);
+    }
+
+    Packet sendDirectly(MessageType messageType, const std::string& message, ProcessId recipient) override {
+        return toGroupPacket(parent->sendDirectly(messageType, message, members.at(recipient)));
+    }
+
+    bool receiveDirectly(std::string_view objectName, const std::function<bool()>& done,
+                         std::optional<Deadline> deadline = std::nullopt) override {
+        return parent->receiveDirectly(objectName, done, deadline);
+    }
+
+    bool isDirectReceiveEnabled() override {
+        return parent->isDirectReceiveEnabled();
+    }
+
+    /** Unless the group has all processes, sending to the other members is not a broadcast of the parent **/
+    bool isCausallyOrdered() override {
+        return parent->isCausallyOrdered() and static_cast<ProcessId>(members.size()) == parent->getNumberOfProcesses();
+    }
+
+    std::size_t getChannel(std::string_view objectName) override {
+        return parent->getChannel(objectName);
+    }
+
+    std::size_t getNumberOfChannels() override {
+        return parent->getNumberOfChannels();
+    }
+
+    ProcessId getProcessId() override {
+        return myGroupId;
+    }
+
+    ProcessId getNumberOfProcesses() override {
+        return static_cast<ProcessId>(members.size());
+    }
+
+    LamportTime getCurrentLamportTime() override {
+        return parent->getCurrentLamportTime();
+    }
+
+    /** Id of the group's process in the parent manager **/
+    ProcessId toParentId(ProcessId groupId) const {
+        return members.at(groupId);
+    }
+
+private:
+
+    static constexpr ProcessId NOT_A_MEMBER = -1;
+
+    ProcessId toGroupId(ProcessId parentId) const {
+        auto index = static_cast<std::size_t>(parentId);
+        return index < groupIds.size() ? groupIds[index] : NOT_A_MEMBER;
+    }
+
+    Packet toGroupPacket(Packet packet) const {
+        packet.source = toGroupId(packet.source);
+        return packet;
+    }
+
+    std::shared_ptr<CommunicationManager> parent;
+    std::vector<ProcessId> members;
+    /** Group ids of all processes of the parent manager, so that translating a packet takes constant time **/
+    std::vector<ProcessId> groupIds;
+    ProcessId myGroupId;
+    /** Parent ids of the other members **/
+    ProcessSet otherMembers;
+    /** Reused by every send to a part of the group, so that it does not allocate **/
+    ProcessSet parentRecipients;
+    std::mutex parentRecipientsMutex;
+};
+
+#endif //COMMUNICATION_GROUPCOMMUNICATIONMANAGER_H
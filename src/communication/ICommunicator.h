@@ -2,25 +2,31 @@
 #define COMMUNICATION_ICOMMUNICATOR_H
 
 #include <optional>
-#include <unordered_set>
+#include <string_view>
 #include <util/Define.h>
 #include <util/Utils.h>
+#include "Payload.h"
+#include "Recipients.h"
 
 using ProcessId = int;
 using LamportTime = unsigned long;
 
+/**
+ * A packet is identified by its source and its Lamport time - every packet sent by a process gets a new time, so
+ * comparing and hashing packets never looks at their messages.
+ */
 struct Packet {
     LamportTime lamportTime;
     ProcessId source;
     MessageType messageType;
-    std::string message;
+    Payload message;
 
     inline bool operator==(const Packet &other) const {
-        return source == other.source && messageType == other.messageType && message == other.message;
+        return source == other.source && lamportTime == other.lamportTime;
     }
 
     inline bool operator<(const Packet &other) const {
-        return lamportTime < other.lamportTime;
+        return lamportTime < other.lamportTime || (lamportTime == other.lamportTime && source < other.source);
     }
 };
 
@@ -29,7 +35,7 @@ namespace std {
     struct hash<Packet> {
         inline std::size_t operator()(const Packet& packet) const {
             std::size_t hash = 0;
-            hashCombine(hash, packet.source, packet.messageType, packet.message);
+            hashCombine(hash, packet.source, packet.lamportTime);
             return hash;
         }
     };
@@ -38,14 +44,14 @@ namespace std {
 class ICommunicator {
 public:
 
-    virtual Packet send(MessageType messageType, const std::string& message, const std::unordered_set<ProcessId>& recipients) = 0;
+    virtual Packet send(MessageType messageType, const std::string& message, const Recipients& recipients) = 0;
 
     virtual Packet send(MessageType messageType, const std::string& message, ProcessId recipient) {
-        return send(messageType, message, std::unordered_set<ProcessId> {recipient});
+        return send(messageType, message, Recipients(recipient));
     };
 
     virtual Packet sendOthers(MessageType messageType, const std::string& message) {
-        return send(messageType, message, otherProcesses);
+        return send(messageType, message, ProcessRange::allExcept(myProcessId, numberOfProcesses));
     };
 
     virtual Packet receive() = 0;
@@ -64,14 +70,28 @@ public:
         return currentLamportTime;
     }
 
+    /**
+     * Announces the name of an object (mutex, CV, monitor) messages will concern, so that the communicator can send
+     * a shorter identifier instead. All processes are expected to announce the same names.
+     */
+    virtual void internName(std::string_view name) { }
+
+    /** Whether broadcasts are delivered in causal order with respect to all packets (see CausalCommunicator) **/
+    virtual bool isCausallyOrdered() {
+        return false;
+    }
+
+    /** Number of bytes sent so far, including headers **/
+    virtual std::size_t getSentBytes() {
+        return 0;
+    }
+
 protected:
 
     ProcessId myProcessId;
 
     ProcessId numberOfProcesses;
 
-    std::unordered_set<ProcessId> otherProcesses;
-
     LamportTime currentLamportTime;
 };
 
@@ -7,18 +7,18 @@ template <typename Tag>
 class ITaggedCommunicator : public ICommunicator {
 public:
 
-    virtual Packet send(MessageType messageType, const std::string& message, const std::unordered_set<ProcessId>& recipients, Tag tag) = 0;
+    virtual Packet send(MessageType messageType, const std::string& message, const Recipients& recipients, Tag tag) = 0;
 
-    Packet send(MessageType messageType, const std::string& message, const std::unordered_set<ProcessId>& recipients) override {
+    Packet send(MessageType messageType, const std::string& message, const Recipients& recipients) override {
         return send(messageType, message, recipients, getDefaultTag());
     }
 
     virtual Packet send(MessageType messageType, const std::string& message, ProcessId recipient, Tag tag) {
-        return send(messageType, message, std::unordered_set<ProcessId> {recipient}, tag);
+        return send(messageType, message, Recipients(recipient), tag);
     };
 
     virtual Packet sendOthers(MessageType messageType, const std::string& message, Tag tag) {
-        return send(messageType, message, otherProcesses, tag);
+        return send(messageType, message, ProcessRange::allExcept(myProcessId, numberOfProcesses), tag);
     };
 
     virtual Packet receive(Tag tag) = 0;
@@ -0,0 +1,139 @@
+#include "MpiCompactCommunicator.h"
+#include <util/MessagePacking.h>
+
+static constexpr unsigned char INLINE_MESSAGE_FLAG = 0x80;
+/** First byte of a name announcement - no message type has this value **/
+static constexpr unsigned char NAME_ANNOUNCEMENT = 0x7F;
+
+MpiCompactCommunicator::MpiCompactCommunicator(int argc, char** argv) : MpiOptimizedCommunicator(argc, argv) { }
+
+void MpiCompactCommunicator::internName(std::string_view name) {
+    ObjectId objectId = toObjectId(name);
+    /** Nothing is sent with the new id before the announcement, which goes through the same (default) tag first **/
+    std::lock_guard<std::recursive_mutex> communicationLock(communicationMutex);
+    {
+        std::lock_guard<std::mutex> lock(objectsMutex);
+        auto [objectName, inserted] = objectNames.try_emplace(objectId, name);
+        if (not inserted) {
+            if (objectName->second != name) {
+                throw std::runtime_error("Names '" + objectName->second + "' and '" + std::string(name) +
+                                         "' have the same object id, rename one of them");
+            }
+            return;
+        }
+        auto remoteName = remoteObjectNames.find(objectId);
+        if (remoteName != remoteObjectNames.end()) {
+            if (remoteName->second != name) {
+                objectNames.erase(objectId);
+                throw std::runtime_error("Name '" + std::string(name) + "' has the same object id as name '" +
+                                         remoteName->second + "' of another process, rename one of them");
+            }
+            remoteObjectNames.erase(remoteName);
+        }
+    }
+    std::string announcement;
+    announcement += static_cast<char>(NAME_ANNOUNCEMENT);
+    announcement.append(reinterpret_cast<const char*>(&objectId), sizeof(ObjectId));
+    announcement.append(name);
+    for (ProcessId processId = 0; processId < numberOfProcesses; ++processId) {
+        if (processId != myProcessId) {
+            MPI_Send(announcement.data(), static_cast<int>(announcement.size()), MPI_BYTE, processId, getDefaultTag(),
+                     MPI_COMM_WORLD);
+            sentBytes += announcement.size();
+        }
+    }
+}
+
+bool MpiCompactCommunicator::receiveControlMessage(const std::string& encodedMessage, ProcessId source) {
+    if (encodedMessage.empty() or static_cast<unsigned char>(encodedMessage[0]) != NAME_ANNOUNCEMENT) {
+        return false;
+    }
+    ObjectId objectId;
+    std::memcpy(&objectId, encodedMessage.data() + 1, sizeof(ObjectId));
+    std::string_view name = std::string_view(encodedMessage).substr(1 + sizeof(ObjectId));
+    std::lock_guard<std::mutex> lock(objectsMutex);
+    auto objectName = objectNames.find(objectId);
+    if (objectName != objectNames.end()) {
+        if (objectName->second != name) {
+            throw std::runtime_error("Name '" + std::string(name) + "' of process " + std::to_string(source) +
+                                     " has the same object id as name '" + objectName->second +
+                                     "', rename one of them");
+        }
+        return true;
+    }
+    auto [remoteName, inserted] = remoteObjectNames.try_emplace(objectId, name);
+    if (not inserted and remoteName->second != name) {
+        throw std::runtime_error("Name '" + std::string(name) + "' of process " + std::to_string(source) +
+                                 " has the same object id as name '" + remoteName->second +
+                                 "' of another process, rename one of them");
+    }
+    return true;
+}
+
+std::string MpiCompactCommunicator::encode(LamportTime lamportTime, MessageType messageType, const std::string& message) {
+    std::string encodedMessage;
+    encodedMessage.reserve(1 + 10 + sizeof(ObjectId) + message.size());
+    std::optional<ObjectId> objectId;
+    if (not message.empty()) {
+        std::string_view name = extractObjectName(messageType, message);
+        ObjectId id = toObjectId(name);
+        std::lock_guard<std::mutex> lock(objectsMutex);
+        auto objectName = objectNames.find(id);
+        if (objectName != objectNames.end() and objectName->second == name) {
+            objectId = id;
+        }
+    }
+
+    auto encodedMessageType = static_cast<unsigned char>(messageType);
+    encodedMessage += static_cast<char>(objectId ? encodedMessageType : encodedMessageType | INLINE_MESSAGE_FLAG);
+    appendVarint(encodedMessage, lamportTime);
+    if (objectId) {
+        encodedMessage.append(reinterpret_cast<const char*>(&*objectId), sizeof(ObjectId));
+        if (isNamedMessage(messageType)) {
+            encodedMessage.append(extractData(message));
+        }
+    } else {
+        encodedMessage.append(message);
+    }
+    return encodedMessage;
+}
+
+Packet MpiCompactCommunicator::getPacket(const std::string& encodedMessage, ProcessId source) {
+    std::string_view encoded = encodedMessage;
+    auto encodedMessageType = static_cast<unsigned char>(encoded[0]);
+    auto messageType = static_cast<MessageType>(encodedMessageType & ~INLINE_MESSAGE_FLAG);
+    std::size_t offset = 1;
+    auto lamportTime = static_cast<LamportTime>(readVarint(encoded, offset));
+
+    std::string message;
+    if (encodedMessageType & INLINE_MESSAGE_FLAG) {
+        message = encoded.substr(offset);
+    } else {
+        ObjectId objectId;
+        std::memcpy(&objectId, encoded.data() + offset, sizeof(ObjectId));
+        std::string_view data = encoded.substr(offset + sizeof(ObjectId));
+        std::lock_guard<std::mutex> lock(objectsMutex);
+        auto objectName = objectNames.find(objectId);
+        if (objectName == objectNames.end()) {
+            throw std::runtime_error("Received a message concerning unknown object id " + std::to_string(objectId));
+        }
+        message = isNamedMessage(messageType) ? packNamedMessage(objectName->second, data) : objectName->second;
+    }
+
+    return Packet {
+            .lamportTime = lamportTime,
+            .source = source,
+            .messageType = messageType,
+            .message = std::move(message)
+    };
+}
+
+/** 32-bit FNV-1a **/
+ObjectId MpiCompactCommunicator::toObjectId(std::string_view name) {
+    ObjectId hash = 2166136261u;
+    for (char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
@@ -0,0 +1,48 @@
+#ifndef COMMUNICATION_MPICOMPACTCOMMUNICATOR_H
+#define COMMUNICATION_MPICOMPACTCOMMUNICATOR_H
+
+#include <mutex>
+#include <unordered_map>
+#include "MpiOptimizedCommunicator.h"
+
+using ObjectId = uint32_t;
+
+/**
+ * Second version of the wire format. Every packet is sent as a single MPI message:
+ * [message type - 1 byte][Lamport time - varint][object id - 4 bytes][data]
+ *
+ * Names of the objects (mutexes, CVs, monitors) announced by internName() are replaced by 32-bit identifiers, computed
+ * by hashing the name, so all processes agree on them without exchanging any messages. To detect two names with the
+ * same identifier in different processes, every process sends each name it announces to all the others once:
+ * [0x7F - 1 byte][object id - 4 bytes][name]
+ * A collision throws either in the process announcing the second name or in the receiving thread of the process
+ * receiving it, whichever comes later. Messages concerning names which were not announced carry the message as it is,
+ * marked by the highest bit of the message type:
+ * [message type | 0x80 - 1 byte][Lamport time - varint][message]
+ *
+ * Not compatible with MpiSimpleCommunicator nor MpiOptimizedCommunicator - all processes have to use the same one.
+ */
+class MpiCompactCommunicator : public MpiOptimizedCommunicator {
+public:
+
+    MpiCompactCommunicator(int argc, char** argv);
+
+    void internName(std::string_view name) override;
+
+protected:
+
+    std::string encode(LamportTime lamportTime, MessageType messageType, const std::string& message) override;
+
+    Packet getPacket(const std::string& encodedMessage, ProcessId source) override;
+
+    bool receiveControlMessage(const std::string& encodedMessage, ProcessId source) override;
+
+    static ObjectId toObjectId(std::string_view name);
+
+    std::unordered_map<ObjectId, std::string> objectNames;
+    /** Names announced by other processes which this process has not announced (yet) **/
+    std::unordered_map<ObjectId, std::string> remoteObjectNames;
+    std::mutex objectsMutex;
+};
+
+#endif //COMMUNICATION_MPICOMPACTCOMMUNICATOR_H
@@ -1,14 +1,15 @@
 #include "MpiOptimizedCommunicator.h"
 
 Packet MpiOptimizedCommunicator::send(MessageType messageType, const std::string& message,
-                                      const std::unordered_set<ProcessId>& recipients, MpiTag tag) {
+                                      const Recipients& recipients, MpiTag tag) {
 
     std::lock_guard<std::recursive_mutex> lock(communicationMutex);
     std::string finalMessage = encode(++currentLamportTime, messageType, message);
 
-    for (ProcessId recipient : recipients) {
+    recipients.forEach([&](ProcessId recipient) {
         MPI_Send(finalMessage.c_str(), static_cast<int>(finalMessage.size()), MPI_BYTE, recipient, tag, MPI_COMM_WORLD);
-    }
+        sentBytes += finalMessage.size();
+    });
 
     return Packet {
             .lamportTime = currentLamportTime,
@@ -19,20 +20,25 @@ Packet MpiOptimizedCommunicator::send(MessageType messageType, const std::string
 }
 
 Packet MpiOptimizedCommunicator::receive(MpiTag tag) {
-    MPI_Status status;
-    int messageLength;
-
-    MPI_Probe(MPI_ANY_SOURCE, tag, MPI_COMM_WORLD, &status);
-    MPI_Get_count(&status, MPI_BYTE, &messageLength);
-
-    ProcessId source = status.MPI_SOURCE;
-    std::string message;
-    message.resize(static_cast<unsigned long>(messageLength));
-    MPI_Recv(message.data(), messageLength, MPI_BYTE, source, tag, MPI_COMM_WORLD, &status);
-
-    Packet packet = getPacket(message, source);
-    updateTimestamp(packet);
-    return packet;
+    while (true) {
+        MPI_Status status;
+        int messageLength;
+
+        MPI_Probe(MPI_ANY_SOURCE, tag, MPI_COMM_WORLD, &status);
+        MPI_Get_count(&status, MPI_BYTE, &messageLength);
+
+        ProcessId source = status.MPI_SOURCE;
+        std::string message;
+        message.resize(static_cast<unsigned long>(messageLength));
+        MPI_Recv(message.data(), messageLength, MPI_BYTE, source, status.MPI_TAG, MPI_COMM_WORLD, &status);
+        if (receiveControlMessage(message, source)) {
+            continue;
+        }
+
+        Packet packet = getPacket(message, source);
+        updateTimestamp(packet);
+        return packet;
+    }
 }
 
 std::optional<Packet> MpiOptimizedCommunicator::receive(long timeoutMillis, MpiTag tag) {
@@ -41,24 +47,33 @@ std::optional<Packet> MpiOptimizedCommunicator::receive(long timeoutMillis, MpiT
     int hasReceivedData;
     auto timeStarted = system_clock::now();
 
-    do {
-        MPI_Iprobe(MPI_ANY_SOURCE, tag, MPI_COMM_WORLD, &hasReceivedData, &status);
-    } while (not hasReceivedData &&
-             duration_cast<milliseconds>(system_clock::now() - timeStarted).count() < timeoutMillis);
-    if (not hasReceivedData) {
-        return std::nullopt;
+    while (true) {
+        do {
+            MPI_Iprobe(MPI_ANY_SOURCE, tag, MPI_COMM_WORLD, &hasReceivedData, &status);
+        } while (not hasReceivedData &&
+                 duration_cast<milliseconds>(system_clock::now() - timeStarted).count() < timeoutMillis);
+        if (not hasReceivedData) {
+            return std::nullopt;
+        }
+
+        ProcessId source = status.MPI_SOURCE;
+        int messageLength;
+        MPI_Get_count(&status, MPI_BYTE, &messageLength);
+        std::string message;
+        message.resize(static_cast<unsigned long>(messageLength));
+        MPI_Recv(message.data(), messageLength, MPI_BYTE, source, status.MPI_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        if (receiveControlMessage(message, source)) {
+            continue;
+        }
+
+        Packet packet = getPacket(message, source);
+        updateTimestamp(packet);
+        return packet;
     }
+}
 
-    ProcessId source = status.MPI_SOURCE;
-    int messageLength;
-    MPI_Get_count(&status, MPI_BYTE, &messageLength);
-    std::string message;
-    message.resize(static_cast<unsigned long>(messageLength));
-    MPI_Recv(message.data(), messageLength, MPI_BYTE, source, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-
-    Packet packet = getPacket(message, source);
-    updateTimestamp(packet);
-    return packet;
+bool MpiOptimizedCommunicator::receiveControlMessage(const std::string& encodedMessage, ProcessId source) {
+    return false;
 }
 
 std::string MpiOptimizedCommunicator::encode(LamportTime lamportTime, MessageType messageType, const std::string& message) {
@@ -81,16 +96,13 @@ Packet MpiOptimizedCommunicator::getPacket(const std::string& encodedMessage, Pr
             .lamportTime = lamportTime,
             .source = source,
             .messageType = messageType,
-            .message = encodedMessage.substr(headerSize)
+            .message = std::string_view(encodedMessage).substr(headerSize)
     };
 }
 
 void MpiOptimizedCommunicator::updateTimestamp(Packet& packet) {
-    {
-        std::lock_guard<std::recursive_mutex> lock(communicationMutex);
-        currentLamportTime = std::max(packet.lamportTime, currentLamportTime) + 1;
-    }
-    packet.lamportTime = currentLamportTime;
+    std::lock_guard<std::recursive_mutex> lock(communicationMutex);
+    currentLamportTime = std::max(packet.lamportTime, currentLamportTime) + 1;
 }
 
 MpiOptimizedCommunicator::MpiOptimizedCommunicator(int argc, char** argv) : MpiSimpleCommunicator(argc, argv) { }
@@ -8,7 +8,9 @@ public:
 
     MpiOptimizedCommunicator(int argc, char** argv);
 
-    Packet send(MessageType messageType, const std::string& message, const std::unordered_set<ProcessId>& recipients, MpiTag tag) override;
+    using MpiSimpleCommunicator::send;
+
+    Packet send(MessageType messageType, const std::string& message, const Recipients& recipients, MpiTag tag) override;
 
     Packet receive(MpiTag tag) override;
 
@@ -16,9 +18,12 @@ public:
 
 protected:
 
-    static std::string encode(LamportTime lamportTime, MessageType messageType, const std::string& message);
+    virtual std::string encode(LamportTime lamportTime, MessageType messageType, const std::string& message);
+
+    virtual Packet getPacket(const std::string& encodedMessage, ProcessId source);
 
-    static Packet getPacket(const std::string& encodedMessage, ProcessId source);
+    /** Handles a message sent by the communicator itself rather than by its user. Returns true if it was one. **/
+    virtual bool receiveControlMessage(const std::string& encodedMessage, ProcessId source);
 
     void updateTimestamp(Packet& packet);
 };
@@ -1,8 +1,8 @@
 #include "MpiSimpleCommunicator.h"
 #include <iostream>
 
-Packet MpiSimpleCommunicator::send(MessageType messageType, const std::string& message,
-                                   const std::unordered_set<ProcessId>& recipients, MpiTag tag) {
+Packet MpiSimpleCommunicator::send(MessageType messageType, const std::string& message, const Recipients& recipients,
+                                   MpiTag tag) {
 
     std::lock_guard<std::recursive_mutex> lock(communicationMutex);
 
@@ -12,12 +12,15 @@ Packet MpiSimpleCommunicator::send(MessageType messageType, const std::string& m
             .nextPacketLength = static_cast<EncodedNextPacketLength>(message.size()),
     };
 
-    for (ProcessId recipient : recipients) {
+    int rawPacketSize;
+    MPI_Type_size(mpiRawPacketType, &rawPacketSize);
+    recipients.forEach([&](ProcessId recipient) {
         MPI_Send(&rawPacket, 1, mpiRawPacketType, recipient, tag, MPI_COMM_WORLD);
         if (not message.empty()) {
             MPI_Send(message.c_str(), static_cast<int>(message.size()), MPI_CHAR, recipient, tag, MPI_COMM_WORLD);
         }
-    }
+        sentBytes += static_cast<std::size_t>(rawPacketSize) + message.size();
+    });
 
     Packet packet {
             .lamportTime = rawPacket.lamportTime,
@@ -33,19 +36,7 @@ Packet MpiSimpleCommunicator::receive(MpiTag tag) {
     MPI_Status status;
     RawPacket rawPacket;
     MPI_Recv(&rawPacket, 1, mpiRawPacketType, MPI_ANY_SOURCE, tag, MPI_COMM_WORLD, &status);
-    ProcessId source = status.MPI_SOURCE;
-
-    std::string message;
-    uint32_t messageLength = rawPacket.nextPacketLength;
-    if (messageLength > 0) {
-        message.resize(messageLength);
-        MPI_Recv(message.data(), messageLength, MPI_CHAR, source, tag, MPI_COMM_WORLD, &status);
-    }
-    {
-        std::lock_guard<std::recursive_mutex> lock(communicationMutex);
-        currentLamportTime = std::max(rawPacket.lamportTime, currentLamportTime) + 1;
-    }
-    return toPacket(rawPacket, source, message);
+    return receiveMessage(rawPacket, status.MPI_SOURCE, status.MPI_TAG);
 }
 
 Packet MpiSimpleCommunicator::receive() {
@@ -73,32 +64,26 @@ std::optional<Packet> MpiSimpleCommunicator::receive(long timeoutMillis, MpiTag
         }
     }
 
-    ProcessId source = status.MPI_SOURCE;
-    std::string message;
+    return receiveMessage(rawPacket, status.MPI_SOURCE, status.MPI_TAG);
+}
+
+/**
+ * The sender sends the message right after its header, so once the header has been received the message is waited for
+ * without any timeout - giving up on it would leave it to be mistaken for the header of the next packet.
+ * The message is received directly into the packet's payload.
+ */
+Packet MpiSimpleCommunicator::receiveMessage(const RawPacket& rawPacket, ProcessId source, MpiTag tag) {
     uint32_t messageLength = rawPacket.nextPacketLength;
-    message.resize(messageLength);
-    if (messageLength > 0) {
-        {
-            MPI_Request request;
-            MPI_Irecv(message.data(), messageLength, MPI_CHAR, source, tag, MPI_COMM_WORLD, &request);
-
-            do {
-                MPI_Test(&request, &hasReceivedData, &status);
-            } while (not hasReceivedData and
-                     duration_cast<milliseconds>(system_clock::now() - timeStarted).count() < timeoutMillis);
-            if (not hasReceivedData) {
-                MPI_Cancel(&request);
-                MPI_Request_free(&request);
-                return std::nullopt;
-            }
+    Payload message = Payload::create(messageLength, [&](char* data) {
+        if (messageLength > 0) {
+            MPI_Recv(data, static_cast<int>(messageLength), MPI_CHAR, source, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
         }
-    }
-
+    });
     {
         std::lock_guard<std::recursive_mutex> lock(communicationMutex);
         currentLamportTime = std::max(rawPacket.lamportTime, currentLamportTime) + 1;
     }
-    return toPacket(rawPacket, source, message);
+    return toPacket(rawPacket, source, std::move(message));
 }
 
 std::optional<Packet> MpiSimpleCommunicator::receive(long timeoutMillis) {
@@ -134,18 +119,10 @@ MpiSimpleCommunicator::MpiSimpleCommunicator(int argc, char** argv) {
                                                    "You need to take care of synchronization yourself." << std::endl;
     }
 
-    /************ Fill 'otherProcesses' structure with their ranks ************/
-    for (ProcessId id = 0; id < numberOfProcesses; ++id) {
-        if (id != myProcessId) {
-            otherProcesses.insert(id);
-        }
-    }
-    /**************************************************************************/
-
     currentLamportTime = 0;
 }
 
-Packet MpiSimpleCommunicator::toPacket(RawPacket rawPacket, ProcessId source, std::string message) {
+Packet MpiSimpleCommunicator::toPacket(RawPacket rawPacket, ProcessId source, Payload message) {
     return Packet {
             .lamportTime = static_cast<LamportTime>(rawPacket.lamportTime),
             .source = source,
@@ -159,6 +136,11 @@ LamportTime MpiSimpleCommunicator::getCurrentLamportTime() {
     return currentLamportTime;
 }
 
+std::size_t MpiSimpleCommunicator::getSentBytes() {
+    std::lock_guard<std::recursive_mutex> lock(communicationMutex);
+    return sentBytes;
+}
+
 MpiSimpleCommunicator::~MpiSimpleCommunicator() {
     MPI_Finalize();
 }
@@ -45,7 +45,9 @@ using MpiTag = int;
 class MpiSimpleCommunicator : public ITaggedCommunicator<MpiTag> {
 public:
 
-    Packet send(MessageType messageType, const std::string& message, const std::unordered_set<ProcessId>& recipients, MpiTag tag) override;
+    using ITaggedCommunicator<MpiTag>::send;
+
+    Packet send(MessageType messageType, const std::string& message, const Recipients& recipients, MpiTag tag) override;
 
     Packet receive(MpiTag tag) override;
 
@@ -59,16 +61,22 @@ public:
 
     LamportTime getCurrentLamportTime() override;
 
+    std::size_t getSentBytes() override;
+
     MpiSimpleCommunicator(int argc, char** argv);
 
     virtual ~MpiSimpleCommunicator();
 
 protected:
 
-    static Packet toPacket(RawPacket rawPacket, ProcessId source, std::string message);
+    Packet receiveMessage(const RawPacket& rawPacket, ProcessId source, MpiTag tag);
+
+    static Packet toPacket(RawPacket rawPacket, ProcessId source, Payload message);
 
     MPI_Datatype mpiRawPacketType;
     std::recursive_mutex communicationMutex;
+    /** Protected by communicationMutex **/
+    std::size_t sentBytes = 0;
 };
 
 #endif //COMMUNICATION_MPISIMPLECOMMUNICATOR_H
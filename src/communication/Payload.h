@@ -0,0 +1,174 @@
+#ifndef COMMUNICATION_PAYLOAD_H
+#define COMMUNICATION_PAYLOAD_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/**
+ * Message carried by a packet. Control messages - a name of an object and a few numbers - are stored inline, so
+ * receiving and copying them does not allocate. Longer messages (SYNC with a large state) are kept in a single
+ * reference counted allocation shared by all copies of the packet. The content never changes once created.
+ */
+class Payload {
+public:
+
+    static constexpr std::size_t INLINE_CAPACITY = 28;
+
+    Payload() = default;
+
+    Payload(std::string_view message) : Payload(create(message.size(), [&](char* content) {
+        message.copy(content, message.size());
+    })) { }
+
+    Payload(const std::string& message) : Payload(std::string_view(message)) { }
+
+    Payload(const char* message) : Payload(std::string_view(message)) { }
+
+    /**
+     * Creates a payload of the given length, letting 'fill' write its content directly into the final storage.
+     * 'fill' is called with a pointer to 'length' writable bytes.
+     */
+    template <typename Fill>
+    static Payload create(std::size_t length, Fill fill) {
+        Payload payload;
+        payload.length = static_cast<std::uint32_t>(length);
+        if (payload.isInline()) {
+            fill(payload.storage);
+        } else {
+            payload.setSharedBuffer(SharedBuffer::allocate(length));
+            fill(payload.sharedBuffer()->content());
+        }
+        return payload;
+    }
+
+    Payload(const Payload& other) : length(other.length) {
+        std::memcpy(storage, other.storage, INLINE_CAPACITY);
+        if (not isInline()) {
+            sharedBuffer()->references.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /** Leaves 'other' empty **/
+    Payload(Payload&& other) noexcept : length(other.length) {
+        std::memcpy(storage, other.storage, INLINE_CAPACITY);
+        other.length = 0;
+    }
+
+    Payload& operator=(const Payload& other) {
+        Payload copy(other);
+        return *this = std::move(copy);
+    }
+
+    Payload& operator=(Payload&& other) noexcept {
+        if (this != &other) {
+            clear();
+            std::memcpy(storage, other.storage, INLINE_CAPACITY);
+            length = other.length;
+            other.length = 0;
+        }
+        return *this;
+    }
+
+    ~Payload() {
+        clear();
+    }
+
+    const char* data() const {
+        return isInline() ? storage : sharedBuffer()->content();
+    }
+
+    std::size_t size() const {
+        return length;
+    }
+
+    bool empty() const {
+        return length == 0;
+    }
+
+    operator std::string_view() const {
+        return {data(), length};
+    }
+
+    std::string str() const {
+        return std::string(data(), length);
+    }
+
+    /** Drops the last 'count' bytes. A shared message short enough to fit afterwards is moved inline. **/
+    void removeSuffix(std::size_t count) {
+        auto newLength = static_cast<std::uint32_t>(length - count);
+        if (isInline() or newLength > INLINE_CAPACITY) {
+            length = newLength;
+            return;
+        }
+        SharedBuffer* buffer = sharedBuffer();
+        std::memcpy(storage, buffer->content(), newLength);
+        length = newLength;
+        SharedBuffer::release(buffer);
+    }
+
+    bool operator==(const Payload& other) const {
+        return std::string_view(*this) == std::string_view(other);
+    }
+
+    bool operator!=(const Payload& other) const {
+        return not (*this == other);
+    }
+
+private:
+
+    /** Reference counter followed by the content, allocated together as a single block **/
+    struct SharedBuffer {
+        std::atomic<std::uint32_t> references {1};
+
+        char* content() {
+            return reinterpret_cast<char*>(this + 1);
+        }
+
+        static SharedBuffer* allocate(std::size_t length) {
+            return new (::operator new(sizeof(SharedBuffer) + length)) SharedBuffer();
+        }
+
+        static void release(SharedBuffer* buffer) {
+            if (buffer->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                buffer->~SharedBuffer();
+                ::operator delete(buffer);
+            }
+        }
+    };
+
+    bool isInline() const {
+        return length <= INLINE_CAPACITY;
+    }
+
+    SharedBuffer* sharedBuffer() const {
+        SharedBuffer* buffer;
+        std::memcpy(&buffer, storage, sizeof(buffer));
+        return buffer;
+    }
+
+    void setSharedBuffer(SharedBuffer* buffer) {
+        std::memcpy(storage, &buffer, sizeof(buffer));
+    }
+
+    void clear() {
+        if (not isInline()) {
+            SharedBuffer::release(sharedBuffer());
+        }
+        length = 0;
+    }
+
+    /** Either the message itself or a pointer to the shared buffer holding it, depending on the length **/
+    alignas(SharedBuffer*) char storage[INLINE_CAPACITY] {};
+    std::uint32_t length = 0;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const Payload& payload) {
+    return os << std::string_view(payload);
+}
+
+#endif //COMMUNICATION_PAYLOAD_H
@@ -0,0 +1,160 @@
+#ifndef COMMUNICATION_RECIPIENTS_H
+#define COMMUNICATION_RECIPIENTS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+#include <util/Define.h>
+
+/**
+ * A set of processes stored as a bitmap - one bit per process. Meant to be kept between messages (e.g. as a part of a
+ * mutex state), so that neither filling it nor sending to it allocates.
+ */
+class ProcessSet {
+public:
+
+    ProcessSet() = default;
+
+    explicit ProcessSet(std::size_t numberOfProcesses) : words((numberOfProcesses + WORD_BITS - 1) / WORD_BITS, 0) { }
+
+    void insert(ProcessId processId) {
+        auto index = static_cast<std::size_t>(processId) / WORD_BITS;
+        if (index >= words.size()) {
+            words.resize(index + 1, 0);
+        }
+        std::uint64_t& word = words[index];
+        std::uint64_t bit = bitOf(processId);
+        if ((word & bit) == 0) {
+            word |= bit;
+            ++count;
+        }
+    }
+
+    void erase(ProcessId processId) {
+        if (contains(processId)) {
+            words[static_cast<std::size_t>(processId) / WORD_BITS] &= ~bitOf(processId);
+            --count;
+        }
+    }
+
+    [[nodiscard]] bool contains(ProcessId processId) const {
+        auto index = static_cast<std::size_t>(processId) / WORD_BITS;
+        return index < words.size() and (words[index] & bitOf(processId)) != 0;
+    }
+
+    /** Keeps the memory, so that the set can be filled again without allocating **/
+    void clear() {
+        std::fill(words.begin(), words.end(), 0);
+        count = 0;
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return count;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return count == 0;
+    }
+
+    /** Calls 'function' with every process of the set, in ascending order **/
+    template <typename Function>
+    void forEach(Function function) const {
+        for (std::size_t index = 0; index < words.size(); ++index) {
+            for (std::uint64_t word = words[index]; word != 0; word &= word - 1) {
+                function(static_cast<ProcessId>(index * WORD_BITS + static_cast<std::size_t>(__builtin_ctzll(word))));
+            }
+        }
+    }
+
+private:
+
+    static constexpr std::size_t WORD_BITS = 64;
+
+    static std::uint64_t bitOf(ProcessId processId) {
+        return std::uint64_t {1} << (static_cast<std::size_t>(processId) % WORD_BITS);
+    }
+
+    std::vector<std::uint64_t> words;
+    std::size_t count = 0;
+};
+
+/** Processes from 'first' up to, but excluding, 'last' - without 'excluded' **/
+struct ProcessRange {
+    static constexpr ProcessId NO_PROCESS = -1;
+
+    ProcessId first;
+    ProcessId last;
+    ProcessId excluded = NO_PROCESS;
+
+    /** All processes but the given one - e.g. all but myself **/
+    static ProcessRange allExcept(ProcessId excluded, ProcessId numberOfProcesses) {
+        return {0, numberOfProcesses, excluded};
+    }
+};
+
+/**
+ * Recipients of a message - a single process, a range of processes, a ProcessSet or an std::unordered_set. Only refers
+ * to the given set, so it is as cheap to pass around as the set itself and sending to any of them does not allocate.
+ */
+class Recipients {
+public:
+
+    Recipients(ProcessId recipient) : range {recipient, recipient + 1} { }
+
+    Recipients(ProcessRange range) : range(range) { }
+
+    Recipients(const ProcessSet& processSet) : processSet(&processSet) { }
+
+    Recipients(const std::unordered_set<ProcessId>& processes) : processes(&processes) { }
+
+    /** Calls 'function' with every recipient **/
+    template <typename Function>
+    void forEach(Function function) const {
+        if (processSet) {
+            processSet->forEach(function);
+        } else if (processes) {
+            for (ProcessId processId : *processes) {
+                function(processId);
+            }
+        } else {
+            for (ProcessId processId = range.first; processId < range.last; ++processId) {
+                if (processId != range.excluded) {
+                    function(processId);
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] bool contains(ProcessId processId) const {
+        if (processSet) {
+            return processSet->contains(processId);
+        }
+        if (processes) {
+            return processes->find(processId) != processes->end();
+        }
+        return processId >= range.first and processId < range.last and processId != range.excluded;
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        if (processSet) {
+            return processSet->size();
+        }
+        if (processes) {
+            return processes->size();
+        }
+        if (range.last <= range.first) {
+            return 0;
+        }
+        bool excludedInRange = range.excluded >= range.first and range.excluded < range.last;
+        return static_cast<std::size_t>(range.last - range.first) - (excludedInRange ? 1 : 0);
+    }
+
+private:
+
+    ProcessRange range {0, 0};
+    const ProcessSet* processSet = nullptr;
+    const std::unordered_set<ProcessId>* processes = nullptr;
+};
+
+#endif //COMMUNICATION_RECIPIENTS_H
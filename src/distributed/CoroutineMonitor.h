@@ -0,0 +1,417 @@
+#ifndef DISTRIBUTEDMONITOR_COROUTINEMONITOR_H
+#define DISTRIBUTEDMONITOR_COROUTINEMONITOR_H
+
+#if not defined(__cpp_impl_coroutine)
+#error "CoroutineMonitor.h requires C++20 coroutines"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "DistributedConditionVariable.h"
+#include "DistributedMonitor.h"
+
+/**
+ * Monitor entries written as C++20 coroutines, so that thousands of clients of a process can wait for mutexes and
+ * notifications without a thread each. The rest of the library is C++17 - only the programs including this header
+ * have to be compiled as C++20.
+ *
+ * A suspended coroutine is resumed by the thread which completes its wait (usually the receiving thread) handing it
+ * over to a CoroutineScheduler, which runs it on one of its own threads.
+ */
+
+class CoroutineScheduler;
+
+template <typename Result>
+class Task;
+
+namespace coroutine_detail {
+
+    template <typename Result>
+    struct ResultHolder {
+        void return_value(Result value) {
+            result.emplace(std::move(value));
+        }
+
+        Result takeResult() {
+            return std::move(*result);
+        }
+
+        std::optional<Result> result;
+    };
+
+    template <>
+    struct ResultHolder<void> {
+        void return_void() { }
+
+        void takeResult() { }
+    };
+
+    /** Started by CoroutineScheduler::spawn, destroys itself when it ends **/
+    struct SpawnedTask {
+        struct promise_type {
+            SpawnedTask get_return_object() {
+                return {std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            std::suspend_always initial_suspend() noexcept {
+                return {};
+            }
+
+            std::suspend_never final_suspend() noexcept {
+                return {};
+            }
+
+            void return_void() { }
+
+            void unhandled_exception() {
+                std::terminate();
+            }
+        };
+
+        std::coroutine_handle<promise_type> coroutine;
+    };
+}
+
+/**
+ * Coroutine returning a Result (or nothing), started when it is awaited - the awaiting coroutine is resumed when it
+ * ends, with its result or exception. Tasks which are not awaited by other coroutines are started with
+ * CoroutineScheduler::spawn.
+ */
+template <typename Result = void>
+class [[nodiscard]] Task {
+public:
+
+    struct promise_type : coroutine_detail::ResultHolder<Result> {
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        /** Resumes the awaiting coroutine in place of the ended one **/
+        auto final_suspend() noexcept {
+            struct ContinuationAwaiter {
+                bool await_ready() noexcept {
+                    return false;
+                }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> coroutine) noexcept {
+                    return coroutine.promise().continuation;
+                }
+
+                void await_resume() noexcept { }
+            };
+            return ContinuationAwaiter {};
+        }
+
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+        std::exception_ptr exception;
+    };
+
+    Task(Task&& other) noexcept : coroutine(std::exchange(other.coroutine, nullptr)) { }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            coroutine = std::exchange(other.coroutine, nullptr);
+        }
+        return *this;
+    }
+
+    ~Task() {
+        destroy();
+    }
+
+    auto operator co_await() && noexcept {
+        struct TaskAwaiter {
+            bool await_ready() noexcept {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                coroutine.promise().continuation = awaiting;
+                return coroutine;
+            }
+
+            Result await_resume() {
+                if (coroutine.promise().exception) {
+                    std::rethrow_exception(coroutine.promise().exception);
+                }
+                return coroutine.promise().takeResult();
+            }
+
+            std::coroutine_handle<promise_type> coroutine;
+        };
+        return TaskAwaiter {coroutine};
+    }
+
+private:
+
+    explicit Task(std::coroutine_handle<promise_type> coroutine) : coroutine(coroutine) { }
+
+    void destroy() {
+        if (coroutine) {
+            coroutine.destroy();
+        }
+    }
+
+    std::coroutine_handle<promise_type> coroutine;
+};
+
+/**
+ * Resumes coroutines on a fixed number of threads. Every thread has its own queue - coroutines scheduled by one of them
+ * are queued there, others are spread over the queues in turn. A thread with an empty queue steals the most recently
+ * queued coroutine of another one before going to sleep.
+ *
+ * All spawned tasks have to end (see wait) before the scheduler is destroyed.
+ */
+class CoroutineScheduler {
+public:
+
+    explicit CoroutineScheduler(std::size_t numberOfThreads = std::max(std::thread::hardware_concurrency(), 1U)) {
+        for (std::size_t worker = 0; worker < numberOfThreads; ++worker) {
+            workers.push_back(std::make_unique<Worker>());
+        }
+        for (std::size_t worker = 0; worker < numberOfThreads; ++worker) {
+            workers[worker]->thread = std::thread([this, worker]() {
+                run(worker);
+            });
+        }
+    }
+
+    ~CoroutineScheduler() {
+        {
+            std::lock_guard<std::mutex> guard(idleMutex);
+            stopping = true;
+        }
+        idle.notify_all();
+        for (const auto& worker : workers) {
+            worker->thread.join();
+        }
+    }
+
+    /** Can be called by any thread **/
+    void schedule(std::coroutine_handle<> coroutine) {
+        std::size_t index = currentScheduler == this ? currentWorker : nextWorker++ % workers.size();
+        {
+            std::lock_guard<std::mutex> guard(workers[index]->mutex);
+            workers[index]->coroutines.push_back(coroutine);
+        }
+        {
+            std::lock_guard<std::mutex> guard(idleMutex);
+            ++queuedCoroutines;
+        }
+        idle.notify_one();
+    }
+
+    /** Starts the task on one of the threads. The first exception thrown by a spawned task is rethrown by wait() **/
+    void spawn(Task<void> task) {
+        {
+            std::lock_guard<std::mutex> guard(tasksMutex);
+            ++runningTasks;
+        }
+        schedule(runSpawned(std::move(task)).coroutine);
+    }
+
+    /** Accessed by Main Thread - blocks until all spawned tasks end **/
+    void wait() {
+        std::unique_lock<std::mutex> lock(tasksMutex);
+        tasksEnded.wait(lock, [this]() { return runningTasks == 0; });
+        if (exception) {
+            std::rethrow_exception(std::exchange(exception, nullptr));
+        }
+    }
+
+    [[nodiscard]] std::size_t getNumberOfThreads() const {
+        return workers.size();
+    }
+
+private:
+
+    struct Worker {
+        std::deque<std::coroutine_handle<>> coroutines;
+        std::mutex mutex;
+        std::thread thread;
+    };
+
+    coroutine_detail::SpawnedTask runSpawned(Task<void> task) {
+        std::exception_ptr taskException;
+        try {
+            co_await std::move(task);
+        } catch (...) {
+            taskException = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> guard(tasksMutex);
+            if (taskException and not exception) {
+                exception = taskException;
+            }
+            --runningTasks;
+        }
+        tasksEnded.notify_all();
+    }
+
+    void run(std::size_t index) {
+        currentScheduler = this;
+        currentWorker = index;
+        while (true) {
+            if (std::coroutine_handle<> coroutine = take(index)) {
+                coroutine.resume();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(idleMutex);
+            idle.wait(lock, [this]() { return queuedCoroutines > 0 or stopping; });
+            if (stopping and queuedCoroutines == 0) {
+                return;
+            }
+        }
+    }
+
+    /** Takes the oldest coroutine of its own queue, or steals the newest one of another queue **/
+    std::coroutine_handle<> take(std::size_t index) {
+        for (std::size_t offset = 0; offset < workers.size(); ++offset) {
+            Worker& worker = *workers[(index + offset) % workers.size()];
+            std::lock_guard<std::mutex> guard(worker.mutex);
+            if (worker.coroutines.empty()) {
+                continue;
+            }
+            std::coroutine_handle<> coroutine;
+            if (offset == 0) {
+                coroutine = worker.coroutines.front();
+                worker.coroutines.pop_front();
+            } else {
+                coroutine = worker.coroutines.back();
+                worker.coroutines.pop_back();
+            }
+            --queuedCoroutines;
+            return coroutine;
+        }
+        return nullptr;
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<std::size_t> nextWorker = 0;
+    /** Coroutines in all queues - incremented under idleMutex, so that a thread going to sleep does not miss one **/
+    std::atomic<std::size_t> queuedCoroutines = 0;
+    std::mutex idleMutex;
+    std::condition_variable idle;
+    bool stopping = false;
+
+    std::size_t runningTasks = 0;
+    std::exception_ptr exception;
+    std::mutex tasksMutex;
+    std::condition_variable tasksEnded;
+
+    static inline thread_local CoroutineScheduler* currentScheduler = nullptr;
+    static inline thread_local std::size_t currentWorker = 0;
+};
+
+/**
+ * DistributedMonitor whose entries are coroutines:
+ *
+ *     Task<> produce() {
+ *         auto sync = co_await synchronized();
+ *         co_await wait(notFull, [this]() { return count < capacity; });
+ *         ...
+ *     }
+ *
+ * Awaiting the mutex or a notification suspends the coroutine instead of blocking its thread. It is resumed by the
+ * scheduler once the mutex is locked again. The mutex is acquired with DistributedMutex::lockAsync, so the exclusion
+ * algorithm has to acquire it asynchronously (see IDistributedExclusionAlgorithm::supportsAsyncAcquire - e.g.
+ * RicartAgrawalaExclusionAlgorithm without direct receive) and condition variables have to support waitAsync
+ * (MonitorStateConditionVariableAlgorithm).
+ */
+class CoroutineMonitor : public DistributedMonitor {
+public:
+
+    CoroutineMonitor(const std::string& name,
+                     std::shared_ptr<CommunicationManager> communicationManager,
+                     const std::shared_ptr<IDistributedExclusionAlgorithm>& mutexAlgorithm,
+                     CoroutineScheduler& scheduler)
+
+            : DistributedMonitor(name, std::move(communicationManager), mutexAlgorithm), scheduler(scheduler) {
+
+        if (not mutexAlgorithm->supportsAsyncAcquire()) {
+            throw std::runtime_error("CoroutineMonitor '" + name + "' requires an exclusion algorithm acquiring the "
+                                     "mutex asynchronously");
+        }
+    }
+
+protected:
+
+    struct SynchronizedAwaiter {
+        bool await_ready() noexcept {
+            return false;
+        }
+
+        /** The coroutine may be resumed before lockAsync returns, so the awaiter is not used after it **/
+        void await_suspend(std::coroutine_handle<> coroutine) {
+            CoroutineScheduler& coroutineScheduler = monitor.scheduler;
+            monitor.mutex.lockAsync([&coroutineScheduler, coroutine]() {
+                coroutineScheduler.schedule(coroutine);
+            });
+        }
+
+        /** The mutex has been locked by the thread which scheduled the coroutine **/
+        std::unique_ptr<DistributedMonitorHelper> await_resume() {
+            monitor.mutex.adopt();
+            return monitor.adoptSynchronized();
+        }
+
+        CoroutineMonitor& monitor;
+    };
+
+    struct WaitAwaiter {
+        /** The mutex is held, so the predicate can be checked before suspending **/
+        bool await_ready() {
+            return predicate();
+        }
+
+        void await_suspend(std::coroutine_handle<> coroutine) {
+            CoroutineScheduler& coroutineScheduler = monitor.scheduler;
+            conditionVariable.waitAsync(monitor.mutex, std::move(predicate), waitClass,
+                                        [&coroutineScheduler, coroutine]() {
+                                            coroutineScheduler.schedule(coroutine);
+                                        });
+        }
+
+        void await_resume() noexcept {
+            monitor.mutex.adopt();
+        }
+
+        CoroutineMonitor& monitor;
+        DistributedConditionVariable& conditionVariable;
+        Predicate predicate;
+        WaitClass waitClass;
+    };
+
+    /** co_await it at the beginning of the entries - the counterpart of DistributedMonitor::synchronized() **/
+    SynchronizedAwaiter synchronized() {
+        return {*this};
+    }
+
+    /** co_await it instead of DistributedConditionVariable::wait() - the mutex is held again when it is resumed **/
+    WaitAwaiter wait(DistributedConditionVariable& conditionVariable, Predicate predicate,
+                     WaitClass waitClass = ANY_WAIT_CLASS) {
+        return {*this, conditionVariable, std::move(predicate), waitClass};
+    }
+
+    CoroutineScheduler& scheduler;
+};
+
+#endif //DISTRIBUTEDMONITOR_COROUTINEMONITOR_H
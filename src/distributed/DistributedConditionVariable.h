@@ -1,6 +1,7 @@
 #ifndef DISTRIBUTEDMONITOR_DISTRIBUTEDCONDITIONVARIABLE_H
 #define DISTRIBUTEDMONITOR_DISTRIBUTEDCONDITIONVARIABLE_H
 
+#include <chrono>
 #include <algorithms/IDistributedConditionVariableAlgorithm.h>
 #include "DistributedMutex.h"
 
@@ -16,15 +17,49 @@ public:
         algorithm->unregisterCV(name);
     }
 
-    void wait(DistributedMutex& mutex, const Predicate& predicate) {
-        if (not mutex.isOwned()) {
+    /**
+     * Processes waiting for different things on one CV (e.g. producers and consumers) can tell it by the wait class,
+     * so that notify_one() of that class does not wake up a process which would have to wait again.
+     */
+    void wait(DistributedMutex& mutex, const Predicate& predicate, WaitClass waitClass = ANY_WAIT_CLASS) {
+        if (not mutex.isLockedByThisThread()) {
             throw std::runtime_error("Cannot wait on mutex that is not locked!");
         }
-        algorithm->wait(name, mutex, predicate);
+        algorithm->wait(name, mutex, predicate, waitClass);
     }
 
-    void notify_one() {
-        algorithm->notifyOne(name);
+    /** Returns what the predicate returns when it stops waiting, the mutex is locked again either way **/
+    template <typename Rep, typename Period>
+    bool wait_for(DistributedMutex& mutex, const std::chrono::duration<Rep, Period>& timeout,
+                  const Predicate& predicate, WaitClass waitClass = ANY_WAIT_CLASS) {
+        return wait_until(mutex, std::chrono::steady_clock::now() + timeout, predicate, waitClass);
+    }
+
+    template <typename Clock, typename Duration>
+    bool wait_until(DistributedMutex& mutex, const std::chrono::time_point<Clock, Duration>& deadline,
+                    const Predicate& predicate, WaitClass waitClass = ANY_WAIT_CLASS) {
+        if (not mutex.isLockedByThisThread()) {
+            throw std::runtime_error("Cannot wait on mutex that is not locked!");
+        }
+        Deadline steadyDeadline = std::chrono::steady_clock::now() +
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(deadline - Clock::now());
+        return algorithm->waitUntil(name, mutex, predicate, waitClass, steadyDeadline);
+    }
+
+    /**
+     * Does not block - 'onWoken' is called once the predicate holds with the mutex locked again, possibly by another
+     * thread (see IDistributedConditionVariableAlgorithm::waitAsync)
+     */
+    void waitAsync(DistributedMutex& mutex, Predicate predicate, WaitClass waitClass, std::function<void()> onWoken) {
+        if (not mutex.isLockedByThisThread()) {
+            throw std::runtime_error("Cannot wait on mutex that is not locked!");
+        }
+        algorithm->waitAsync(name, mutex, std::move(predicate), waitClass, std::move(onWoken));
+    }
+
+    /** Wakes up the earliest process waiting with the given class (or ANY_WAIT_CLASS), any process by default **/
+    void notify_one(WaitClass waitClass = ANY_WAIT_CLASS) {
+        algorithm->notifyOne(name, waitClass);
     }
 
     void notify_all() {
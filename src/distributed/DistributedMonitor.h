@@ -1,16 +1,34 @@
 #ifndef DISTRIBUTEDMONITOR_MONITOR_H
 #define DISTRIBUTEDMONITOR_MONITOR_H
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
 #include <utility>
+#include <vector>
 #include <communication/CommunicationManager.h>
 #include <algorithms/IDistributedExclusionAlgorithm.h>
 #include <algorithms/IDistributedConditionVariableAlgorithm.h>
 #include <algorithms/RicartAgrawalaExclusionAlgorithm.h>
 #include <algorithms/DistributedConditionVariableAlgorithm.h>
+#include <algorithms/MonitorStateConditionVariableAlgorithm.h>
+#include <algorithms/CentralizedConditionVariableAlgorithm.h>
+#include <algorithms/CausalConditionVariableAlgorithm.h>
+#include <util/MessagePacking.h>
 #include "DistributedMonitorHelper.h"
+#include "DistributedMonitorRegistry.h"
 
-class DistributedMonitor  {
+class DistributedMonitor : private RegisteredMonitor {
     friend DistributedMonitorHelper;
 
 public:
@@ -23,34 +41,218 @@ public:
 
         assert(name.length() <= static_cast<unsigned char>(-1));
 
-        /** Restore the state based on the SYNC message **/
-        syncSubscription = this->communicationManager->subscribe(
-                [&](const Packet& packet) {
-                    return packet.messageType == MessageType::SYNC and extractMutexName(packet.message) == mutex.getName();
-                },
-                [&](const Packet& data) {
-                    return restoreState(extractSerializedData(data.message));
-                }
-        );
+        registry = DistributedMonitorRegistry::of(this->communicationManager);
+        registry->add(mutex.getName(), this);
+        mutex.setBeforeRelease([this]() { sendUnsentState(); });
     };
 
-    virtual ~DistributedMonitor() {
-        communicationManager->unsubscribe(syncSubscription);
+    ~DistributedMonitor() override {
+        registry->remove(mutex.getName());
+        delete combiningState.load();
     }
 
 private:
 
-    static std::string_view extractMutexName(const std::string& message) {
-        return std::string_view(message).substr(1, static_cast<std::string_view::size_type>(message[0]));
+    /**
+     * Restore the state based on the SYNC message. When the mutex is not passed directly from one owner to the next one
+     * (e.g. a token forwarded by a third process), an older SYNC may arrive after a newer one - skip it.
+     */
+    void receiveState(const Packet& data) override {
+        std::string_view syncData = extractData(data.message);
+        std::uint64_t version = readNumber(syncData, 0);
+        if (version <= stateVersion) {
+            Logger::log("Skipping outdated SYNC from process " + std::to_string(data.source));
+            return;
+        }
+        stateVersion = version;
+        restoreState(registry->restoreExtensions(mutex.getName(), syncData.substr(sizeof(version))));
+    }
+
+    void publishState() override {
+        sendState();
+    }
+
+    /** Accessed by Main Thread - sends the state to other processes, the mutex has to be held **/
+    void sendState() {
+        std::string syncData;
+        appendNumber(syncData, ++stateVersion);
+        registry->saveExtensions(mutex.getName(), syncData);
+        syncData.append(saveState());
+        communicationManager->sendOthers(MessageType::SYNC, packNamedMessage(mutex.getName(), syncData));
+        sentHandOverCount = mutex.getHandOverCount();
+        if (isInBatch()) {
+            batchSentVersion = stateVersion.load();
+        }
+    }
+
+    /**
+     * Accessed by the thread releasing the mutex to other processes. An entry which hands the mutex over does not send
+     * the state, so it is sent if the mutex has been handed over since the last SYNC - e.g. when the next thread
+     * releases it by waiting on a condition variable. The batch thread sends it unless a wait on a
+     * MonitorStateConditionVariableAlgorithm CV has just sent it and no other process has changed it since.
+     */
+    void sendUnsentState() {
+        bool unsent = mutex.getHandOverCount() != sentHandOverCount;
+        if (isInBatch()) {
+            unsent = unsent or batchSentVersion != stateVersion.load();
+            batchSentVersion.reset();
+        }
+        if (unsent) {
+            sendState();
+        }
+    }
+
+    /** Operation published by a thread for the combining one (see combined) **/
+    struct CombinedOperation {
+        std::function<void()> run;
+        std::exception_ptr exception;
+        bool done = false;
+    };
+
+    struct CombiningState {
+        std::mutex combiningMutex;
+        std::condition_variable combiningDone;
+        /** Published operations, protected by combiningMutex **/
+        std::vector<CombinedOperation*> pendingOperations;
+        bool combining = false;
+        /** Accessed by the combining thread - the vectors keep their capacity between the entries **/
+        std::vector<CombinedOperation*> runningOperations;
+        std::vector<CombinedOperation*> combinedOperations;
+    };
+
+    /** Operations run by a combining thread within one entry, so that it returns in bounded time **/
+    static constexpr std::size_t MAX_COMBINED_OPERATIONS = 256;
+
+    /**
+     * Returns once the operation has been run - the calling thread runs it itself, together with the operations
+     * published in the meantime, unless another thread is doing so already
+     */
+    void combine(CombinedOperation& operation) {
+        CombiningState& state = getCombiningState();
+        std::unique_lock<std::mutex> lock(state.combiningMutex);
+        state.pendingOperations.push_back(&operation);
+        state.combiningDone.wait(lock, [&]() { return operation.done or not state.combining; });
+        if (not operation.done) {
+            state.combining = true;
+            lock.unlock();
+            try {
+                runPendingOperations(state);
+            } catch (...) {
+                lock.lock();
+                state.combining = false;
+                auto pending = std::find(state.pendingOperations.begin(), state.pendingOperations.end(), &operation);
+                if (pending != state.pendingOperations.end()) {
+                    state.pendingOperations.erase(pending);
+                }
+                finishCombinedOperations(state, &operation);
+                lock.unlock();
+                state.combiningDone.notify_all();
+                throw;
+            }
+            lock.lock();
+            state.combining = false;
+            finishCombinedOperations(state, nullptr);
+            lock.unlock();
+            state.combiningDone.notify_all();
+        }
+        if (operation.exception) {
+            std::rethrow_exception(operation.exception);
+        }
+    }
+
+    /** Accessed by the combining thread - the operations are marked done only after the entry ends **/
+    void runPendingOperations(CombiningState& state) {
+        auto sync = synchronized();
+        while (state.combinedOperations.size() < MAX_COMBINED_OPERATIONS) {
+            {
+                std::lock_guard<std::mutex> guard(state.combiningMutex);
+                if (state.pendingOperations.empty()) {
+                    break;
+                }
+                state.runningOperations.swap(state.pendingOperations);
+            }
+            for (CombinedOperation* operation : state.runningOperations) {
+                try {
+                    operation->run();
+                } catch (...) {
+                    operation->exception = std::current_exception();
+                }
+            }
+            state.combinedOperations.insert(state.combinedOperations.end(), state.runningOperations.begin(),
+                                            state.runningOperations.end());
+            state.runningOperations.clear();
+        }
+    }
+
+    /**
+     * Marks the operations taken by the combining thread done, except the failed one of the combining thread itself,
+     * the combiningMutex has to be held
+     */
+    static void finishCombinedOperations(CombiningState& state, const CombinedOperation* failed) {
+        for (auto* operations : {&state.runningOperations, &state.combinedOperations}) {
+            for (CombinedOperation* combinedOperation : *operations) {
+                combinedOperation->done = combinedOperation != failed;
+            }
+            operations->clear();
+        }
     }
 
-    static std::string extractSerializedData(const std::string& message) {
-        auto dataOffset = static_cast<std::string_view::size_type>(message[0]) + 1;
-        return message.substr(dataOffset);
+    /** Creates the combining state on the first combined entry - threads racing to do so agree on one of them **/
+    CombiningState& getCombiningState() {
+        CombiningState* current = combiningState.load(std::memory_order_acquire);
+        if (current != nullptr) {
+            return *current;
+        }
+        auto created = std::make_unique<CombiningState>();
+        if (combiningState.compare_exchange_strong(current, created.get(), std::memory_order_acq_rel)) {
+            current = created.release();
+        }
+        return *current;
     }
 
     std::shared_ptr<CommunicationManager> communicationManager;
-    SubscriptionId syncSubscription;
+    std::shared_ptr<DistributedMonitorRegistry> registry;
+    /** Number of monitor entries the current state is the result of **/
+    std::atomic<std::uint64_t> stateVersion = 0;
+
+    /** Thread running a batch of entries, which do not lock the mutex again (see batch) **/
+    std::atomic<std::thread::id> batchThread;
+
+    /** Accessed by the batch thread - the version of the state it has sent since it last locked the mutex **/
+    std::optional<std::uint64_t> batchSentVersion;
+
+    /** Hand-overs of the mutex made before the last SYNC, accessed with the mutex held **/
+    std::uint64_t sentHandOverCount = 0;
+
+    bool isInBatch() const {
+        return batchThread.load() == std::this_thread::get_id();
+    }
+
+    /** Marks the batch - the state changed so far is sent whenever a wait inside it releases the mutex **/
+    class BatchGuard {
+    public:
+
+        explicit BatchGuard(DistributedMonitor& monitor) : monitor(monitor) {
+            monitor.batchThread = std::this_thread::get_id();
+            monitor.batchSentVersion.reset();
+        }
+
+        ~BatchGuard() {
+            monitor.batchThread = std::thread::id();
+            monitor.batchSentVersion.reset();
+        }
+
+        BatchGuard(const BatchGuard&) = delete;
+
+        BatchGuard& operator=(const BatchGuard&) = delete;
+
+    private:
+
+        DistributedMonitor& monitor;
+    };
+
+    /** Created by the first combined entry (see getCombiningState) **/
+    std::atomic<CombiningState*> combiningState = nullptr;
 
 protected:
 
@@ -65,6 +267,95 @@ protected:
         return std::make_unique<DistributedMonitorHelper>(*this, communicationManager);
     }
 
+    /**
+     * Runs the entry once the mutex is locked, without blocking the calling thread. The entry is run by the thread
+     * which completes the acquisition (see IDistributedExclusionAlgorithm::acquireMutexAsync), so it must not block,
+     * e.g. wait on a condition variable. The future becomes ready with what the entry returns (or throws) once the
+     * state is sent and the mutex unlocked.
+     */
+    template <typename Entry>
+    std::future<std::invoke_result_t<Entry>> enterAsync(Entry entry) {
+        using Result = std::invoke_result_t<Entry>;
+        auto promise = std::make_shared<std::promise<Result>>();
+        std::future<Result> future = promise->get_future();
+        mutex.lockAsync([this, promise, entry = std::move(entry)]() mutable {
+            std::exception_ptr exception;
+            if constexpr (std::is_void_v<Result>) {
+                try {
+                    DistributedMonitorHelper sync(*this, communicationManager, std::adopt_lock);
+                    entry();
+                } catch (...) {
+                    exception = std::current_exception();
+                }
+                exception ? promise->set_exception(exception) : promise->set_value();
+            } else {
+                std::optional<Result> result;
+                try {
+                    DistributedMonitorHelper sync(*this, communicationManager, std::adopt_lock);
+                    result.emplace(entry());
+                } catch (...) {
+                    exception = std::current_exception();
+                }
+                exception ? promise->set_exception(exception) : promise->set_value(std::move(*result));
+            }
+        });
+        return future;
+    }
+
+    /**
+     * Runs a short operation within an entry shared with the operations of other threads of this process (flat
+     * combining). The first thread finding no such entry in progress enters the monitor once, runs all the operations
+     * published in the meantime and sends a single SYNC, while the other threads wait for their operations to be run.
+     * An operation is run by any of the threads inside an entry, so it must not enter the monitor again nor wait on a
+     * condition variable. Returns what it returns (or throws).
+     */
+    template <typename Operation>
+    std::invoke_result_t<Operation> combined(Operation operation) {
+        using Result = std::invoke_result_t<Operation>;
+        if constexpr (std::is_void_v<Result>) {
+            CombinedOperation combinedOperation {[&operation]() { operation(); }};
+            combine(combinedOperation);
+        } else {
+            std::optional<Result> result;
+            CombinedOperation combinedOperation {[&operation, &result]() { result.emplace(operation()); }};
+            combine(combinedOperation);
+            return std::move(*result);
+        }
+    }
+
+    /**
+     * Runs several entries under a single acquisition of the mutex - the entries called by 'body' in this thread do not
+     * lock the mutex again, and the state is sent once, at the end. Waits on condition variables inside the batch
+     * release the mutex as usual, after sending the state changed by the batch so far. Returns what the body returns.
+     * Asynchronous and combined entries cannot be made from the body.
+     */
+    template <typename Body>
+    std::invoke_result_t<Body> batch(Body body) {
+        auto sync = synchronized();
+        if (isInBatch()) {
+            return body();
+        }
+        BatchGuard batchGuard(*this);
+        return body();
+    }
+
+    /** Takes over the entry of a mutex locked with lockAsync() - the state is sent and the mutex unlocked after it **/
+    std::unique_ptr<DistributedMonitorHelper> adoptSynchronized() {
+        return std::make_unique<DistributedMonitorHelper>(*this, communicationManager, std::adopt_lock);
+    }
+
+    /** Like synchronized(), but returns nullptr if the mutex could not be locked within the timeout **/
+    template <typename Rep, typename Period>
+    std::unique_ptr<DistributedMonitorHelper> synchronizedFor(const std::chrono::duration<Rep, Period>& timeout) {
+        if (isInBatch()) {
+            return synchronized();
+        }
+        if (not mutex.try_lock_for(timeout)) {
+            return nullptr;
+        }
+        return adoptSynchronized();
+    }
+
     DistributedMutex mutex;
 };
 
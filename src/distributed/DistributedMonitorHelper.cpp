@@ -4,16 +4,23 @@ DistributedMonitorHelper::DistributedMonitorHelper(DistributedMonitor& monitor,
                                                    std::shared_ptr <CommunicationManager> communicationManager)
         : communicationManager(std::move(communicationManager)), monitorMutex(monitor.mutex), monitor(monitor) {
 
+    if (monitor.isInBatch()) {
+        nested = true;
+        return;
+    }
     monitorMutex.lock();
 }
 
+DistributedMonitorHelper::DistributedMonitorHelper(DistributedMonitor& monitor,
+                                                   std::shared_ptr<CommunicationManager> communicationManager,
+                                                   std::adopt_lock_t)
+        : communicationManager(std::move(communicationManager)), monitorMutex(monitor.mutex), monitor(monitor) { }
+
+/** The next local entry the mutex is handed over to continues with the current state, so it is sent only on release **/
 DistributedMonitorHelper::~DistributedMonitorHelper() {
-    const std::string& serializedState = monitor.saveState();
-    communicationManager->sendOthers(MessageType::SYNC, packSyncMessage(serializedState));
+    if (nested or monitorMutex.handOver()) {
+        return;
+    }
+    monitor.sendState();
     monitorMutex.unlock();
 }
-
-std::string DistributedMonitorHelper::packSyncMessage(const std::string& serializedState) {
-    const std::string& monitorMutexName = monitor.mutex.getName();
-    return static_cast<char>(monitorMutexName.length()) + monitorMutexName + serializedState;
-}
@@ -1,6 +1,7 @@
 #ifndef DISTRIBUTEDMONITOR_DISTRIBUTEDMONITORHELPER_H
 #define DISTRIBUTEDMONITOR_DISTRIBUTEDMONITORHELPER_H
 
+#include <mutex>
 #include <communication/CommunicationManager.h>
 #include "DistributedMutex.h"
 
@@ -10,22 +11,29 @@ class DistributedMonitorHelper {
 public:
 
     /**
-     * Locks the mutex
+     * Locks the mutex, unless the calling thread runs a batch of the monitor (see DistributedMonitor::batch) - the
+     * helper does nothing then
      */
     explicit DistributedMonitorHelper(DistributedMonitor& monitor, std::shared_ptr<CommunicationManager> communicationManager);
 
     /**
-     * Sends synchronization message and unlocks the mutex afterwards
+     * Takes over the mutex already locked by the caller
+     */
+    DistributedMonitorHelper(DistributedMonitor& monitor, std::shared_ptr<CommunicationManager> communicationManager,
+                             std::adopt_lock_t);
+
+    /**
+     * Sends synchronization message and unlocks the mutex afterwards, unless the mutex is handed over to another thread
+     * of this process
      */
     virtual ~DistributedMonitorHelper();
 
 private:
 
-    std::string packSyncMessage(const std::string& serializedState);
-
     std::shared_ptr<CommunicationManager> communicationManager;
     DistributedMutex& monitorMutex;
     DistributedMonitor& monitor;
+    bool nested = false;
 };
 
 #endif //DISTRIBUTEDMONITOR_DISTRIBUTEDMONITORHELPER_H
@@ -0,0 +1,108 @@
+#include "DistributedMonitorRegistry.h"
+#include <algorithm>
+#include <util/MessagePacking.h>
+
+namespace {
+    /** Registries in use, each one erased by its destructor **/
+    std::mutex registriesMutex;
+    std::unordered_map<CommunicationManager*, std::weak_ptr<DistributedMonitorRegistry>> registries;
+}
+
+std::shared_ptr<DistributedMonitorRegistry>
+DistributedMonitorRegistry::of(const std::shared_ptr<CommunicationManager>& communicationManager) {
+    std::lock_guard<std::mutex> lock(registriesMutex);
+    std::weak_ptr<DistributedMonitorRegistry>& registry = registries[communicationManager.get()];
+    if (auto existingRegistry = registry.lock()) {
+        return existingRegistry;
+    }
+    auto newRegistry = std::make_shared<DistributedMonitorRegistry>(communicationManager);
+    registry = newRegistry;
+    return newRegistry;
+}
+
+DistributedMonitorRegistry::DistributedMonitorRegistry(std::shared_ptr<CommunicationManager> communicationManager)
+        : communicationManager(std::move(communicationManager)) {
+
+    syncSubscription = this->communicationManager->subscribe(MessageType::SYNC, [this](const Packet& packet) {
+        /** Reused by every lookup, so that it does not allocate **/
+        static thread_local std::string lookupName;
+        lookupName.assign(extractName(packet.message));
+        std::shared_lock<std::shared_mutex> lock(monitorsMutex);
+        auto monitor = monitors.find(lookupName);
+        if (monitor == monitors.end()) {
+            return false;
+        }
+        monitor->second->receiveState(packet);
+        return true;
+    });
+}
+
+DistributedMonitorRegistry::~DistributedMonitorRegistry() {
+    communicationManager->unsubscribe(syncSubscription);
+    std::lock_guard<std::mutex> lock(registriesMutex);
+    auto registry = registries.find(communicationManager.get());
+    /** Another registry may have taken the place of this one since it expired **/
+    if (registry != registries.end() and registry->second.expired()) {
+        registries.erase(registry);
+    }
+}
+
+void DistributedMonitorRegistry::add(const std::string& monitorName, RegisteredMonitor* monitor) {
+    communicationManager->internName(monitorName);
+    std::unique_lock<std::shared_mutex> lock(monitorsMutex);
+    if (not monitors.try_emplace(monitorName, monitor).second) {
+        throw std::runtime_error("Monitor '" + monitorName + "' already exists");
+    }
+}
+
+void DistributedMonitorRegistry::remove(const std::string& monitorName) {
+    std::unique_lock<std::shared_mutex> lock(monitorsMutex);
+    monitors.erase(monitorName);
+}
+
+void DistributedMonitorRegistry::publish(const std::string& monitorName) {
+    RegisteredMonitor* monitor;
+    {
+        std::shared_lock<std::shared_mutex> lock(monitorsMutex);
+        auto registeredMonitor = monitors.find(monitorName);
+        if (registeredMonitor == monitors.end()) {
+            throw std::runtime_error("Mutex '" + monitorName + "' does not belong to any monitor");
+        }
+        monitor = registeredMonitor->second;
+    }
+    /** Not under monitorsMutex - publishing saves the extensions, which SYNC handlers restore under it **/
+    monitor->publishState();
+}
+
+void DistributedMonitorRegistry::addExtension(MonitorStateExtension* extension) {
+    std::lock_guard<std::mutex> lock(extensionsMutex);
+    extensions.push_back(extension);
+}
+
+void DistributedMonitorRegistry::removeExtension(MonitorStateExtension* extension) {
+    std::lock_guard<std::mutex> lock(extensionsMutex);
+    extensions.erase(std::remove(extensions.begin(), extensions.end(), extension), extensions.end());
+}
+
+void DistributedMonitorRegistry::saveExtensions(const std::string& monitorName, std::string& syncData) {
+    std::lock_guard<std::mutex> lock(extensionsMutex);
+    std::string extensionState;
+    for (MonitorStateExtension* extension : extensions) {
+        extensionState.clear();
+        extension->saveMonitorState(monitorName, extensionState);
+        appendVarint(syncData, extensionState.size());
+        syncData.append(extensionState);
+    }
+}
+
+std::string_view DistributedMonitorRegistry::restoreExtensions(const std::string& monitorName,
+                                                               std::string_view syncData) {
+    std::lock_guard<std::mutex> lock(extensionsMutex);
+    std::size_t offset = 0;
+    for (MonitorStateExtension* extension : extensions) {
+        auto length = static_cast<std::size_t>(readVarint(syncData, offset));
+        extension->restoreMonitorState(monitorName, syncData.substr(offset, length));
+        offset += length;
+    }
+    return syncData.substr(offset);
+}
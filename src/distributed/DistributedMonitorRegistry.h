@@ -0,0 +1,87 @@
+#ifndef DISTRIBUTEDMONITOR_DISTRIBUTEDMONITORREGISTRY_H
+#define DISTRIBUTEDMONITOR_DISTRIBUTEDMONITORREGISTRY_H
+
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+#include <communication/CommunicationManager.h>
+
+/**
+ * A part of the state of every monitor kept outside of it, e.g. by a condition variable algorithm. It is sent and
+ * restored together with the monitor's own state.
+ */
+class MonitorStateExtension {
+public:
+
+    virtual ~MonitorStateExtension() = default;
+
+    /** Appends the part of the state concerning the given monitor **/
+    virtual void saveMonitorState(const std::string& monitorName, std::string& state) = 0;
+
+    virtual void restoreMonitorState(const std::string& monitorName, std::string_view state) = 0;
+};
+
+/** A monitor kept in a DistributedMonitorRegistry **/
+class RegisteredMonitor {
+public:
+
+    virtual ~RegisteredMonitor() = default;
+
+    /** Called with every SYNC message concerning the monitor **/
+    virtual void receiveState(const Packet& packet) = 0;
+
+    /** Sends the current state of the monitor to other processes, the mutex has to be held **/
+    virtual void publishState() = 0;
+};
+
+/**
+ * Monitors of one CommunicationManager, found by their names. Subscribes to SYNC messages once for all of them, so
+ * creating a monitor takes constant time no matter how many there already are.
+ */
+class DistributedMonitorRegistry {
+public:
+
+    /** Returns the registry shared by all monitors of the given manager, creating it if there is none **/
+    static std::shared_ptr<DistributedMonitorRegistry>
+    of(const std::shared_ptr<CommunicationManager>& communicationManager);
+
+    explicit DistributedMonitorRegistry(std::shared_ptr<CommunicationManager> communicationManager);
+
+    ~DistributedMonitorRegistry();
+
+    DistributedMonitorRegistry(const DistributedMonitorRegistry&) = delete;
+
+    DistributedMonitorRegistry& operator=(const DistributedMonitorRegistry&) = delete;
+
+    /** The monitor receives every SYNC message concerning it until it is removed **/
+    void add(const std::string& monitorName, RegisteredMonitor* monitor);
+
+    /** Once it returns, the monitor does not receive SYNC messages anymore **/
+    void remove(const std::string& monitorName);
+
+    /** Sends the current state of the monitor, which this process has to hold the mutex of, to other processes **/
+    void publish(const std::string& monitorName);
+
+    /** All processes have to add the same extensions in the same order **/
+    void addExtension(MonitorStateExtension* extension);
+
+    void removeExtension(MonitorStateExtension* extension);
+
+    /** Appends the state of all extensions concerning the monitor to its SYNC data **/
+    void saveExtensions(const std::string& monitorName, std::string& syncData);
+
+    /** Restores the extensions from the SYNC data and returns the rest of it - the state of the monitor itself **/
+    std::string_view restoreExtensions(const std::string& monitorName, std::string_view syncData);
+
+private:
+
+    std::shared_ptr<CommunicationManager> communicationManager;
+    SubscriptionId syncSubscription;
+    std::unordered_map<std::string, RegisteredMonitor*> monitors;
+    /** SYNC messages of different monitors are handled concurrently, adding and removing monitors is exclusive **/
+    std::shared_mutex monitorsMutex;
+    std::vector<MonitorStateExtension*> extensions;
+    std::mutex extensionsMutex;
+};
+
+#endif //DISTRIBUTEDMONITOR_DISTRIBUTEDMONITORREGISTRY_H
@@ -2,12 +2,18 @@
 #define DISTRIBUTEDMONITOR_DISTRIBUTEDMUTEX_H
 
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <thread>
+#include <algorithms/IDistributedExclusionAlgorithm.h>
+#include "MutexCohort.h"
 
 /**
- * Assumption: There will be only one shared mutex associated with the monitor!
- *
- * A DistributedMutex implementing the Lockable concept in C++.
+ * A DistributedMutex implementing the Lockable concept in C++. Threads of a process lock it one after another, the
+ * distributed mutex being handed over between them before it is released (see MutexCohort), so it is owned by the
+ * process rather than by a thread. The thread which has locked it last is recorded too (see isLockedByThisThread).
  */
 class DistributedMutex {
 public:
@@ -22,30 +28,153 @@ public:
     }
 
     void lock() {
-        algorithm->acquireMutex(name);
+        if (cohort.enter()) {
+            takeOver();
+            return;
+        }
+        try {
+            algorithm->acquireMutex(name);
+        } catch (...) {
+            cohort.leave();
+            throw;
+        }
         owned = true;
+        ownerThread = std::this_thread::get_id();
+    }
+
+    /**
+     * Calls 'onLocked' once the mutex is locked, without blocking the calling thread (see
+     * IDistributedExclusionAlgorithm::acquireMutexAsync). Can be called again before the mutex is unlocked - the calls
+     * are served in order, together with the threads locking it.
+     */
+    void lockAsync(std::function<void()> onLocked) {
+        cohort.enterAsync([this, onLocked = std::move(onLocked)](bool handedOver) {
+            if (handedOver) {
+                takeOver();
+                onLocked();
+                return;
+            }
+            algorithm->acquireMutexAsync(name, [this, onLocked]() {
+                owned = true;
+                ownerThread = std::this_thread::get_id();
+                onLocked();
+            });
+        });
     }
 
+    /** Whether lockAsync returns without waiting for other processes (see supportsAsyncAcquire) **/
+    [[nodiscard]] bool supportsAsyncLock() const {
+        return algorithm->supportsAsyncAcquire();
+    }
+
+    /** Hands the mutex over to the next local thread or asynchronous lock if there is one, releases it otherwise **/
     void unlock() {
         if (not isOwned()) {
             return;
         }
+        /** A hand-over may run the next asynchronous lock on this thread right away **/
+        ownerThread = std::thread::id();
+        if (handOver()) {
+            return;
+        }
+        release();
+    }
+
+    /** Returns false if there is no local lock to hand the mutex over to (see MutexCohort), it stays locked then **/
+    bool handOver() {
+        return cohort.handOver();
+    }
+
+    /** Releases the mutex to other processes, then lets the next local lock acquire it again **/
+    void release() {
+        if (not isOwned()) {
+            return;
+        }
+        if (beforeRelease) {
+            beforeRelease();
+        }
+        if (not owned.exchange(false)) {
+            return;
+        }
         algorithm->releaseMutex(name);
-        owned = false;
+        cohort.leave();
     }
 
+    /** Does not wait - fails unless the algorithm can grant the mutex without asking other processes **/
     bool try_lock() {
-        if (not isOwned()) {
-            lock();
+        return try_lock_until(std::chrono::steady_clock::now());
+    }
+
+    template <typename Rep, typename Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout) {
+        return try_lock_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    /** Gives up at the deadline, withdrawing the request sent to other processes **/
+    template <typename Clock, typename Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration>& deadline) {
+        Deadline steadyDeadline = std::chrono::steady_clock::now() +
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(deadline - Clock::now());
+        std::optional<bool> handedOver = cohort.enterUntil(steadyDeadline);
+        if (not handedOver) {
+            return false;
+        }
+        if (*handedOver) {
+            takeOver();
             return true;
         }
-        return false;
+        bool acquired = false;
+        try {
+            acquired = algorithm->tryAcquireMutex(name, steadyDeadline);
+        } catch (...) {
+            cohort.leave();
+            throw;
+        }
+        if (not acquired) {
+            cohort.leave();
+            return false;
+        }
+        owned = true;
+        ownerThread = std::this_thread::get_id();
+        return true;
     }
 
+    /** Whether this process holds the mutex, whichever of its threads has locked it **/
     bool isOwned() {
         return owned.load();
     }
 
+    /** Whether the calling thread has locked the mutex and not unlocked it yet **/
+    bool isLockedByThisThread() {
+        return isOwned() and ownerThread.load() == std::this_thread::get_id();
+    }
+
+    /**
+     * Makes the calling thread the owner of the mutex this process holds - for entries resumed on another thread than
+     * the one which has locked it (see CoroutineMonitor)
+     */
+    void adopt() {
+        ownerThread = std::this_thread::get_id();
+    }
+
+    /**
+     * Called by the thread releasing the mutex to other processes, before it does so (not when the mutex is handed over
+     * locally). Set before the mutex is used.
+     */
+    void setBeforeRelease(std::function<void()> callback) {
+        beforeRelease = std::move(callback);
+    }
+
+    /** Number of times the mutex has been handed over between the threads of this process, read with it held **/
+    [[nodiscard]] std::uint64_t getHandOverCount() const {
+        return handOvers;
+    }
+
+    /** Maximal number of local locks in a row served without releasing the mutex to other processes **/
+    void setCohortBound(std::size_t bound) {
+        cohort.setBound(bound);
+    }
+
     [[nodiscard]] const std::string& getName() const {
         return name;
     }
@@ -55,6 +184,17 @@ private:
     std::string name;
     std::shared_ptr<IDistributedExclusionAlgorithm> algorithm;
     std::atomic_bool owned = false;
+    std::atomic<std::thread::id> ownerThread;
+    MutexCohort cohort;
+    std::function<void()> beforeRelease;
+    /** Read and written only with the mutex held **/
+    std::uint64_t handOvers = 0;
+
+    /** Accessed by the thread the mutex has been handed over to **/
+    void takeOver() {
+        ++handOvers;
+        ownerThread = std::this_thread::get_id();
+    }
 };
 
 
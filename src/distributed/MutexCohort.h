@@ -0,0 +1,167 @@
+#ifndef DISTRIBUTEDMONITOR_MUTEXCOHORT_H
+#define DISTRIBUTEDMONITOR_MUTEXCOHORT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <util/Define.h>
+
+/**
+ * Local part of a distributed mutex locked by many threads of a process (cohort locking). Only one local entry at a
+ * time - the one whose turn it is - acquires or holds the distributed mutex, the others queue locally in the order
+ * they came. When it is done, the mutex is handed over to the next local entry without releasing it, unless 'bound'
+ * entries in a row have been handed over already - then it is released, so that other processes get it too, and the
+ * next local entry acquires it again.
+ *
+ * The queue is locked only when a turn starts or ends, so a process with a single thread pays for one uncontended
+ * std::mutex per entry. The queue is created by the first entry, so a mutex which is never locked takes no more than
+ * two words for it.
+ */
+class MutexCohort {
+public:
+
+    static constexpr std::size_t DEFAULT_BOUND = 16;
+
+    MutexCohort() = default;
+
+    ~MutexCohort() {
+        delete queue.load();
+    }
+
+    MutexCohort(const MutexCohort&) = delete;
+
+    MutexCohort& operator=(const MutexCohort&) = delete;
+
+    /** Called when the turn starts, with true if the distributed mutex has been handed over (it is already held) **/
+    using Turn = std::function<void(bool handedOver)>;
+
+    /** Blocks until it is the caller's turn, returns true if the distributed mutex has been handed over to it **/
+    bool enter() {
+        return *enterUntil(std::nullopt);
+    }
+
+    /** Like enter, but returns nothing if the turn has not come by the deadline **/
+    std::optional<bool> enterUntil(std::optional<Deadline> deadline) {
+        Queue& queue = getQueue();
+        std::unique_lock<std::mutex> lock(queue.cohortMutex);
+        if (not queue.taken) {
+            queue.taken = true;
+            return false;
+        }
+        ThreadWaiter threadWaiter;
+        auto waiter = queue.waiters.insert(queue.waiters.end(), {&threadWaiter, nullptr});
+        if (deadline) {
+            if (not queue.turnStarted.wait_until(lock, *deadline, [&]() { return threadWaiter.granted; })) {
+                queue.waiters.erase(waiter);
+                return std::nullopt;
+            }
+        } else {
+            queue.turnStarted.wait(lock, [&]() { return threadWaiter.granted; });
+        }
+        return threadWaiter.handedOver;
+    }
+
+    /** Does not block - 'onTurn' is called by the thread ending the previous turn, or right away **/
+    void enterAsync(Turn onTurn) {
+        Queue& queue = getQueue();
+        std::unique_lock<std::mutex> lock(queue.cohortMutex);
+        if (queue.taken) {
+            queue.waiters.push_back({nullptr, std::move(onTurn)});
+            return;
+        }
+        queue.taken = true;
+        lock.unlock();
+        onTurn(false);
+    }
+
+    /**
+     * Called instead of releasing the distributed mutex - returns false if there is no one to hand it over to or the
+     * bound has been reached, the turn goes on then
+     */
+    bool handOver() {
+        Queue& queue = getQueue();
+        std::unique_lock<std::mutex> lock(queue.cohortMutex);
+        if (queue.waiters.empty() or queue.handOvers >= bound.load()) {
+            return false;
+        }
+        ++queue.handOvers;
+        passTurn(queue, lock, true);
+        return true;
+    }
+
+    /** Called after the distributed mutex is released (or could not be acquired) - the next entry has to acquire it **/
+    void leave() {
+        Queue& queue = getQueue();
+        std::unique_lock<std::mutex> lock(queue.cohortMutex);
+        queue.handOvers = 0;
+        if (queue.waiters.empty()) {
+            queue.taken = false;
+            return;
+        }
+        passTurn(queue, lock, false);
+    }
+
+    /** Maximal number of entries in a row handed over without releasing the distributed mutex, 0 turns it off **/
+    void setBound(std::size_t newBound) {
+        bound = newBound;
+    }
+
+private:
+
+    struct ThreadWaiter {
+        bool granted = false;
+        bool handedOver = false;
+    };
+
+    /** Either a blocked thread or an asynchronous entry **/
+    struct Waiter {
+        ThreadWaiter* thread;
+        Turn onTurn;
+    };
+
+    struct Queue {
+        std::mutex cohortMutex;
+        std::condition_variable turnStarted;
+        /** Some local entry holds the distributed mutex or is acquiring it **/
+        bool taken = false;
+        std::list<Waiter> waiters;
+        std::size_t handOvers = 0;
+    };
+
+    /** Creates the queue on the first call - threads racing to do so agree on one of them **/
+    Queue& getQueue() {
+        Queue* current = queue.load(std::memory_order_acquire);
+        if (current != nullptr) {
+            return *current;
+        }
+        auto created = std::make_unique<Queue>();
+        if (queue.compare_exchange_strong(current, created.get(), std::memory_order_acq_rel)) {
+            current = created.release();
+        }
+        return *current;
+    }
+
+    /** Protected by cohortMutex, which is released before the next entry is woken up **/
+    static void passTurn(Queue& queue, std::unique_lock<std::mutex>& lock, bool handedOver) {
+        Waiter waiter = std::move(queue.waiters.front());
+        queue.waiters.pop_front();
+        if (waiter.thread != nullptr) {
+            waiter.thread->granted = true;
+            waiter.thread->handedOver = handedOver;
+            lock.unlock();
+            queue.turnStarted.notify_all();
+        } else {
+            lock.unlock();
+            waiter.onTurn(handedOver);
+        }
+    }
+
+    std::atomic<Queue*> queue = nullptr;
+    std::atomic<std::size_t> bound = DEFAULT_BOUND;
+};
+
+#endif //DISTRIBUTEDMONITOR_MUTEXCOHORT_H
@@ -0,0 +1,122 @@
+#ifndef DISTRIBUTEDMONITOR_STATICDISTRIBUTEDMONITOR_H
+#define DISTRIBUTEDMONITOR_STATICDISTRIBUTEDMONITOR_H
+
+#include <cassert>
+#include <utility>
+#include <communication/CommunicationManager.h>
+#include <util/MessagePacking.h>
+#include "DistributedMonitorRegistry.h"
+#include "StaticDistributedMutex.h"
+
+/**
+ * A DistributedMonitor for deployments which pick the exclusion algorithm at compile time. Behaves exactly like
+ * DistributedMonitor and can be mixed with it in one process, but the algorithm is called without virtual dispatch and
+ * a monitor entry neither allocates its guard nor touches any shared_ptr reference counter.
+ */
+template <typename Algorithm>
+class StaticDistributedMonitor : private RegisteredMonitor {
+public:
+
+    explicit StaticDistributedMonitor(const std::string& name,
+                                      std::shared_ptr<CommunicationManager> communicationManager,
+                                      std::shared_ptr<Algorithm> mutexAlgorithm)
+
+            : communicationManager(std::move(communicationManager)), syncMessage(packNamedMessage(name, "")),
+              syncMessageHeaderSize(syncMessage.size()), mutex(name, std::move(mutexAlgorithm)) {
+
+        assert(name.length() <= static_cast<unsigned char>(-1));
+
+        registry = DistributedMonitorRegistry::of(this->communicationManager);
+        registry->add(mutex.getName(), this);
+    }
+
+    ~StaticDistributedMonitor() override {
+        registry->remove(mutex.getName());
+    }
+
+    StaticDistributedMonitor(const StaticDistributedMonitor&) = delete;
+
+    StaticDistributedMonitor& operator=(const StaticDistributedMonitor&) = delete;
+
+private:
+
+    /** Restore the state based on the SYNC message, skipping outdated ones - see DistributedMonitor **/
+    void receiveState(const Packet& data) override {
+        std::string_view syncData = extractData(data.message);
+        std::uint64_t version = readNumber(syncData, 0);
+        if (version <= stateVersion) {
+            Logger::log("Skipping outdated SYNC from process " + std::to_string(data.source));
+            return;
+        }
+        stateVersion = version;
+        restoreState(registry->restoreExtensions(mutex.getName(), syncData.substr(sizeof(version))));
+    }
+
+    void publishState() override {
+        sendState();
+    }
+
+    /** Accessed by Main Thread - sends the state to other processes, the mutex has to be held **/
+    void sendState() {
+        syncMessage.resize(syncMessageHeaderSize);
+        appendNumber(syncMessage, ++stateVersion);
+        registry->saveExtensions(mutex.getName(), syncMessage);
+        syncMessage.append(saveState());
+        communicationManager->sendOthers(MessageType::SYNC, syncMessage);
+    }
+
+    /** Accessed by Main Thread - the state is sent only when the mutex is not handed over to another local thread **/
+    void exit() {
+        if (mutex.handOver()) {
+            return;
+        }
+        sendState();
+        mutex.unlock();
+    }
+
+    std::shared_ptr<CommunicationManager> communicationManager;
+    std::shared_ptr<DistributedMonitorRegistry> registry;
+    /** Number of monitor entries the current state is the result of **/
+    std::atomic<std::uint64_t> stateVersion = 0;
+    /** SYNC message of the last entry, reused so that its buffer is allocated only once **/
+    std::string syncMessage;
+    std::size_t syncMessageHeaderSize;
+
+protected:
+
+    /** Locks the mutex on construction, sends the state and unlocks the mutex on destruction **/
+    class EntryGuard {
+    public:
+
+        explicit EntryGuard(StaticDistributedMonitor& monitor) : monitor(monitor) {
+            monitor.mutex.lock();
+        }
+
+        ~EntryGuard() {
+            monitor.exit();
+        }
+
+        EntryGuard(const EntryGuard&) = delete;
+
+        EntryGuard& operator=(const EntryGuard&) = delete;
+
+    private:
+
+        StaticDistributedMonitor& monitor;
+    };
+
+    /** Will be called automatically after any monitor entry function. */
+    virtual std::string saveState() = 0;
+
+    /** Will be called automatically before each monitor entry function. */
+    virtual void restoreState(std::string_view) = 0;
+
+    /** Invoke this method at the beginning of the derived monitor class' entries */
+    EntryGuard synchronized() {
+        return EntryGuard(*this);
+    }
+
+    StaticDistributedMutex<Algorithm> mutex;
+};
+
+#endif //DISTRIBUTEDMONITOR_STATICDISTRIBUTEDMONITOR_H
@@ -0,0 +1,129 @@
+#ifndef DISTRIBUTEDMONITOR_STATICDISTRIBUTEDMUTEX_H
+#define DISTRIBUTEDMONITOR_STATICDISTRIBUTEDMUTEX_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <algorithms/IDistributedExclusionAlgorithm.h>
+#include "MutexCohort.h"
+
+/**
+ * A DistributedMutex bound to a concrete exclusion algorithm at compile time. Calls to the algorithm are not virtual,
+ * so a header-only algorithm can be inlined into the monitor entry. Threads of a process share it like a
+ * DistributedMutex (see MutexCohort).
+ */
+template <typename Algorithm>
+class StaticDistributedMutex {
+    static_assert(std::is_base_of_v<IDistributedExclusionAlgorithm, Algorithm>,
+                  "Algorithm has to implement IDistributedExclusionAlgorithm");
+    static_assert(not std::is_abstract_v<Algorithm>, "Algorithm has to be a concrete class");
+
+public:
+
+    explicit StaticDistributedMutex(MutexName name, std::shared_ptr<Algorithm> algorithm)
+            : name(std::move(name)), algorithm(std::move(algorithm)) {
+        this->algorithm->Algorithm::registerMutex(this->name);
+    }
+
+    ~StaticDistributedMutex() {
+        algorithm->Algorithm::unregisterMutex(name);
+    }
+
+    StaticDistributedMutex(const StaticDistributedMutex&) = delete;
+
+    StaticDistributedMutex& operator=(const StaticDistributedMutex&) = delete;
+
+    void lock() {
+        if (cohort.enter()) {
+            return;
+        }
+        try {
+            algorithm->Algorithm::acquireMutex(name);
+        } catch (...) {
+            cohort.leave();
+            throw;
+        }
+        owned.store(true, std::memory_order_relaxed);
+    }
+
+    void unlock() {
+        if (not isOwned() or handOver()) {
+            return;
+        }
+        release();
+    }
+
+    /** Returns false if there is no local lock to hand the mutex over to (see MutexCohort), it stays locked then **/
+    bool handOver() {
+        return cohort.handOver();
+    }
+
+    void release() {
+        if (not isOwned()) {
+            return;
+        }
+        algorithm->Algorithm::releaseMutex(name);
+        owned.store(false, std::memory_order_relaxed);
+        cohort.leave();
+    }
+
+    /** Does not wait - fails unless the algorithm can grant the mutex without asking other processes **/
+    bool try_lock() {
+        return try_lock_until(std::chrono::steady_clock::now());
+    }
+
+    template <typename Rep, typename Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout) {
+        return try_lock_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    /** Gives up at the deadline, withdrawing the request sent to other processes **/
+    template <typename Clock, typename Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration>& deadline) {
+        Deadline steadyDeadline = std::chrono::steady_clock::now() +
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(deadline - Clock::now());
+        std::optional<bool> handedOver = cohort.enterUntil(steadyDeadline);
+        if (not handedOver) {
+            return false;
+        }
+        if (*handedOver) {
+            return true;
+        }
+        bool acquired = false;
+        try {
+            acquired = algorithm->Algorithm::tryAcquireMutex(name, steadyDeadline);
+        } catch (...) {
+            cohort.leave();
+            throw;
+        }
+        if (not acquired) {
+            cohort.leave();
+            return false;
+        }
+        owned.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool isOwned() const {
+        return owned.load(std::memory_order_relaxed);
+    }
+
+    void setCohortBound(std::size_t bound) {
+        cohort.setBound(bound);
+    }
+
+    [[nodiscard]] const std::string& getName() const {
+        return name;
+    }
+
+private:
+
+    std::string name;
+    std::shared_ptr<Algorithm> algorithm;
+    std::atomic_bool owned = false;
+    MutexCohort cohort;
+};
+
+#endif //DISTRIBUTEDMONITOR_STATICDISTRIBUTEDMUTEX_H
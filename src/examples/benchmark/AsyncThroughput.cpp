@@ -0,0 +1,89 @@
+#include <chrono>
+#include <thread>
+#include <communication/MpiSimpleCommunicator.h>
+#include "BenchmarkUtils.h"
+
+/**
+ * Measures the throughput of many logical clients per process, each entering its own counter monitor (shared with the
+ * clients of the same number in other processes) a number of times. With 'async' a single thread keeps an entry of
+ * every client in flight with enterAsync(), with 'threads' every client has its own thread entering the monitor with
+ * synchronized(). The counters are checked at the end.
+ *
+ * Usage: mpirun -np <N> AsyncThroughput <async|threads> [clients per process] [entries per client]
+ * Logging is disabled. The result is printed by process 0 to the standard error, the exit code is non-zero if any of
+ * the counters is wrong.
+ */
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <async|threads> [clients per process] [entries per client]\n";
+        return 1;
+    }
+    std::string mode = argv[1];
+    std::size_t clients = argc > 2 ? std::stoul(argv[2]) : 200;
+    std::size_t entries = argc > 3 ? std::stoul(argv[3]) : 20;
+
+    auto communicator = std::make_shared<MpiSimpleCommunicator>(argc, argv);
+    Logger::init(communicator);
+    Logger::setEnabled(false);
+    int result = 0;
+    {
+        auto communicationManager = std::make_shared<CommunicationManager>(communicator);
+        auto mutexAlgorithm = std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager);
+        std::vector<std::unique_ptr<CounterMonitor>> counters;
+        for (std::size_t client = 0; client < clients; ++client) {
+            counters.push_back(std::make_unique<CounterMonitor>("client-" + std::to_string(client),
+                                                                communicationManager, mutexAlgorithm));
+        }
+        communicationManager->listen();
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        auto start = std::chrono::steady_clock::now();
+        if (mode == "async") {
+            /** The next entry of a client is started as soon as its previous one completes **/
+            std::vector<std::future<void>> entriesInFlight;
+            for (const auto& counter : counters) {
+                entriesInFlight.push_back(counter->incrementAsync());
+            }
+            for (std::size_t entry = 1; entry < entries; ++entry) {
+                for (std::size_t client = 0; client < clients; ++client) {
+                    entriesInFlight[client].get();
+                    entriesInFlight[client] = counters[client]->incrementAsync();
+                }
+            }
+            for (std::future<void>& entryInFlight : entriesInFlight) {
+                entryInFlight.get();
+            }
+        } else {
+            std::vector<std::thread> threads;
+            for (const auto& counter : counters) {
+                threads.emplace_back([&counter, entries]() {
+                    for (std::size_t entry = 0; entry < entries; ++entry) {
+                        counter->increment();
+                    }
+                });
+            }
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double slowestSeconds = 0;
+        MPI_Reduce(&seconds, &slowestSeconds, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        awaitQuiescence(communicationManager);
+
+        if (communicationManager->getProcessId() == 0) {
+            auto numberOfProcesses = static_cast<std::size_t>(communicationManager->getNumberOfProcesses());
+            std::size_t inconsistentCounters = 0;
+            for (const auto& counter : counters) {
+                inconsistentCounters += counter->get() == entries * numberOfProcesses ? 0 : 1;
+            }
+            double totalEntries = static_cast<double>(clients * entries * numberOfProcesses);
+            std::cerr << "Mode: " << mode << ", clients per process: " << clients << ", entries: " << totalEntries
+                      << ", time: " << slowestSeconds << " s, entries per second: " << totalEntries / slowestSeconds
+                      << ", inconsistent counters: " << inconsistentCounters << std::endl;
+            result = inconsistentCounters == 0 ? 0 : 2;
+        }
+        awaitQuiescence(communicationManager);
+    }
+    return result;
+}
@@ -0,0 +1,173 @@
+#include <chrono>
+#include <communication/CausalCommunicator.h>
+#include <communication/MpiSimpleCommunicator.h>
+#include "BenchmarkUtils.h"
+#include <distributed/DistributedConditionVariable.h>
+
+/**
+ * Runs the producer-consumer problem with entries made in batches (see DistributedMonitor::batch) - a producer puts a
+ * batch of items into the buffer under a single acquisition of the mutex, a consumer takes a batch of items and
+ * records the batch in the statistics of the buffer. Producers wait with the NOT_FULL class and consumers with the
+ * NOT_EMPTY one, so batches larger than the buffer wait inside the batch.
+ * The first half of the processes produce the items, the rest consume them. The buffer is checked at the end.
+ *
+ * Usage: mpirun -np <N> BatchedEntries [batch size] [items per consumer] [queue size]
+ *        [broadcast|monitor|centralized|causal]
+ * Logging is disabled. The result is printed by process 0 to the standard error, the exit code is non-zero if the
+ * buffer is inconsistent.
+ */
+
+static constexpr WaitClass NOT_FULL = 1;
+static constexpr WaitClass NOT_EMPTY = 2;
+
+class BufferMonitor : public DistributedMonitor {
+public:
+
+    BufferMonitor(const std::string& name,
+                  const std::shared_ptr<CommunicationManager>& communicationManager,
+                  const std::shared_ptr<IDistributedExclusionAlgorithm>& mutexAlgorithm,
+                  const std::shared_ptr<IDistributedConditionVariableAlgorithm>& cvAlgorithm,
+                  std::uint64_t capacity)
+
+            : DistributedMonitor(name, communicationManager, mutexAlgorithm), capacity(capacity),
+              cv("buffer", cvAlgorithm) { }
+
+    std::string saveState() override {
+        std::string state;
+        appendNumber(state, count);
+        appendNumber(state, entries);
+        appendNumber(state, consumedBatches);
+        return state;
+    }
+
+    void restoreState(const std::string_view state) override {
+        count = readNumber(state, 0);
+        entries = readNumber(state, 1);
+        consumedBatches = readNumber(state, 2);
+    }
+
+    void produce() {
+        auto sync = synchronized();
+        cv.wait(mutex, [this]() { return count < capacity; }, NOT_FULL);
+        ++count;
+        ++entries;
+        cv.notify_one(NOT_EMPTY);
+    }
+
+    void consume() {
+        auto sync = synchronized();
+        cv.wait(mutex, [this]() { return count > 0; }, NOT_EMPTY);
+        --count;
+        ++entries;
+        cv.notify_one(NOT_FULL);
+    }
+
+    void recordBatch() {
+        auto sync = synchronized();
+        ++consumedBatches;
+    }
+
+    void produceBatch(std::size_t items) {
+        batch([&]() {
+            for (std::size_t item = 0; item < items; ++item) {
+                produce();
+            }
+        });
+    }
+
+    void consumeBatch(std::size_t items) {
+        batch([&]() {
+            for (std::size_t item = 0; item < items; ++item) {
+                consume();
+            }
+            recordBatch();
+        });
+    }
+
+    /** Items left, entries made and batches consumed **/
+    std::array<std::uint64_t, 3> get() {
+        auto sync = synchronized();
+        return {count, entries, consumedBatches};
+    }
+
+private:
+
+    std::uint64_t capacity;
+    std::uint64_t count = 0;
+    std::uint64_t entries = 0;
+    std::uint64_t consumedBatches = 0;
+    DistributedConditionVariable cv;
+};
+
+int main(int argc, char** argv) {
+    std::size_t batchSize = argc > 1 ? std::stoul(argv[1]) : 8;
+    std::size_t items = argc > 2 ? std::stoul(argv[2]) : 1024;
+    std::uint64_t queueSize = argc > 3 ? std::stoul(argv[3]) : 5;
+    std::string algorithm = argc > 4 ? argv[4] : "monitor";
+
+    auto mpiCommunicator = std::make_shared<MpiSimpleCommunicator>(argc, argv);
+    Logger::init(mpiCommunicator);
+    Logger::setEnabled(false);
+    auto numberOfProcesses = static_cast<std::size_t>(mpiCommunicator->getNumberOfProcesses());
+    std::size_t producers = numberOfProcesses / 2;
+    if (batchSize == 0 or producers == 0) {
+        std::cerr << "There has to be at least one producer and one consumer, and a batch of at least one item"
+                  << std::endl;
+        return 1;
+    }
+    std::size_t consumers = numberOfProcesses - producers;
+    auto communicator = std::make_shared<CountingCommunicator>(mpiCommunicator);
+    std::shared_ptr<ICommunicator> managerCommunicator = communicator;
+    if (algorithm == "causal") {
+        managerCommunicator = std::make_shared<CausalCommunicator>(communicator);
+    }
+    int result = 0;
+    {
+        auto communicationManager = std::make_shared<CommunicationManager>(managerCommunicator);
+        auto mutexAlgorithm = std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager);
+        auto cvAlgorithm = makeConditionVariableAlgorithm(algorithm, communicationManager);
+        BufferMonitor buffer("buffer", communicationManager, mutexAlgorithm, cvAlgorithm, queueSize);
+        communicationManager->listen();
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        auto processId = static_cast<std::size_t>(communicationManager->getProcessId());
+        /** Process 0 produces the remainder of the items **/
+        std::size_t processItems = items;
+        if (processId < producers) {
+            processItems = items * consumers / producers + (processId == 0 ? items * consumers % producers : 0);
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t item = 0; item < processItems; item += batchSize) {
+            std::size_t batchItems = std::min(batchSize, processItems - item);
+            processId < producers ? buffer.produceBatch(batchItems) : buffer.consumeBatch(batchItems);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double slowestSeconds = 0;
+        MPI_Reduce(&seconds, &slowestSeconds, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        awaitQuiescence(communicationManager);
+
+        std::vector<unsigned long long> sentMessages = communicator->getSentMessages();
+        std::vector<unsigned long long> totalMessages(sentMessages.size());
+        MPI_Reduce(sentMessages.data(), totalMessages.data(), static_cast<int>(sentMessages.size()),
+                   MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        if (processId == 0) {
+            auto [count, entries, consumedBatches] = buffer.get();
+            std::uint64_t expectedEntries = 2 * items * consumers;
+            std::uint64_t expectedBatches = consumers * ((items + batchSize - 1) / batchSize);
+            unsigned long long all = 0;
+            for (unsigned long long messages : totalMessages) {
+                all += messages;
+            }
+            std::cerr << "Algorithm: " << algorithm << ", batch size: " << batchSize << ", entries: " << entries
+                      << ", time: " << slowestSeconds << " s, entries per second: "
+                      << static_cast<double>(entries) / slowestSeconds << ", messages per entry: "
+                      << static_cast<double>(all) / static_cast<double>(entries) << std::endl;
+            bool consistent = count == 0 and entries == expectedEntries and consumedBatches == expectedBatches;
+            std::cerr << "Items left: " << count << ", consumed batches: " << consumedBatches
+                      << (consistent ? " (consistent)" : " (INCONSISTENT)") << std::endl;
+            result = consistent ? 0 : 2;
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+    return result;
+}
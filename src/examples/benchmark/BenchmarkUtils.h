@@ -0,0 +1,153 @@
+#ifndef DISTRIBUTEDMONITOR_BENCHMARKUTILS_H
+#define DISTRIBUTEDMONITOR_BENCHMARKUTILS_H
+
+#include <array>
+#include <atomic>
+#include <mpi.h>
+#include <vector>
+#include <distributed/DistributedMonitor.h>
+#include <util/MessagePacking.h>
+
+/** Monitor protecting a single number **/
+class CounterMonitor : public DistributedMonitor {
+public:
+
+    using DistributedMonitor::DistributedMonitor;
+
+    std::string saveState() override {
+        std::string state;
+        appendNumber(state, value);
+        return state;
+    }
+
+    void restoreState(const std::string_view state) override {
+        value = readNumber(state, 0);
+    }
+
+    void increment() {
+        auto sync = synchronized();
+        ++value;
+    }
+
+    std::future<void> incrementAsync() {
+        return enterAsync([this]() { ++value; });
+    }
+
+    void incrementCombined() {
+        combined([this]() { ++value; });
+    }
+
+    std::uint64_t get() {
+        auto sync = synchronized();
+        return value;
+    }
+
+private:
+
+    std::uint64_t value = 0;
+};
+
+/**
+ * Waits until every packet sent to this process has been dispatched, so that no process unregisters its monitors while
+ * requests concerning them are still on their way. Has to be called once all processes stop using the monitors.
+ */
+inline void awaitQuiescence(const std::shared_ptr<CommunicationManager>& communicationManager) {
+    auto numberOfProcesses = static_cast<std::size_t>(communicationManager->getNumberOfProcesses());
+    for (std::size_t channel = 0; channel < communicationManager->getNumberOfChannels(); ++channel) {
+        std::vector<unsigned long long> sentPackets(numberOfProcesses);
+        std::vector<unsigned long long> receivedPackets(numberOfProcesses);
+        for (std::size_t processId = 0; processId < numberOfProcesses; ++processId) {
+            sentPackets[processId] = communicationManager->getSentPacketsCount(static_cast<ProcessId>(processId),
+                                                                               channel);
+        }
+        MPI_Alltoall(sentPackets.data(), 1, MPI_UNSIGNED_LONG_LONG, receivedPackets.data(), 1,
+                     MPI_UNSIGNED_LONG_LONG, MPI_COMM_WORLD);
+        for (std::size_t processId = 0; processId < numberOfProcesses; ++processId) {
+            communicationManager->awaitDispatchedPackets(static_cast<ProcessId>(processId), receivedPackets[processId],
+                                                         channel);
+        }
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+}
+
+/**
+ * 'broadcast' is DistributedConditionVariableAlgorithm, 'monitor' is MonitorStateConditionVariableAlgorithm,
+ * 'centralized' is CentralizedConditionVariableAlgorithm and 'causal' is CausalConditionVariableAlgorithm, which
+ * requires the communicator to be wrapped in a CausalCommunicator
+ */
+inline std::shared_ptr<IDistributedConditionVariableAlgorithm> makeConditionVariableAlgorithm(
+        const std::string& algorithm, const std::shared_ptr<CommunicationManager>& communicationManager) {
+    if (algorithm == "monitor") {
+        return std::make_shared<MonitorStateConditionVariableAlgorithm>(communicationManager);
+    } else if (algorithm == "centralized") {
+        return std::make_shared<CentralizedConditionVariableAlgorithm>(communicationManager);
+    } else if (algorithm == "causal") {
+        return std::make_shared<CausalConditionVariableAlgorithm>(communicationManager);
+    }
+    return std::make_shared<DistributedConditionVariableAlgorithm>(communicationManager);
+}
+
+/** Whether the message type belongs to a condition variable algorithm **/
+inline bool isConditionVariableMessage(MessageType messageType) {
+    return (messageType >= MessageType::COND_WAIT and messageType <= MessageType::COND_NOTIFY) or
+           messageType == MessageType::COND_NOTIFY_ONE or messageType == MessageType::COND_NOTIFY_ALL or
+           messageType == MessageType::COND_WAKE or messageType == MessageType::COND_WAIT_CANCEL;
+}
+
+/** Counts the messages of every type sent through the wrapped communicator **/
+class CountingCommunicator : public ICommunicator {
+public:
+
+    explicit CountingCommunicator(std::shared_ptr<ICommunicator> communicator)
+            : communicator(std::move(communicator)) { }
+
+    Packet send(MessageType messageType, const std::string& message, const Recipients& recipients) override {
+        count(messageType, recipients.size());
+        return communicator->send(messageType, message, recipients);
+    }
+
+    Packet send(MessageType messageType, const std::string& message, ProcessId recipient) override {
+        count(messageType, 1);
+        return communicator->send(messageType, message, recipient);
+    }
+
+    Packet sendOthers(MessageType messageType, const std::string& message) override {
+        count(messageType, static_cast<std::size_t>(getNumberOfProcesses()) - 1);
+        return communicator->sendOthers(messageType, message);
+    }
+
+    Packet receive() override {
+        return communicator->receive();
+    }
+
+    std::optional<Packet> receive(long timeoutMillis) override {
+        return communicator->receive(timeoutMillis);
+    }
+
+    ProcessId getProcessId() override {
+        return communicator->getProcessId();
+    }
+
+    ProcessId getNumberOfProcesses() override {
+        return communicator->getNumberOfProcesses();
+    }
+
+    LamportTime getCurrentLamportTime() override {
+        return communicator->getCurrentLamportTime();
+    }
+
+    std::vector<unsigned long long> getSentMessages() const {
+        return std::vector<unsigned long long>(sentMessages.begin(), sentMessages.end());
+    }
+
+private:
+
+    void count(MessageType messageType, std::size_t messages) {
+        sentMessages[static_cast<std::size_t>(messageType)] += messages;
+    }
+
+    std::shared_ptr<ICommunicator> communicator;
+    std::array<std::atomic<unsigned long long>, messageTypeString.size()> sentMessages {};
+};
+
+#endif //DISTRIBUTEDMONITOR_BENCHMARKUTILS_H
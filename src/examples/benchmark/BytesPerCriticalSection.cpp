@@ -0,0 +1,65 @@
+#include <communication/MpiSimpleCommunicator.h>
+#include <communication/MpiOptimizedCommunicator.h>
+#include <communication/MpiCompactCommunicator.h>
+#include <algorithms/SuzukiKasamiExclusionAlgorithm.h>
+#include "BenchmarkUtils.h"
+
+/**
+ * Measures how many bytes the processes send per critical section, depending on the wire format.
+ *
+ * Usage: mpirun -np <N> BytesPerCriticalSection <simple|optimized|compact> [critical sections per process] [ra|sk]
+ * The result is printed by process 0 to the standard error, redirect the standard output to get rid of the logs.
+ */
+
+std::shared_ptr<MpiSimpleCommunicator> createCommunicator(const std::string& format, int argc, char** argv) {
+    if (format == "simple") {
+        return std::make_shared<MpiSimpleCommunicator>(argc, argv);
+    } else if (format == "optimized") {
+        return std::make_shared<MpiOptimizedCommunicator>(argc, argv);
+    } else if (format == "compact") {
+        return std::make_shared<MpiCompactCommunicator>(argc, argv);
+    }
+    throw std::invalid_argument("Unknown wire format '" + format + "'");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <simple|optimized|compact> [critical sections per process] [ra|sk]\n";
+        return 1;
+    }
+    std::string format = argv[1];
+    int criticalSections = argc > 2 ? std::stoi(argv[2]) : 1000;
+    std::string algorithm = argc > 3 ? argv[3] : "ra";
+
+    auto communicator = createCommunicator(format, argc, argv);
+    Logger::init(communicator);
+    Logger::registerThread("Main", rang::fg::cyan);
+    {
+        auto communicationManager = std::make_shared<CommunicationManager>(communicator);
+        std::shared_ptr<IDistributedExclusionAlgorithm> mutexAlgorithm;
+        if (algorithm == "sk") {
+            mutexAlgorithm = std::make_shared<SuzukiKasamiExclusionAlgorithm>(communicationManager);
+        } else {
+            mutexAlgorithm = std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager);
+        }
+        CounterMonitor counter("benchmarkCounter", communicationManager, mutexAlgorithm);
+        communicationManager->listen();
+
+        for (int i = 0; i < criticalSections; ++i) {
+            counter.increment();
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        auto sentBytes = static_cast<unsigned long long>(communicator->getSentBytes());
+        unsigned long long totalSentBytes = 0;
+        MPI_Reduce(&sentBytes, &totalSentBytes, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        if (communicationManager->getProcessId() == 0) {
+            auto totalCriticalSections = static_cast<double>(criticalSections) * communicator->getNumberOfProcesses();
+            std::cerr << "Format: " << format << ", algorithm: " << algorithm << ", processes: "
+                      << communicator->getNumberOfProcesses() << ", critical sections: " << totalCriticalSections
+                      << ", bytes sent: " << totalSentBytes << ", bytes per critical section: "
+                      << static_cast<double>(totalSentBytes) / totalCriticalSections << std::endl;
+        }
+        awaitQuiescence(communicationManager);
+    }
+}
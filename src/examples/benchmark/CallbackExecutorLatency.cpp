@@ -0,0 +1,80 @@
+#include <chrono>
+#include <communication/MpiSimpleCommunicator.h>
+#include "BenchmarkUtils.h"
+
+/**
+ * Measures the entry latency of a monitor whose processes keep receiving SYNC messages of another, expensive to
+ * deserialize monitor. Odd processes keep entering the heavy monitor, even processes measure the light one.
+ *
+ * Usage: mpirun -np <N> CallbackExecutorLatency <callback workers> [seconds] [heavy restoreState microseconds]
+ * With 0 callback workers everything is handled by the receiving thread, so the light monitor waits for the heavy
+ * monitor's restoreState. The result is printed by process 0 to the standard error.
+ */
+class HeavyMonitor : public CounterMonitor {
+public:
+
+    HeavyMonitor(const std::string& name,
+                 const std::shared_ptr<CommunicationManager>& communicationManager,
+                 const std::shared_ptr<IDistributedExclusionAlgorithm>& mutexAlgorithm,
+                 std::chrono::microseconds restoreDuration)
+            : CounterMonitor(name, communicationManager, mutexAlgorithm), restoreDuration(restoreDuration) { }
+
+    void restoreState(const std::string_view state) override {
+        std::this_thread::sleep_for(restoreDuration);
+        CounterMonitor::restoreState(state);
+    }
+
+private:
+
+    std::chrono::microseconds restoreDuration;
+};
+
+int main(int argc, char** argv) {
+    using namespace std::chrono;
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <callback workers> [seconds] [heavy restoreState microseconds]\n";
+        return 1;
+    }
+    auto callbackWorkers = static_cast<std::size_t>(std::stoul(argv[1]));
+    seconds benchmarkDuration(argc > 2 ? std::stol(argv[2]) : 5);
+    microseconds restoreDuration(argc > 3 ? std::stol(argv[3]) : 2000);
+
+    auto communicator = std::make_shared<MpiSimpleCommunicator>(argc, argv);
+    Logger::init(communicator);
+    Logger::registerThread("Main", rang::fg::cyan);
+    {
+        auto communicationManager = std::make_shared<CommunicationManager>(communicator, callbackWorkers);
+        auto mutexAlgorithm = std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager);
+        HeavyMonitor heavy("heavyMonitor", communicationManager, mutexAlgorithm, restoreDuration);
+        CounterMonitor light("lightMonitor", communicationManager, mutexAlgorithm);
+        communicationManager->listen();
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        bool measuring = communicationManager->getProcessId() % 2 == 0;
+        unsigned long long entries = 0;
+        double totalLatencyMicros = 0;
+        auto start = steady_clock::now();
+        while (steady_clock::now() - start < benchmarkDuration) {
+            auto entryStart = steady_clock::now();
+            measuring ? light.increment() : heavy.increment();
+            totalLatencyMicros += duration_cast<duration<double, std::micro>>(steady_clock::now() - entryStart).count();
+            ++entries;
+        }
+
+        unsigned long long lightEntries = measuring ? entries : 0;
+        unsigned long long heavyEntries = measuring ? 0 : entries;
+        double lightLatencyMicros = measuring ? totalLatencyMicros : 0;
+        unsigned long long totalLightEntries, totalHeavyEntries;
+        double totalLightLatencyMicros;
+        MPI_Reduce(&lightEntries, &totalLightEntries, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&heavyEntries, &totalHeavyEntries, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&lightLatencyMicros, &totalLightLatencyMicros, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+        if (communicationManager->getProcessId() == 0) {
+            std::cerr << "Callback workers: " << callbackWorkers << ", heavy monitor entries: " << totalHeavyEntries
+                      << ", light monitor entries: " << totalLightEntries << ", mean light monitor entry latency: "
+                      << totalLightLatencyMicros / static_cast<double>(std::max(totalLightEntries, 1ULL)) << " us"
+                      << std::endl;
+        }
+        awaitQuiescence(communicationManager);
+    }
+}
@@ -0,0 +1,227 @@
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <communication/MpiSimpleCommunicator.h>
+#include "BenchmarkUtils.h"
+#include <distributed/DistributedConditionVariable.h>
+
+/**
+ * Measures the throughput of processes with many threads entering one monitor. With 'counter' every thread increments
+ * a shared counter, 'combined' does the same with flat combining (see DistributedMonitor::combined). With 'prodcons'
+ * half of the threads of every process produce items into a bounded buffer and the other half consume them (see
+ * LocalProdConsTwoCVMulti), waiting with the NOT_FULL and NOT_EMPTY classes of a MonitorStateConditionVariableAlgorithm
+ * CV. The mutex is handed over between the threads of a process up to the cohort bound times before it is released to
+ * other processes (see MutexCohort) - 0 releases it after every entry. 'local' is the baseline for 'prodcons' - the
+ * buffer of LocalProdConsTwoCVMulti, guarded by a std::mutex with two std::condition_variables, each process producing
+ * into and consuming from its own. 'prodcons' can wait with CentralizedConditionVariableAlgorithm instead, whose
+ * waits and notifications made by threads of the CV's home process send no messages. The state of the monitor is
+ * checked at the end.
+ *
+ * Usage: mpirun -np <N> CohortThroughput <counter|combined|prodcons|local> [threads per process] [entries per thread]
+ *        [cohort bound] [monitor|centralized]
+ * Logging is disabled. The result is printed by process 0 to the standard error, the exit code is non-zero if the
+ * state of the monitor is inconsistent.
+ */
+
+static constexpr WaitClass NOT_FULL = 1;
+static constexpr WaitClass NOT_EMPTY = 2;
+
+class BufferMonitor : public DistributedMonitor {
+public:
+
+    BufferMonitor(const std::string& name,
+                  const std::shared_ptr<CommunicationManager>& communicationManager,
+                  const std::shared_ptr<IDistributedExclusionAlgorithm>& mutexAlgorithm,
+                  const std::shared_ptr<IDistributedConditionVariableAlgorithm>& cvAlgorithm,
+                  std::uint64_t capacity, std::size_t cohortBound)
+
+            : DistributedMonitor(name, communicationManager, mutexAlgorithm), capacity(capacity),
+              cv("buffer", cvAlgorithm) {
+        mutex.setCohortBound(cohortBound);
+    }
+
+    std::string saveState() override {
+        std::string state;
+        appendNumber(state, count);
+        appendNumber(state, entries);
+        return state;
+    }
+
+    void restoreState(const std::string_view state) override {
+        count = readNumber(state, 0);
+        entries = readNumber(state, 1);
+    }
+
+    /** The counter mode - ignores the capacity **/
+    void increment() {
+        auto sync = synchronized();
+        std::uint64_t incremented = count + 1;
+        count = incremented;
+        ++entries;
+    }
+
+    void incrementCombined() {
+        combined([this]() {
+            std::uint64_t incremented = count + 1;
+            count = incremented;
+            ++entries;
+        });
+    }
+
+    void produce() {
+        auto sync = synchronized();
+        cv.wait(mutex, [this]() { return count < capacity; }, NOT_FULL);
+        std::uint64_t incremented = count + 1;
+        count = incremented;
+        ++entries;
+        cv.notify_one(NOT_EMPTY);
+    }
+
+    void consume() {
+        auto sync = synchronized();
+        cv.wait(mutex, [this]() { return count > 0; }, NOT_EMPTY);
+        std::uint64_t decremented = count - 1;
+        count = decremented;
+        ++entries;
+        cv.notify_one(NOT_FULL);
+    }
+
+    /** Items in the buffer and entries made **/
+    std::pair<std::uint64_t, std::uint64_t> get() {
+        auto sync = synchronized();
+        return {count, entries};
+    }
+
+private:
+
+    std::uint64_t capacity;
+    std::uint64_t count = 0;
+    std::uint64_t entries = 0;
+    DistributedConditionVariable cv;
+};
+
+/** The buffer of LocalProdConsTwoCVMulti without the output **/
+class LocalBufferMonitor {
+public:
+
+    explicit LocalBufferMonitor(std::uint64_t capacity) : capacity(capacity) { }
+
+    void produce() {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this]() { return count < capacity; });
+        ++count;
+        ++entries;
+        lock.unlock();
+        notEmpty.notify_all();
+    }
+
+    void consume() {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this]() { return count > 0; });
+        --count;
+        ++entries;
+        lock.unlock();
+        notFull.notify_all();
+    }
+
+    /** Items in the buffer and entries made **/
+    std::pair<std::uint64_t, std::uint64_t> get() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return {count, entries};
+    }
+
+private:
+
+    std::uint64_t capacity;
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+    std::uint64_t count = 0;
+    std::uint64_t entries = 0;
+};
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <counter|combined|prodcons|local> [threads per process]"
+                  << " [entries per thread] [cohort bound] [monitor|centralized]\n";
+        return 1;
+    }
+    std::string mode = argv[1];
+    std::size_t threads = argc > 2 ? std::stoul(argv[2]) : 8;
+    std::size_t entries = argc > 3 ? std::stoul(argv[3]) : 1000;
+    std::size_t cohortBound = argc > 4 ? std::stoul(argv[4]) : MutexCohort::DEFAULT_BOUND;
+    std::string cvAlgorithmName = argc > 5 ? argv[5] : "monitor";
+    bool producersConsumers = mode == "prodcons" or mode == "local";
+    if (producersConsumers and threads % 2 == 1) {
+        std::cerr << "Producers and consumers need an even number of threads" << std::endl;
+        return 1;
+    }
+
+    auto communicator = std::make_shared<MpiSimpleCommunicator>(argc, argv);
+    Logger::init(communicator);
+    Logger::setEnabled(false);
+    int result = 0;
+    {
+        auto communicationManager = std::make_shared<CommunicationManager>(communicator);
+        auto mutexAlgorithm = std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager);
+        std::shared_ptr<IDistributedConditionVariableAlgorithm> cvAlgorithm;
+        if (cvAlgorithmName == "centralized") {
+            cvAlgorithm = std::make_shared<CentralizedConditionVariableAlgorithm>(communicationManager);
+        } else {
+            cvAlgorithm = std::make_shared<MonitorStateConditionVariableAlgorithm>(communicationManager);
+        }
+        BufferMonitor buffer("buffer", communicationManager, mutexAlgorithm, cvAlgorithm, 5, cohortBound);
+        LocalBufferMonitor localBuffer(5);
+        communicationManager->listen();
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> clients;
+        for (std::size_t thread = 0; thread < threads; ++thread) {
+            clients.emplace_back([&buffer, &localBuffer, &mode, entries, thread]() {
+                for (std::size_t entry = 0; entry < entries; ++entry) {
+                    if (mode == "local") {
+                        thread % 2 == 0 ? localBuffer.produce() : localBuffer.consume();
+                    } else if (mode == "counter") {
+                        buffer.increment();
+                    } else if (mode == "combined") {
+                        buffer.incrementCombined();
+                    } else if (thread % 2 == 0) {
+                        buffer.produce();
+                    } else {
+                        buffer.consume();
+                    }
+                }
+            });
+        }
+        for (std::thread& client : clients) {
+            client.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double slowestSeconds = 0;
+        MPI_Reduce(&seconds, &slowestSeconds, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        awaitQuiescence(communicationManager);
+
+        std::array<unsigned long long, 2> localState {};
+        std::array<unsigned long long, 2> totalLocalState {};
+        std::tie(localState[0], localState[1]) = localBuffer.get();
+        MPI_Reduce(localState.data(), totalLocalState.data(), static_cast<int>(localState.size()),
+                   MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        if (communicationManager->getProcessId() == 0) {
+            auto numberOfProcesses = static_cast<std::size_t>(communicationManager->getNumberOfProcesses());
+            auto [count, entriesMade] = mode == "local" ? std::pair<std::uint64_t, std::uint64_t>(
+                    totalLocalState[0], totalLocalState[1]) : buffer.get();
+            std::uint64_t expectedEntries = threads * entries * numberOfProcesses;
+            std::uint64_t expectedCount = producersConsumers ? 0 : expectedEntries;
+            std::cerr << "Mode: " << mode << ", threads per process: " << threads << ", cohort bound: " << cohortBound
+                      << ", entries: " << entriesMade << ", time: " << slowestSeconds << " s, entries per second: "
+                      << static_cast<double>(entriesMade) / slowestSeconds << std::endl;
+            bool consistent = count == expectedCount and entriesMade == expectedEntries;
+            std::cerr << "Count: " << count << (consistent ? " (consistent)" : " (INCONSISTENT)") << std::endl;
+            result = consistent ? 0 : 2;
+        }
+        awaitQuiescence(communicationManager);
+    }
+    return result;
+}
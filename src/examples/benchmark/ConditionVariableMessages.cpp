@@ -0,0 +1,177 @@
+#include <chrono>
+#include <communication/CausalCommunicator.h>
+#include <communication/MpiSimpleCommunicator.h>
+#include "BenchmarkUtils.h"
+#include <distributed/DistributedConditionVariable.h>
+
+/**
+ * Runs the producer-consumer problem with two condition variables (see DistributedProdConsSimpleTwoCV) for a fixed
+ * number of items and counts the messages of every type sent by all processes. The first processes produce the items,
+ * the rest consume them.
+ *
+ * Usage: mpirun -np <N> ConditionVariableMessages <broadcast|monitor|centralized|causal> [items per consumer]
+ *        [queue size] [producers] [items per entry]
+ * 'broadcast' is DistributedConditionVariableAlgorithm, 'monitor' is MonitorStateConditionVariableAlgorithm,
+ * 'centralized' is CentralizedConditionVariableAlgorithm and 'causal' is CausalConditionVariableAlgorithm over
+ * a CausalCommunicator. There are N / 2 producers by default - fewer producers than consumers make the consumers wait,
+ * but 'broadcast' loses wakeups when more than one process waits on a CV. A producer putting several items in one entry
+ * notifies a consumer for each of them, so with two or more consumers waiting a lost wakeup leaves an item unconsumed
+ * and the run never ends. The result is printed by process 0 to the standard error.
+ */
+
+/** Bounded buffer which only counts its items **/
+class BufferMonitor : public DistributedMonitor {
+public:
+
+    BufferMonitor(const std::string& name,
+                  const std::shared_ptr<CommunicationManager>& communicationManager,
+                  const std::shared_ptr<IDistributedExclusionAlgorithm>& mutexAlgorithm,
+                  const std::shared_ptr<IDistributedConditionVariableAlgorithm>& cvAlgorithm,
+                  std::uint64_t capacity)
+
+            : DistributedMonitor(name, communicationManager, mutexAlgorithm), capacity(capacity),
+              queueEmptyCv("empty", cvAlgorithm), queueFullCv("full", cvAlgorithm) { }
+
+    std::string saveState() override {
+        std::string state;
+        appendNumber(state, count);
+        return state;
+    }
+
+    void restoreState(const std::string_view state) override {
+        count = readNumber(state, 0);
+    }
+
+    void produce(std::uint64_t items) {
+        auto sync = synchronized();
+        queueFullCv.wait(mutex, [&]() { return countWait(count + items <= capacity); });
+        count += items;
+        for (std::uint64_t item = 0; item < items; ++item) {
+            queueEmptyCv.notify_one();
+        }
+    }
+
+    void consume() {
+        auto sync = synchronized();
+        queueEmptyCv.wait(mutex, [&]() { return countWait(count > 0); });
+        --count;
+        queueFullCv.notify_one();
+    }
+
+    /** Number of times this process had to wait **/
+    unsigned long long getWaits() const {
+        return waits;
+    }
+
+private:
+
+    bool countWait(bool predicate) {
+        if (not predicate) {
+            ++waits;
+        }
+        return predicate;
+    }
+
+    std::uint64_t capacity;
+    std::uint64_t count = 0;
+    unsigned long long waits = 0;
+    DistributedConditionVariable queueEmptyCv;
+    DistributedConditionVariable queueFullCv;
+};
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <broadcast|monitor|centralized|causal> [items per consumer] [queue size] [producers]"
+                     " [items per entry]\n";
+        return 1;
+    }
+    std::string algorithm = argv[1];
+    std::size_t items = argc > 2 ? std::stoul(argv[2]) : 1000;
+    std::uint64_t queueSize = argc > 3 ? std::stoul(argv[3]) : 5;
+
+    auto mpiCommunicator = std::make_shared<MpiSimpleCommunicator>(argc, argv);
+    Logger::init(mpiCommunicator);
+    Logger::setEnabled(false);
+    auto numberOfProcesses = static_cast<std::size_t>(mpiCommunicator->getNumberOfProcesses());
+    std::size_t producers = argc > 4 ? std::stoul(argv[4]) : numberOfProcesses / 2;
+    std::uint64_t itemsPerEntry = argc > 5 ? std::stoul(argv[5]) : 1;
+    if (producers == 0 or producers >= numberOfProcesses) {
+        std::cerr << "There has to be at least one producer and one consumer" << std::endl;
+        return 1;
+    }
+    if (itemsPerEntry == 0 or itemsPerEntry > queueSize) {
+        std::cerr << "A producer has to put between 1 and queue size items in one entry" << std::endl;
+        return 1;
+    }
+    std::size_t consumers = numberOfProcesses - producers;
+    auto communicator = std::make_shared<CountingCommunicator>(mpiCommunicator);
+    std::shared_ptr<ICommunicator> managerCommunicator = communicator;
+    if (algorithm == "causal") {
+        managerCommunicator = std::make_shared<CausalCommunicator>(communicator);
+    }
+    {
+        auto communicationManager = std::make_shared<CommunicationManager>(managerCommunicator);
+        auto mutexAlgorithm = std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager);
+        auto cvAlgorithm = makeConditionVariableAlgorithm(algorithm, communicationManager);
+        BufferMonitor buffer("buffer", communicationManager, mutexAlgorithm, cvAlgorithm, queueSize);
+        communicationManager->listen();
+        MPI_Barrier(MPI_COMM_WORLD);
+        auto start = std::chrono::steady_clock::now();
+
+        auto processId = static_cast<std::size_t>(communicationManager->getProcessId());
+        unsigned long long entries = 0;
+        if (processId < producers) {
+            /** Process 0 produces the remainder of the items **/
+            std::size_t producedItems = items * consumers / producers;
+            if (processId == 0) {
+                producedItems += items * consumers % producers;
+            }
+            for (std::size_t item = 0; item < producedItems; item += itemsPerEntry) {
+                buffer.produce(std::min<std::uint64_t>(itemsPerEntry, producedItems - item));
+                ++entries;
+            }
+        } else {
+            for (std::size_t item = 0; item < items; ++item) {
+                buffer.consume();
+                ++entries;
+            }
+        }
+        awaitQuiescence(communicationManager);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+        std::vector<unsigned long long> sentMessages = communicator->getSentMessages();
+        std::vector<unsigned long long> totalMessages(sentMessages.size());
+        unsigned long long waits = buffer.getWaits();
+        unsigned long long totalWaits;
+        unsigned long long totalEntries;
+        MPI_Reduce(sentMessages.data(), totalMessages.data(), static_cast<int>(sentMessages.size()),
+                   MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&waits, &totalWaits, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&entries, &totalEntries, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        if (communicationManager->getProcessId() == 0) {
+            auto entries = static_cast<double>(totalEntries);
+            unsigned long long all = 0;
+            unsigned long long conditionVariableMessages = 0;
+            std::cerr << "Algorithm: " << algorithm << ", producers: " << producers << ", consumers: " << consumers
+                      << ", entries: " << entries << ", waits: " << totalWaits << ", time: " << elapsed.count() << " ms"
+                      << std::endl;
+            for (std::size_t messageType = 0; messageType < totalMessages.size(); ++messageType) {
+                if (totalMessages[messageType] == 0) {
+                    continue;
+                }
+                std::cerr << "  " << messageTypeString[messageType] << ": " << totalMessages[messageType] << std::endl;
+                all += totalMessages[messageType];
+                if (isConditionVariableMessage(static_cast<MessageType>(messageType))) {
+                    conditionVariableMessages += totalMessages[messageType];
+                }
+            }
+            auto waits = static_cast<double>(std::max(totalWaits, 1ULL));
+            std::cerr << "Messages: " << all << ", per entry: " << static_cast<double>(all) / entries << std::endl;
+            std::cerr << "CV messages: " << conditionVariableMessages << ", per entry: "
+                      << static_cast<double>(conditionVariableMessages) / entries << ", per wait: "
+                      << static_cast<double>(conditionVariableMessages) / waits << std::endl;
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+}
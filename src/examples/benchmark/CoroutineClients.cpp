@@ -0,0 +1,140 @@
+#include <chrono>
+#include <communication/MpiSimpleCommunicator.h>
+#include <distributed/CoroutineMonitor.h>
+#include "BenchmarkUtils.h"
+
+/**
+ * Runs the producer-consumer problem with many logical clients per process, each of them a coroutine (see
+ * CoroutineMonitor) instead of a thread. Half of the clients of every process produce items, the other half consume
+ * them, all of them sharing a single bounded buffer. Producers wait with the NOT_FULL class and consumers with the
+ * NOT_EMPTY one, notifying the other class with notify_one().
+ * The buffer counts the entries made into it, which is checked at the end together with the number of items left.
+ *
+ * Usage: mpirun -np <N> CoroutineClients [clients per process] [items per client] [threads] [queue size]
+ * The coroutines are resumed by the given number of threads per process (one by default). Logging is disabled. The
+ * result is printed by process 0 to the standard error, the exit code is non-zero if the buffer is inconsistent.
+ */
+
+static constexpr WaitClass NOT_FULL = 1;
+static constexpr WaitClass NOT_EMPTY = 2;
+
+class BufferMonitor : public CoroutineMonitor {
+public:
+
+    BufferMonitor(const std::string& name,
+                  const std::shared_ptr<CommunicationManager>& communicationManager,
+                  const std::shared_ptr<IDistributedExclusionAlgorithm>& mutexAlgorithm,
+                  const std::shared_ptr<IDistributedConditionVariableAlgorithm>& cvAlgorithm,
+                  CoroutineScheduler& scheduler, std::uint64_t capacity)
+
+            : CoroutineMonitor(name, communicationManager, mutexAlgorithm, scheduler), capacity(capacity),
+              cv("buffer", cvAlgorithm) { }
+
+    std::string saveState() override {
+        std::string state;
+        appendNumber(state, count);
+        appendNumber(state, entries);
+        return state;
+    }
+
+    void restoreState(const std::string_view state) override {
+        count = readNumber(state, 0);
+        entries = readNumber(state, 1);
+    }
+
+    Task<> produce() {
+        auto sync = co_await synchronized();
+        co_await wait(cv, [this]() { return count < capacity; }, NOT_FULL);
+        std::uint64_t incremented = count + 1;
+        count = incremented;
+        ++entries;
+        cv.notify_one(NOT_EMPTY);
+    }
+
+    Task<> consume() {
+        auto sync = co_await synchronized();
+        co_await wait(cv, [this]() { return count > 0; }, NOT_EMPTY);
+        std::uint64_t decremented = count - 1;
+        count = decremented;
+        ++entries;
+        cv.notify_one(NOT_FULL);
+    }
+
+    /** Items left in the buffer and entries made **/
+    std::pair<std::uint64_t, std::uint64_t> get() {
+        auto sync = DistributedMonitor::synchronized();
+        return {count, entries};
+    }
+
+private:
+
+    std::uint64_t capacity;
+    std::uint64_t count = 0;
+    std::uint64_t entries = 0;
+    DistributedConditionVariable cv;
+};
+
+Task<> producer(BufferMonitor& buffer, std::size_t items) {
+    for (std::size_t item = 0; item < items; ++item) {
+        co_await buffer.produce();
+    }
+}
+
+Task<> consumer(BufferMonitor& buffer, std::size_t items) {
+    for (std::size_t item = 0; item < items; ++item) {
+        co_await buffer.consume();
+    }
+}
+
+int main(int argc, char** argv) {
+    std::size_t clients = argc > 1 ? std::stoul(argv[1]) : 1000;
+    std::size_t items = argc > 2 ? std::stoul(argv[2]) : 10;
+    std::size_t threads = argc > 3 ? std::stoul(argv[3]) : 1;
+    std::uint64_t queueSize = argc > 4 ? std::stoul(argv[4]) : 5;
+    if (clients < 2 or threads == 0) {
+        std::cerr << "There has to be at least one producer, one consumer and one thread" << std::endl;
+        return 1;
+    }
+
+    auto communicator = std::make_shared<MpiSimpleCommunicator>(argc, argv);
+    Logger::init(communicator);
+    Logger::setEnabled(false);
+    int result = 0;
+    {
+        auto communicationManager = std::make_shared<CommunicationManager>(communicator);
+        auto mutexAlgorithm = std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager);
+        auto cvAlgorithm = std::make_shared<MonitorStateConditionVariableAlgorithm>(communicationManager);
+        CoroutineScheduler scheduler(threads);
+        BufferMonitor buffer("buffer", communicationManager, mutexAlgorithm, cvAlgorithm, scheduler, queueSize);
+        communicationManager->listen();
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t client = 0; client < clients; ++client) {
+            scheduler.spawn(client % 2 == 0 ? producer(buffer, items) : consumer(buffer, items));
+        }
+        /** With an odd number of clients the last producer has no consumer, so one more is needed **/
+        if (clients % 2 == 1) {
+            scheduler.spawn(consumer(buffer, items));
+        }
+        scheduler.wait();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double slowestSeconds = 0;
+        MPI_Reduce(&seconds, &slowestSeconds, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        awaitQuiescence(communicationManager);
+
+        if (communicationManager->getProcessId() == 0) {
+            auto numberOfProcesses = static_cast<std::size_t>(communicationManager->getNumberOfProcesses());
+            auto [count, entries] = buffer.get();
+            std::uint64_t expectedEntries = (clients + clients % 2) * items * numberOfProcesses;
+            std::cerr << "Clients per process: " << clients << ", threads per process: " << threads << ", entries: "
+                      << entries << ", time: " << slowestSeconds << " s, entries per second: "
+                      << static_cast<double>(entries) / slowestSeconds << std::endl;
+            bool consistent = count == 0 and entries == expectedEntries;
+            std::cerr << "Items left: " << count << (consistent ? " (consistent)" : " (INCONSISTENT)") << std::endl;
+            result = consistent ? 0 : 2;
+        }
+        awaitQuiescence(communicationManager);
+    }
+    return result;
+}
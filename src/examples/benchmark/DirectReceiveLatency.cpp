@@ -0,0 +1,51 @@
+#include <chrono>
+#include <communication/MpiSimpleCommunicator.h>
+#include "BenchmarkUtils.h"
+
+/**
+ * Measures the entry latency of a single monitor all processes keep entering.
+ *
+ * Usage: mpirun -np <N> DirectReceiveLatency <direct tags> [seconds]
+ * With 0 direct tags every agreement is passed from the receiving thread to the entering thread, otherwise the
+ * entering thread receives the agreements itself. The result is printed by process 0 to the standard error.
+ */
+int main(int argc, char** argv) {
+    using namespace std::chrono;
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <direct tags> [seconds]\n";
+        return 1;
+    }
+    auto directTags = static_cast<std::size_t>(std::stoul(argv[1]));
+    seconds benchmarkDuration(argc > 2 ? std::stol(argv[2]) : 5);
+
+    auto communicator = std::make_shared<MpiSimpleCommunicator>(argc, argv);
+    Logger::init(communicator);
+    Logger::registerThread("Main", rang::fg::cyan);
+    {
+        auto communicationManager = std::make_shared<CommunicationManager>(communicator, 0, 1, directTags);
+        auto mutexAlgorithm = std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager);
+        CounterMonitor monitor("monitor", communicationManager, mutexAlgorithm);
+        communicationManager->listen();
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        unsigned long long entries = 0;
+        double latencyMicros = 0;
+        auto start = steady_clock::now();
+        while (steady_clock::now() - start < benchmarkDuration) {
+            auto entryStart = steady_clock::now();
+            monitor.increment();
+            latencyMicros += duration_cast<duration<double, std::micro>>(steady_clock::now() - entryStart).count();
+            ++entries;
+        }
+
+        unsigned long long totalEntries;
+        double totalLatencyMicros;
+        MPI_Reduce(&entries, &totalEntries, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&latencyMicros, &totalLatencyMicros, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+        if (communicationManager->getProcessId() == 0) {
+            std::cerr << "Direct tags: " << directTags << ", entries: " << totalEntries << ", mean entry latency: "
+                      << totalLatencyMicros / static_cast<double>(std::max(totalEntries, 1ULL)) << " us" << std::endl;
+        }
+        awaitQuiescence(communicationManager);
+    }
+}
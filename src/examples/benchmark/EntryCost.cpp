@@ -0,0 +1,86 @@
+#include <chrono>
+#include <ctime>
+#include <communication/MpiSimpleCommunicator.h>
+#include <distributed/StaticDistributedMonitor.h>
+#include "BenchmarkUtils.h"
+
+/**
+ * Compares the CPU time the main thread spends on a single monitor entry for DistributedMonitor, which goes through
+ * the virtual IDistributedExclusionAlgorithm interface, and StaticDistributedMonitor bound to Ricart-Agrawala at compile
+ * time. Both monitors are entered in alternating rounds, so that they are measured in the same conditions.
+ *
+ * Usage: mpirun -np <N> EntryCost [entries] [rounds]
+ * Run with a single process to measure the local cost alone, with more processes the time also includes handling the
+ * agreements. Logging is disabled. The result is printed by process 0 to the standard error.
+ */
+class StaticCounterMonitor : public StaticDistributedMonitor<RicartAgrawalaExclusionAlgorithm> {
+public:
+
+    using StaticDistributedMonitor::StaticDistributedMonitor;
+
+    std::string saveState() override {
+        std::string state;
+        appendNumber(state, value);
+        return state;
+    }
+
+    void restoreState(const std::string_view state) override {
+        value = readNumber(state, 0);
+    }
+
+    void increment() {
+        auto sync = synchronized();
+        ++value;
+    }
+
+private:
+
+    std::uint64_t value = 0;
+};
+
+static double threadCpuNanos() {
+    timespec time {};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return static_cast<double>(time.tv_sec) * 1e9 + static_cast<double>(time.tv_nsec);
+}
+
+/** Returns the CPU time of the main thread spent on the entries **/
+template <typename Monitor>
+static double enter(Monitor& monitor, std::size_t entries) {
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = threadCpuNanos();
+    for (std::size_t entry = 0; entry < entries; ++entry) {
+        monitor.increment();
+    }
+    return threadCpuNanos() - start;
+}
+
+int main(int argc, char** argv) {
+    std::size_t entries = argc > 1 ? std::stoul(argv[1]) : 100000;
+    std::size_t rounds = argc > 2 ? std::stoul(argv[2]) : 5;
+
+    auto communicator = std::make_shared<MpiSimpleCommunicator>(argc, argv);
+    Logger::init(communicator);
+    Logger::setEnabled(false);
+    {
+        auto communicationManager = std::make_shared<CommunicationManager>(communicator);
+        auto mutexAlgorithm = std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager);
+        CounterMonitor dynamicMonitor("dynamic", communicationManager, mutexAlgorithm);
+        StaticCounterMonitor staticMonitor("static", communicationManager, mutexAlgorithm);
+        communicationManager->listen();
+
+        double dynamicNanos = 0;
+        double staticNanos = 0;
+        for (std::size_t round = 0; round < rounds; ++round) {
+            dynamicNanos += enter(dynamicMonitor, entries);
+            staticNanos += enter(staticMonitor, entries);
+        }
+        if (communicationManager->getProcessId() == 0) {
+            auto totalEntries = static_cast<double>(entries * rounds);
+            std::cerr << "Entries per monitor: " << entries * rounds << ", CPU time per entry: DistributedMonitor "
+                      << dynamicNanos / totalEntries << " ns, StaticDistributedMonitor "
+                      << staticNanos / totalEntries << " ns" << std::endl;
+        }
+        awaitQuiescence(communicationManager);
+    }
+}
@@ -0,0 +1,104 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+#include <random>
+#include "BenchmarkUtils.h"
+#include <distributed/DistributedConditionVariable.h>
+#include "QueueCommunicator.h"
+
+/**
+ * Creates many monitors in a single process and measures the memory each of them takes, how long registering them
+ * takes as their number grows and the rate at which mutex requests for random monitors are dispatched. Runs without
+ * MPI - the requests come from an in-memory communicator pretending that another process keeps requesting the mutexes.
+ *
+ * Usage: ManyMonitors [monitors] [requests] [condition variables per monitor]
+ */
+static std::atomic<std::size_t> liveBytes = 0;
+
+void* operator new(std::size_t size) {
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        liveBytes += malloc_usable_size(memory);
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    liveBytes -= malloc_usable_size(memory);
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    liveBytes -= malloc_usable_size(memory);
+    std::free(memory);
+}
+
+int main(int argc, char** argv) {
+    using namespace std::chrono;
+    std::size_t numberOfMonitors = argc > 1 ? std::stoul(argv[1]) : 100000;
+    std::size_t numberOfRequests = argc > 2 ? std::stoul(argv[2]) : 1000000;
+    std::size_t conditionVariablesPerMonitor = argc > 3 ? std::stoul(argv[3]) : 0;
+
+    auto communicator = std::make_shared<QueueCommunicator>();
+    Logger::init(communicator);
+    Logger::setEnabled(false);
+    auto communicationManager = std::make_shared<CommunicationManager>(communicator);
+    auto mutexAlgorithm = std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager);
+    auto conditionVariableAlgorithm = std::make_shared<DistributedConditionVariableAlgorithm>(communicationManager);
+
+    std::vector<std::string> names;
+    for (std::size_t monitor = 0; monitor < numberOfMonitors; ++monitor) {
+        names.push_back("shard" + std::to_string(monitor));
+    }
+    std::vector<std::unique_ptr<CounterMonitor>> monitors;
+    std::vector<std::unique_ptr<DistributedConditionVariable>> conditionVariables;
+    monitors.reserve(numberOfMonitors);
+    conditionVariables.reserve(numberOfMonitors * conditionVariablesPerMonitor);
+
+    /** Registration time is reported for the first and the last tenth of the monitors **/
+    std::size_t tenth = std::max<std::size_t>(numberOfMonitors / 10, 1);
+    double firstTenthSeconds = 0;
+    double lastTenthSeconds = 0;
+    std::size_t bytesBefore = liveBytes;
+    for (std::size_t monitor = 0; monitor < numberOfMonitors; ++monitor) {
+        auto start = steady_clock::now();
+        monitors.push_back(std::make_unique<CounterMonitor>(names[monitor], communicationManager, mutexAlgorithm));
+        for (std::size_t conditionVariable = 0; conditionVariable < conditionVariablesPerMonitor; ++conditionVariable) {
+            conditionVariables.push_back(std::make_unique<DistributedConditionVariable>(
+                    names[monitor] + "cv" + std::to_string(conditionVariable), conditionVariableAlgorithm));
+        }
+        double seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+        if (monitor < tenth) {
+            firstTenthSeconds += seconds;
+        }
+        if (monitor >= numberOfMonitors - tenth) {
+            lastTenthSeconds += seconds;
+        }
+    }
+    std::size_t bytesPerMonitor = (liveBytes - bytesBefore) / numberOfMonitors;
+    std::cerr << "Monitors: " << numberOfMonitors << ", condition variables per monitor: "
+              << conditionVariablesPerMonitor << ", memory per monitor: " << bytesPerMonitor << " bytes" << std::endl;
+    std::cerr << "Registration time per monitor: first tenth " << firstTenthSeconds / tenth * 1e6
+              << " us, last tenth " << lastTenthSeconds / tenth * 1e6 << " us" << std::endl;
+
+    std::mt19937 random(42);
+    std::uniform_int_distribution<std::size_t> randomMonitor(0, numberOfMonitors - 1);
+    for (std::size_t request = 0; request < numberOfRequests; ++request) {
+        communicator->push(Packet {request + 1, 1, MessageType::MUTEX_REQUEST, names[randomMonitor(random)]});
+    }
+    auto start = steady_clock::now();
+    communicationManager->listen();
+    communicationManager->awaitDispatchedPackets(1, numberOfRequests);
+    double elapsedSeconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    std::cerr << "Dispatched " << numberOfRequests << " requests for random monitors in " << elapsedSeconds << " s ("
+              << static_cast<double>(numberOfRequests) / elapsedSeconds << " requests/s)" << std::endl;
+
+    start = steady_clock::now();
+    conditionVariables.clear();
+    monitors.clear();
+    elapsedSeconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    std::cerr << "Unregistration time per monitor: " << elapsedSeconds / static_cast<double>(numberOfMonitors) * 1e6
+              << " us" << std::endl;
+}
@@ -0,0 +1,141 @@
+#include <communication/MpiSimpleCommunicator.h>
+#include <algorithms/HierarchicalExclusionAlgorithm.h>
+#include "BenchmarkUtils.h"
+
+/**
+ * Counts the messages sent between nodes per monitor entry for Ricart-Agrawala run among all processes ('flat') and
+ * for HierarchicalExclusionAlgorithm with Ricart-Agrawala among the node leaders ('hierarchical'). Every process
+ * increments a counter monitor the given number of times. Nodes are simulated - consecutive processes are grouped into
+ * nodes of the given size, so that the layouts can be compared on a single host.
+ * SYNC messages are counted apart, since the state of the monitor is sent to every process whatever the algorithm.
+ *
+ * Usage: mpirun -np <N> NodeMessages <flat|hierarchical> [processes per node] [entries per process]
+ * Logging is disabled. The result is printed by process 0 to the standard error.
+ */
+
+/** Counts the messages sent to processes of other nodes and of the same node **/
+class NodeCountingCommunicator : public ICommunicator {
+public:
+
+    NodeCountingCommunicator(std::shared_ptr<ICommunicator> communicator, std::vector<int> nodes)
+            : communicator(std::move(communicator)), nodes(std::move(nodes)) { }
+
+    Packet send(MessageType messageType, const std::string& message, const Recipients& recipients) override {
+        recipients.forEach([&](ProcessId recipient) {
+            count(messageType, recipient);
+        });
+        return communicator->send(messageType, message, recipients);
+    }
+
+    Packet send(MessageType messageType, const std::string& message, ProcessId recipient) override {
+        count(messageType, recipient);
+        return communicator->send(messageType, message, recipient);
+    }
+
+    Packet sendOthers(MessageType messageType, const std::string& message) override {
+        for (ProcessId recipient = 0; recipient < getNumberOfProcesses(); ++recipient) {
+            if (recipient != getProcessId()) {
+                count(messageType, recipient);
+            }
+        }
+        return communicator->sendOthers(messageType, message);
+    }
+
+    Packet receive() override {
+        return communicator->receive();
+    }
+
+    std::optional<Packet> receive(long timeoutMillis) override {
+        return communicator->receive(timeoutMillis);
+    }
+
+    ProcessId getProcessId() override {
+        return communicator->getProcessId();
+    }
+
+    ProcessId getNumberOfProcesses() override {
+        return communicator->getNumberOfProcesses();
+    }
+
+    LamportTime getCurrentLamportTime() override {
+        return communicator->getCurrentLamportTime();
+    }
+
+    /** Messages other than SYNC sent to other nodes, to the same node, and SYNC messages sent to other nodes **/
+    std::array<unsigned long long, 3> getSentMessages() const {
+        return {interNode, intraNode, interNodeSync};
+    }
+
+private:
+
+    void count(MessageType messageType, ProcessId recipient) {
+        bool sameNode = nodes[static_cast<std::size_t>(recipient)] == nodes[static_cast<std::size_t>(getProcessId())];
+        if (messageType == MessageType::SYNC) {
+            interNodeSync += sameNode ? 0 : 1;
+        } else {
+            ++(sameNode ? intraNode : interNode);
+        }
+    }
+
+    std::shared_ptr<ICommunicator> communicator;
+    std::vector<int> nodes;
+    std::atomic<unsigned long long> interNode = 0;
+    std::atomic<unsigned long long> intraNode = 0;
+    std::atomic<unsigned long long> interNodeSync = 0;
+};
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <flat|hierarchical> [processes per node] [entries per process]\n";
+        return 1;
+    }
+    std::string algorithm = argv[1];
+    int processesPerNode = argc > 2 ? std::stoi(argv[2]) : 2;
+    std::size_t entries = argc > 3 ? std::stoul(argv[3]) : 500;
+
+    auto mpiCommunicator = std::make_shared<MpiSimpleCommunicator>(argc, argv);
+    Logger::init(mpiCommunicator);
+    Logger::setEnabled(false);
+    std::vector<int> nodes;
+    for (ProcessId processId = 0; processId < mpiCommunicator->getNumberOfProcesses(); ++processId) {
+        nodes.push_back(processId / processesPerNode);
+    }
+    auto communicator = std::make_shared<NodeCountingCommunicator>(mpiCommunicator, nodes);
+    {
+        auto communicationManager = std::make_shared<CommunicationManager>(communicator);
+        std::shared_ptr<IDistributedExclusionAlgorithm> mutexAlgorithm;
+        if (algorithm == "hierarchical") {
+            mutexAlgorithm = std::make_shared<HierarchicalExclusionAlgorithm>(
+                    communicationManager, [](std::shared_ptr<CommunicationManager> leadersManager) {
+                        return std::make_shared<RicartAgrawalaExclusionAlgorithm>(std::move(leadersManager));
+                    }, 16, nodes);
+        } else {
+            mutexAlgorithm = std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager);
+        }
+        CounterMonitor counter("counter", communicationManager, mutexAlgorithm);
+        communicationManager->listen();
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        for (std::size_t entry = 0; entry < entries; ++entry) {
+            counter.increment();
+        }
+        awaitQuiescence(communicationManager);
+
+        std::array<unsigned long long, 3> sentMessages = communicator->getSentMessages();
+        std::array<unsigned long long, 3> totalMessages {};
+        MPI_Reduce(sentMessages.data(), totalMessages.data(), static_cast<int>(sentMessages.size()),
+                   MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        if (communicationManager->getProcessId() == 0) {
+            auto numberOfProcesses = static_cast<std::size_t>(communicationManager->getNumberOfProcesses());
+            std::uint64_t value = counter.get();
+            auto allEntries = static_cast<double>(entries * numberOfProcesses);
+            std::cerr << "Algorithm: " << algorithm << ", processes: " << numberOfProcesses << ", nodes: "
+                      << nodes.back() + 1 << ", inter-node messages per entry: " << totalMessages[0] / allEntries
+                      << ", intra-node messages per entry: " << totalMessages[1] / allEntries
+                      << ", inter-node SYNC per entry: " << totalMessages[2] / allEntries << std::endl;
+            std::cerr << "Counter: " << value
+                      << (value == entries * numberOfProcesses ? " (consistent)" : " (INCONSISTENT)") << std::endl;
+        }
+        awaitQuiescence(communicationManager);
+    }
+}
@@ -0,0 +1,70 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <communication/CommunicationManager.h>
+#include <algorithms/RicartAgrawalaExclusionAlgorithm.h>
+#include "QueueCommunicator.h"
+
+/**
+ * Measures the memory taken by queued mutex requests and the rate at which CommunicationManager dispatches them to
+ * Ricart-Agrawala. Runs in a single process without MPI - packets come from an in-memory communicator pretending that
+ * another process keeps requesting the mutex.
+ *
+ * Usage: PacketFootprint [packets] [mutex name length]
+ */
+static std::atomic<std::size_t> allocatedBytes = 0;
+
+void* operator new(std::size_t size) {
+    allocatedBytes += size;
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+int main(int argc, char** argv) {
+    using namespace std::chrono;
+    std::size_t numberOfPackets = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    std::size_t nameLength = argc > 2 ? std::stoul(argv[2]) : 8;
+    const MutexName mutexName(nameLength, 'm');
+
+    auto communicator = std::make_shared<QueueCommunicator>();
+    Logger::init(communicator);
+    Logger::setEnabled(false);
+
+    {
+        std::vector<Packet> queued;
+        queued.reserve(numberOfPackets);
+        std::size_t bytesBefore = allocatedBytes;
+        for (std::size_t i = 0; i < numberOfPackets; ++i) {
+            queued.push_back(Packet {i + 1, 1, MessageType::MUTEX_REQUEST, mutexName});
+        }
+        std::size_t heapBytes = allocatedBytes - bytesBefore;
+        std::cerr << "sizeof(Packet): " << sizeof(Packet) << " bytes, " << numberOfPackets << " queued requests take "
+                  << (numberOfPackets * sizeof(Packet) + heapBytes) / 1024 / 1024 << " MiB ("
+                  << heapBytes / numberOfPackets << " bytes per request outside of the queue)" << std::endl;
+    }
+
+    for (std::size_t i = 0; i < numberOfPackets; ++i) {
+        communicator->push(Packet {i + 1, 1, MessageType::MUTEX_REQUEST, mutexName});
+    }
+    auto communicationManager = std::make_shared<CommunicationManager>(communicator);
+    auto mutexAlgorithm = std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager);
+    mutexAlgorithm->registerMutex(mutexName);
+    auto start = steady_clock::now();
+    communicationManager->listen();
+    communicationManager->awaitDispatchedPackets(1, numberOfPackets);
+    double elapsedSeconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    std::cerr << "Dispatched " << numberOfPackets << " requests in " << elapsedSeconds << " s ("
+              << static_cast<double>(numberOfPackets) / elapsedSeconds << " requests/s)" << std::endl;
+    mutexAlgorithm->unregisterMutex(mutexName);
+}
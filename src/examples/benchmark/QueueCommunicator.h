@@ -0,0 +1,66 @@
+#ifndef DISTRIBUTEDMONITOR_QUEUECOMMUNICATOR_H
+#define DISTRIBUTEDMONITOR_QUEUECOMMUNICATOR_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <communication/ICommunicator.h>
+
+/**
+ * Communicator of process 0 out of 2 (or more), for benchmarks running in a single process without MPI. Packets
+ * pretending to come from the other processes are pushed to the queue by the benchmark. Everything sent is dropped,
+ * except for packets sent to itself, which are queued too.
+ */
+class QueueCommunicator : public ICommunicator {
+public:
+
+    explicit QueueCommunicator(ProcessId numberOfProcesses = 2) {
+        myProcessId = 0;
+        this->numberOfProcesses = numberOfProcesses;
+        currentLamportTime = 0;
+    }
+
+    Packet send(MessageType messageType, const std::string& message, const Recipients& recipients) override {
+        Packet packet {++currentLamportTime, myProcessId, messageType, message};
+        if (recipients.contains(myProcessId)) {
+            push(packet);
+        }
+        return packet;
+    }
+
+    Packet receive() override {
+        std::unique_lock<std::mutex> lock(packetsMutex);
+        packetsCondition.wait(lock, [&]() { return not packets.empty(); });
+        Packet packet = std::move(packets.front());
+        packets.pop_front();
+        return packet;
+    }
+
+    std::optional<Packet> receive(long timeoutMillis) override {
+        std::unique_lock<std::mutex> lock(packetsMutex);
+        if (not packetsCondition.wait_for(lock, std::chrono::milliseconds(timeoutMillis),
+                                          [&]() { return not packets.empty(); })) {
+            return std::nullopt;
+        }
+        Packet packet = std::move(packets.front());
+        packets.pop_front();
+        return packet;
+    }
+
+    void push(Packet packet) {
+        {
+            std::lock_guard<std::mutex> lock(packetsMutex);
+            packets.push_back(std::move(packet));
+        }
+        packetsCondition.notify_one();
+    }
+
+private:
+
+    std::deque<Packet> packets;
+    std::mutex packetsMutex;
+    std::condition_variable packetsCondition;
+};
+
+#endif //DISTRIBUTEDMONITOR_QUEUECOMMUNICATOR_H
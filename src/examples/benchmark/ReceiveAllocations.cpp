@@ -0,0 +1,82 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <communication/MpiSimpleCommunicator.h>
+#include <communication/CommunicationManager.h>
+#include <algorithms/RicartAgrawalaExclusionAlgorithm.h>
+
+/**
+ * Counts heap allocations made by process 0 while it handles mutex requests - from receiving the packet, through
+ * dispatching it, to sending the agreement back. Process 1 keeps requesting the mutex process 0 is not interested in,
+ * bypassing any CommunicationManager on its side.
+ *
+ * Usage: mpirun -np 2 ReceiveAllocations [requests]
+ * Logging is disabled. Prints the number of allocations per request in the steady state and exits with a non-zero
+ * code if there were any.
+ */
+static std::atomic<std::size_t> allocations = 0;
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+static void request(const std::shared_ptr<MpiSimpleCommunicator>& communicator, const MutexName& mutexName,
+                    std::size_t requests) {
+    for (std::size_t i = 0; i < requests; ++i) {
+        communicator->send(MessageType::MUTEX_REQUEST, mutexName, 0);
+        communicator->receive();
+    }
+}
+
+int main(int argc, char** argv) {
+    std::size_t requests = argc > 1 ? std::stoul(argv[1]) : 10000;
+    const MutexName mutexName = "mutex";
+
+    auto communicator = std::make_shared<MpiSimpleCommunicator>(argc, argv);
+    Logger::init(communicator);
+    Logger::setEnabled(false);
+    if (communicator->getNumberOfProcesses() != 2) {
+        std::cerr << "Run with exactly 2 processes" << std::endl;
+        return 1;
+    }
+    int result = 0;
+    if (communicator->getProcessId() == 0) {
+        auto communicationManager = std::make_shared<CommunicationManager>(communicator);
+        auto mutexAlgorithm = std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager);
+        mutexAlgorithm->registerMutex(mutexName);
+        communicationManager->listen();
+        /** Warm-up **/
+        MPI_Barrier(MPI_COMM_WORLD);
+        MPI_Barrier(MPI_COMM_WORLD);
+        std::size_t allocationsBefore = allocations;
+        MPI_Barrier(MPI_COMM_WORLD);
+        MPI_Barrier(MPI_COMM_WORLD);
+        std::size_t allocationsAfter = allocations;
+        double perRequest = static_cast<double>(allocationsAfter - allocationsBefore) / static_cast<double>(requests);
+        std::cerr << "Requests: " << requests << ", allocations: " << allocationsAfter - allocationsBefore
+                  << ", allocations per request: " << perRequest << std::endl;
+        result = allocationsAfter == allocationsBefore ? 0 : 2;
+        mutexAlgorithm->unregisterMutex(mutexName);
+    } else {
+        MPI_Barrier(MPI_COMM_WORLD);
+        request(communicator, mutexName, requests / 10 + 1);
+        MPI_Barrier(MPI_COMM_WORLD);
+        MPI_Barrier(MPI_COMM_WORLD);
+        request(communicator, mutexName, requests);
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    return result;
+}
@@ -0,0 +1,91 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <communication/GroupCommunicationManager.h>
+#include "QueueCommunicator.h"
+
+/**
+ * Measures heap allocations and CPU time of sending a message to many processes - to a single one, to all the others,
+ * to a half of them given as a ProcessSet and to the members of a group. Runs without MPI - the messages are dropped by
+ * an in-memory communicator pretending that there are the given number of processes.
+ *
+ * Usage: RecipientAllocations [processes] [sends]
+ */
+static std::atomic<std::size_t> allocations = 0;
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+template <typename Send>
+static void measure(const std::string& description, std::size_t sends, Send send) {
+    using namespace std::chrono;
+    send();
+    std::size_t allocationsBefore = allocations;
+    auto start = steady_clock::now();
+    for (std::size_t i = 0; i < sends; ++i) {
+        send();
+    }
+    auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    std::size_t sendAllocations = allocations - allocationsBefore;
+    std::cerr << description << ": " << static_cast<double>(sendAllocations) / static_cast<double>(sends)
+              << " allocations, " << elapsed / static_cast<long>(sends) << " ns per send" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    auto numberOfProcesses = static_cast<ProcessId>(argc > 1 ? std::stol(argv[1]) : 4096);
+    std::size_t sends = argc > 2 ? std::stoul(argv[2]) : 10000;
+    const std::string mutexName = "mutex";
+
+    auto communicator = std::make_shared<QueueCommunicator>(numberOfProcesses);
+    Logger::init(communicator);
+    Logger::setEnabled(false);
+    auto communicationManager = std::make_shared<CommunicationManager>(communicator);
+
+    ProcessSet oddProcesses(static_cast<std::size_t>(numberOfProcesses));
+    std::vector<ProcessId> evenProcesses;
+    for (ProcessId processId = 0; processId < numberOfProcesses; ++processId) {
+        if (processId % 2 == 1) {
+            oddProcesses.insert(processId);
+        } else {
+            evenProcesses.push_back(processId);
+        }
+    }
+    auto groupManager = std::make_shared<GroupCommunicationManager>(communicationManager, evenProcesses);
+    ProcessSet groupHalf(evenProcesses.size());
+    for (ProcessId groupId = 1; groupId < static_cast<ProcessId>(evenProcesses.size()); groupId += 2) {
+        groupHalf.insert(groupId);
+    }
+
+    std::cerr << "Processes: " << numberOfProcesses << std::endl;
+    measure("Single process", sends, [&]() {
+        communicationManager->send(MessageType::MUTEX_AGREEMENT, mutexName, numberOfProcesses - 1);
+    });
+    measure("All other processes", sends, [&]() {
+        communicationManager->sendOthers(MessageType::MUTEX_REQUEST, mutexName);
+    });
+    measure("Half of the processes", sends, [&]() {
+        communicationManager->send(MessageType::MUTEX_REQUEST, mutexName, oddProcesses);
+    });
+    measure("Other members of a group", sends, [&]() {
+        groupManager->sendOthers(MessageType::MUTEX_REQUEST, mutexName);
+    });
+    measure("Half of a group", sends, [&]() {
+        groupManager->send(MessageType::MUTEX_REQUEST, mutexName, groupHalf);
+    });
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <chrono>
+#include <communication/MpiSimpleCommunicator.h>
+#include "BenchmarkUtils.h"
+
+/**
+ * Measures the total throughput of independent monitors. Every process runs one thread per monitor, each thread keeps
+ * entering its monitor for the given time.
+ *
+ * Usage: mpirun -np <N> ShardedThroughput <channels> [monitors] [seconds] [callback workers]
+ * With a single channel all monitors share one receiving thread. The result is printed by process 0 to the standard
+ * error.
+ */
+int main(int argc, char** argv) {
+    using namespace std::chrono;
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <channels> [monitors] [seconds] [callback workers]\n";
+        return 1;
+    }
+    auto channels = static_cast<std::size_t>(std::stoul(argv[1]));
+    std::size_t numberOfMonitors = argc > 2 ? std::stoul(argv[2]) : 8;
+    seconds benchmarkDuration(argc > 3 ? std::stol(argv[3]) : 5);
+    std::size_t callbackWorkers = argc > 4 ? std::stoul(argv[4]) : 0;
+
+    auto communicator = std::make_shared<MpiSimpleCommunicator>(argc, argv);
+    Logger::init(communicator);
+    Logger::registerThread("Main", rang::fg::cyan);
+    {
+        auto communicationManager = std::make_shared<CommunicationManager>(communicator, callbackWorkers, channels);
+        auto mutexAlgorithm = std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager);
+        std::vector<std::unique_ptr<CounterMonitor>> monitors;
+        for (std::size_t monitor = 0; monitor < numberOfMonitors; ++monitor) {
+            monitors.push_back(std::make_unique<CounterMonitor>("monitor" + std::to_string(monitor),
+                                                                communicationManager, mutexAlgorithm));
+        }
+        communicationManager->listen();
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        std::vector<unsigned long long> entries(numberOfMonitors, 0);
+        std::vector<std::thread> threads;
+        auto start = steady_clock::now();
+        for (std::size_t monitor = 0; monitor < numberOfMonitors; ++monitor) {
+            threads.emplace_back([&, monitor]() {
+                Logger::registerThread("Main" + std::to_string(monitor), rang::fg::cyan);
+                while (steady_clock::now() - start < benchmarkDuration) {
+                    monitors[monitor]->increment();
+                    ++entries[monitor];
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        double elapsedSeconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+        unsigned long long processEntries = 0;
+        for (unsigned long long monitorEntries : entries) {
+            processEntries += monitorEntries;
+        }
+        unsigned long long totalEntries;
+        MPI_Reduce(&processEntries, &totalEntries, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        if (communicationManager->getProcessId() == 0) {
+            std::cerr << "Channels: " << channels << ", monitors: " << numberOfMonitors << ", entries: "
+                      << totalEntries << ", throughput: " << static_cast<double>(totalEntries) / elapsedSeconds
+                      << " entries/s" << std::endl;
+        }
+        awaitQuiescence(communicationManager);
+    }
+}
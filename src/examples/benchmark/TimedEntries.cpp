@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <communication/MpiSimpleCommunicator.h>
+#include <algorithms/AdaptiveExclusionAlgorithm.h>
+#include <algorithms/HierarchicalExclusionAlgorithm.h>
+#include <algorithms/RmaMcsExclusionAlgorithm.h>
+#include <algorithms/SuzukiKasamiExclusionAlgorithm.h>
+#include "BenchmarkUtils.h"
+
+/**
+ * Measures the latency of monitor entries under overload - every process enters a counter monitor whose critical
+ * section takes a fixed time, so that the mutex is always contended. With a timeout the entries are made with
+ * synchronizedFor() and an attempt which runs out of time is given up, without a timeout they block until they succeed.
+ * The latency of an attempt is measured until it leaves the monitor or gives up. The counter is checked against the
+ * number of successful entries at the end, since an entry granted after it was given up would break mutual exclusion,
+ * and every attempt which gave up has to have lasted at least the timeout - and at most a second longer.
+ *
+ * Usage: mpirun -np <N> TimedEntries [timeout ms, 0 blocks] [entries] [critical section us] [direct tags]
+ *        [ra|sk|adaptive|hierarchical|rma]
+ * With direct tags Ricart-Agrawala receives the agreements with the acquiring thread. 'hierarchical' runs
+ * Ricart-Agrawala among the leaders of the nodes of processes sharing a host, 'rma' needs an MPI transport supporting
+ * one-sided atomics. Logging is disabled. The result is printed by process 0 to the standard error, the exit code is
+ * non-zero if the check fails.
+ */
+class SlowCounterMonitor : public DistributedMonitor {
+public:
+
+    SlowCounterMonitor(const std::string& name,
+                       const std::shared_ptr<CommunicationManager>& communicationManager,
+                       const std::shared_ptr<IDistributedExclusionAlgorithm>& mutexAlgorithm,
+                       std::chrono::microseconds criticalSection)
+
+            : DistributedMonitor(name, communicationManager, mutexAlgorithm), criticalSection(criticalSection) { }
+
+    std::string saveState() override {
+        std::string state;
+        appendNumber(state, value);
+        return state;
+    }
+
+    void restoreState(const std::string_view state) override {
+        value = readNumber(state, 0);
+    }
+
+    /** Returns false if the monitor could not be entered within the timeout **/
+    bool increment(std::chrono::milliseconds timeout) {
+        auto sync = timeout.count() > 0 ? synchronizedFor(timeout) : synchronized();
+        if (not sync) {
+            return false;
+        }
+        std::uint64_t incremented = value + 1;
+        std::this_thread::sleep_for(criticalSection);
+        value = incremented;
+        return true;
+    }
+
+    std::uint64_t get() {
+        auto sync = synchronized();
+        return value;
+    }
+
+private:
+
+    std::chrono::microseconds criticalSection;
+    std::uint64_t value = 0;
+};
+
+int main(int argc, char** argv) {
+    using namespace std::chrono;
+    milliseconds timeout(argc > 1 ? std::stol(argv[1]) : 0);
+    std::size_t entries = argc > 2 ? std::stoul(argv[2]) : 1000;
+    microseconds criticalSection(argc > 3 ? std::stol(argv[3]) : 200);
+    std::size_t directTags = argc > 4 ? std::stoul(argv[4]) : 0;
+    std::string algorithm = argc > 5 ? argv[5] : "ra";
+
+    auto communicator = std::make_shared<MpiSimpleCommunicator>(argc, argv);
+    Logger::init(communicator);
+    Logger::setEnabled(false);
+    int result = 0;
+    {
+        auto communicationManager = std::make_shared<CommunicationManager>(communicator, 0, 1, directTags);
+        std::shared_ptr<IDistributedExclusionAlgorithm> mutexAlgorithm;
+        if (algorithm == "sk") {
+            mutexAlgorithm = std::make_shared<SuzukiKasamiExclusionAlgorithm>(communicationManager);
+        } else if (algorithm == "adaptive") {
+            mutexAlgorithm = std::make_shared<AdaptiveExclusionAlgorithm>(
+                    communicationManager, std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager),
+                    std::make_shared<SuzukiKasamiExclusionAlgorithm>(communicationManager));
+        } else if (algorithm == "hierarchical") {
+            mutexAlgorithm = std::make_shared<HierarchicalExclusionAlgorithm>(
+                    communicationManager, [](std::shared_ptr<CommunicationManager> leadersManager) {
+                        return std::make_shared<RicartAgrawalaExclusionAlgorithm>(std::move(leadersManager));
+                    });
+        } else if (algorithm == "rma") {
+            mutexAlgorithm = std::make_shared<RmaMcsExclusionAlgorithm>(communicationManager);
+        } else {
+            mutexAlgorithm = std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager);
+        }
+        SlowCounterMonitor counter("counter", communicationManager, mutexAlgorithm, criticalSection);
+        communicationManager->listen();
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        std::vector<double> latencies;
+        latencies.reserve(entries);
+        unsigned long long succeeded = 0;
+        /** Latencies of the attempts which gave up **/
+        double shortestGiveUp = 1e12;
+        double longestGiveUp = 0;
+        for (std::size_t entry = 0; entry < entries; ++entry) {
+            auto start = steady_clock::now();
+            bool entered = counter.increment(timeout);
+            double latency = duration<double, std::micro>(steady_clock::now() - start).count();
+            succeeded += entered ? 1 : 0;
+            if (not entered) {
+                shortestGiveUp = std::min(shortestGiveUp, latency);
+                longestGiveUp = std::max(longestGiveUp, latency);
+            }
+            latencies.push_back(latency);
+        }
+        awaitQuiescence(communicationManager);
+
+        unsigned long long totalSucceeded = 0;
+        double totalShortestGiveUp = 0;
+        double totalLongestGiveUp = 0;
+        MPI_Reduce(&succeeded, &totalSucceeded, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&shortestGiveUp, &totalShortestGiveUp, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&longestGiveUp, &totalLongestGiveUp, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        auto numberOfProcesses = static_cast<std::size_t>(communicationManager->getNumberOfProcesses());
+        std::vector<double> allLatencies(entries * numberOfProcesses);
+        MPI_Gather(latencies.data(), static_cast<int>(entries), MPI_DOUBLE, allLatencies.data(),
+                   static_cast<int>(entries), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        if (communicationManager->getProcessId() == 0) {
+            std::uint64_t value = counter.get();
+            bool consistent = value == totalSucceeded;
+            double timeoutMicroseconds = duration<double, std::micro>(timeout).count();
+            bool expired = totalSucceeded == allLatencies.size() or
+                           (totalShortestGiveUp >= timeoutMicroseconds and
+                            totalLongestGiveUp <= timeoutMicroseconds + 1e6);
+            std::sort(allLatencies.begin(), allLatencies.end());
+            auto percentile = [&](double fraction) {
+                return allLatencies[static_cast<std::size_t>(fraction * static_cast<double>(allLatencies.size() - 1))];
+            };
+            std::cerr << "Algorithm: " << algorithm << ", timeout: " << timeout.count() << " ms, attempts: "
+                      << allLatencies.size() << ", entered: " << totalSucceeded << ", gave up: "
+                      << allLatencies.size() - totalSucceeded << std::endl;
+            std::cerr << "Latency p50: " << percentile(0.5) << " us, p99: " << percentile(0.99) << " us, p99.9: "
+                      << percentile(0.999) << " us, max: " << allLatencies.back() << " us" << std::endl;
+            if (totalSucceeded < allLatencies.size()) {
+                std::cerr << "Gave up after: min " << totalShortestGiveUp << " us, max " << totalLongestGiveUp << " us"
+                          << (expired ? "" : " (NOT AT THE TIMEOUT)") << std::endl;
+            }
+            std::cerr << "Counter: " << value << (consistent ? " (consistent)" : " (INCONSISTENT)") << std::endl;
+            result = consistent and expired ? 0 : 2;
+        }
+        awaitQuiescence(communicationManager);
+    }
+    return result;
+}
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <communication/MpiSimpleCommunicator.h>
+#include <communication/CausalCommunicator.h>
+#include <distributed/DistributedConditionVariable.h>
+#include "BenchmarkUtils.h"
+
+/**
+ * Checks timed waits on a condition variable. Process 0 produces items one at a time, notifying a single consumer
+ * with notify_one() and pausing between the items. Process 1 consumes them with blocking waits, the other processes
+ * with waits limited by the timeout, trying again after giving up. A notification addressed to a wait which is just
+ * running out of time has to be passed on to another waiting process, otherwise process 1 could miss it. Once all
+ * the items are produced the buffer is closed and the consumers take what is left.
+ * At the end every item has to be consumed exactly once, and every wait which gave up has to have lasted at least the
+ * timeout - and at most a second longer, so that a timed wait which is never woken up is caught as well.
+ *
+ * Usage: mpirun -np <N> TimedWaits [timeout ms] [items] [pause us] [broadcast|monitor|centralized|causal]
+ * Logging is disabled. The result is printed by process 0 to the standard error, the exit code is non-zero if the
+ * check fails.
+ */
+class ClosableBufferMonitor : public DistributedMonitor {
+public:
+
+    enum class Attempt {
+        CONSUMED, TIMED_OUT, CLOSED
+    };
+
+    ClosableBufferMonitor(const std::string& name,
+                          const std::shared_ptr<CommunicationManager>& communicationManager,
+                          const std::shared_ptr<IDistributedExclusionAlgorithm>& mutexAlgorithm,
+                          const std::shared_ptr<IDistributedConditionVariableAlgorithm>& cvAlgorithm)
+
+            : DistributedMonitor(name, communicationManager, mutexAlgorithm), cv("buffer", cvAlgorithm) { }
+
+    std::string saveState() override {
+        std::string state;
+        appendNumber(state, count);
+        appendNumber(state, consumed);
+        appendNumber(state, closed ? 1 : 0);
+        return state;
+    }
+
+    void restoreState(const std::string_view state) override {
+        count = readNumber(state, 0);
+        consumed = readNumber(state, 1);
+        closed = readNumber(state, 2) != 0;
+    }
+
+    void produce() {
+        auto sync = synchronized();
+        ++count;
+        cv.notify_one();
+    }
+
+    void close() {
+        auto sync = synchronized();
+        closed = true;
+        cv.notify_all();
+    }
+
+    /** A timeout of zero waits without a limit. 'waited' is set to how long a wait which gave up lasted. **/
+    Attempt consume(std::chrono::milliseconds timeout, std::chrono::steady_clock::duration& waited) {
+        auto sync = synchronized();
+        auto available = [this]() { return count > 0 or closed; };
+        if (timeout.count() == 0) {
+            cv.wait(mutex, available);
+        } else {
+            auto start = std::chrono::steady_clock::now();
+            if (not cv.wait_for(mutex, timeout, available)) {
+                waited = std::chrono::steady_clock::now() - start;
+                return Attempt::TIMED_OUT;
+            }
+        }
+        if (count == 0) {
+            return Attempt::CLOSED;
+        }
+        std::uint64_t decremented = count - 1;
+        count = decremented;
+        ++consumed;
+        return Attempt::CONSUMED;
+    }
+
+    /** Items left and consumed **/
+    std::pair<std::uint64_t, std::uint64_t> get() {
+        auto sync = synchronized();
+        return {count, consumed};
+    }
+
+private:
+
+    std::uint64_t count = 0;
+    std::uint64_t consumed = 0;
+    bool closed = false;
+    DistributedConditionVariable cv;
+};
+
+int main(int argc, char** argv) {
+    using namespace std::chrono;
+    milliseconds timeout(argc > 1 ? std::stol(argv[1]) : 2);
+    std::size_t items = argc > 2 ? std::stoul(argv[2]) : 500;
+    microseconds pause(argc > 3 ? std::stol(argv[3]) : 1000);
+    std::string algorithm = argc > 4 ? argv[4] : "broadcast";
+    if (timeout.count() == 0) {
+        std::cerr << "The timeout has to be positive" << std::endl;
+        return 1;
+    }
+
+    auto mpiCommunicator = std::make_shared<MpiSimpleCommunicator>(argc, argv);
+    Logger::init(mpiCommunicator);
+    Logger::setEnabled(false);
+    std::shared_ptr<ICommunicator> communicator = mpiCommunicator;
+    if (algorithm == "causal") {
+        communicator = std::make_shared<CausalCommunicator>(mpiCommunicator);
+    }
+    int result = 0;
+    {
+        auto communicationManager = std::make_shared<CommunicationManager>(communicator);
+        auto mutexAlgorithm = std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager);
+        auto cvAlgorithm = makeConditionVariableAlgorithm(algorithm, communicationManager);
+        ClosableBufferMonitor buffer("buffer", communicationManager, mutexAlgorithm, cvAlgorithm);
+        communicationManager->listen();
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        /** Waits which gave up, the shortest and the longest of them in microseconds **/
+        unsigned long long timedOut = 0;
+        double shortestWait = 1e12;
+        double longestWait = 0;
+        ProcessId processId = communicationManager->getProcessId();
+        if (processId == 0) {
+            for (std::size_t item = 0; item < items; ++item) {
+                buffer.produce();
+                std::this_thread::sleep_for(pause);
+            }
+            buffer.close();
+        } else {
+            milliseconds consumerTimeout = processId == 1 ? milliseconds(0) : timeout;
+            steady_clock::duration waited {};
+            ClosableBufferMonitor::Attempt attempt;
+            while ((attempt = buffer.consume(consumerTimeout, waited)) != ClosableBufferMonitor::Attempt::CLOSED) {
+                if (attempt == ClosableBufferMonitor::Attempt::TIMED_OUT) {
+                    double waitedMicroseconds = duration<double, std::micro>(waited).count();
+                    ++timedOut;
+                    shortestWait = std::min(shortestWait, waitedMicroseconds);
+                    longestWait = std::max(longestWait, waitedMicroseconds);
+                }
+            }
+        }
+        awaitQuiescence(communicationManager);
+
+        unsigned long long totalTimedOut = 0;
+        double totalShortestWait = 0;
+        double totalLongestWait = 0;
+        MPI_Reduce(&timedOut, &totalTimedOut, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&shortestWait, &totalShortestWait, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&longestWait, &totalLongestWait, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        if (processId == 0) {
+            auto [count, consumed] = buffer.get();
+            bool consistent = count == 0 and consumed == items;
+            double timeoutMicroseconds = duration<double, std::micro>(timeout).count();
+            bool expired = totalTimedOut == 0 or (totalShortestWait >= timeoutMicroseconds and
+                                                  totalLongestWait <= timeoutMicroseconds + 1e6);
+            std::cerr << "Algorithm: " << algorithm << ", timeout: " << timeout.count() << " ms, items: " << items
+                      << ", timed out waits: " << totalTimedOut << std::endl;
+            if (totalTimedOut > 0) {
+                std::cerr << "Timed out after: min " << totalShortestWait << " us, max " << totalLongestWait << " us"
+                          << (expired ? "" : " (NOT AT THE TIMEOUT)") << std::endl;
+            }
+            std::cerr << "Items left: " << count << ", consumed: " << consumed
+                      << (consistent ? " (consistent)" : " (INCONSISTENT)") << std::endl;
+            result = consistent and expired ? 0 : 2;
+        }
+        awaitQuiescence(communicationManager);
+    }
+    return result;
+}
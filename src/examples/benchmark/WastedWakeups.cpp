@@ -0,0 +1,183 @@
+#include <communication/CausalCommunicator.h>
+#include <communication/MpiSimpleCommunicator.h>
+#include "BenchmarkUtils.h"
+#include <distributed/DistributedConditionVariable.h>
+
+/**
+ * Runs the producer-consumer problem with a single condition variable (see DistributedProdConsSimple) for a fixed
+ * number of items and counts the wakeups after which the woken process found its predicate still false and had to wait
+ * again.
+ * The first processes produce the items, the rest consume them.
+ *
+ * Usage: mpirun -np <N> WastedWakeups <broadcast|monitor|centralized|causal> <one|all|classes> [items per consumer]
+ *        [queue size] [producers]
+ * 'one' notifies with notify_one() - it may wake up a process of the same kind, which waits again without passing the
+ * notification on, so the run may hang when everybody ends up waiting. 'all' notifies everybody with notify_all().
+ * 'classes' waits with the NOT_FULL or NOT_EMPTY class and notifies the other one with notify_one(). There are N / 2
+ * producers by default. The result is printed by process 0 to the standard error.
+ */
+
+static constexpr WaitClass NOT_FULL = 1;
+static constexpr WaitClass NOT_EMPTY = 2;
+
+/** Bounded buffer which only counts its items **/
+class BufferMonitor : public DistributedMonitor {
+public:
+
+    BufferMonitor(const std::string& name,
+                  const std::shared_ptr<CommunicationManager>& communicationManager,
+                  const std::shared_ptr<IDistributedExclusionAlgorithm>& mutexAlgorithm,
+                  const std::shared_ptr<IDistributedConditionVariableAlgorithm>& cvAlgorithm,
+                  std::uint64_t capacity, std::string notification)
+
+            : DistributedMonitor(name, communicationManager, mutexAlgorithm), capacity(capacity),
+              notification(std::move(notification)), cv("buffer", cvAlgorithm) { }
+
+    std::string saveState() override {
+        std::string state;
+        appendNumber(state, count);
+        return state;
+    }
+
+    void restoreState(const std::string_view state) override {
+        count = readNumber(state, 0);
+    }
+
+    void produce() {
+        auto sync = synchronized();
+        bool firstCheck = true;
+        cv.wait(mutex, [&]() { return countCheck(count < capacity, firstCheck); }, waitClass(NOT_FULL));
+        ++count;
+        notify(NOT_EMPTY);
+    }
+
+    void consume() {
+        auto sync = synchronized();
+        bool firstCheck = true;
+        cv.wait(mutex, [&]() { return countCheck(count > 0, firstCheck); }, waitClass(NOT_EMPTY));
+        --count;
+        notify(NOT_FULL);
+    }
+
+    /** Number of waits, wakeups and wakeups after which the predicate was still false **/
+    std::array<unsigned long long, 3> getStatistics() const {
+        return {waits, wakeups, wastedWakeups};
+    }
+
+private:
+
+    WaitClass waitClass(WaitClass waitClass) const {
+        return notification == "classes" ? waitClass : ANY_WAIT_CLASS;
+    }
+
+    void notify(WaitClass waitClass) {
+        if (notification == "all") {
+            cv.notify_all();
+        } else {
+            cv.notify_one(this->waitClass(waitClass));
+        }
+    }
+
+    /** Every check of the predicate but the first one follows a wakeup **/
+    bool countCheck(bool predicate, bool& firstCheck) {
+        if (firstCheck) {
+            firstCheck = false;
+            waits += predicate ? 0 : 1;
+        } else {
+            ++wakeups;
+            wastedWakeups += predicate ? 0 : 1;
+        }
+        return predicate;
+    }
+
+    std::uint64_t capacity;
+    std::string notification;
+    std::uint64_t count = 0;
+    unsigned long long waits = 0;
+    unsigned long long wakeups = 0;
+    unsigned long long wastedWakeups = 0;
+    DistributedConditionVariable cv;
+};
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <broadcast|monitor|centralized|causal> <one|all|classes>"
+                  << " [items per consumer] [queue size] [producers]\n";
+        return 1;
+    }
+    std::string algorithm = argv[1];
+    std::string notification = argv[2];
+    std::size_t items = argc > 3 ? std::stoul(argv[3]) : 1000;
+    std::uint64_t queueSize = argc > 4 ? std::stoul(argv[4]) : 5;
+
+    auto mpiCommunicator = std::make_shared<MpiSimpleCommunicator>(argc, argv);
+    Logger::init(mpiCommunicator);
+    Logger::setEnabled(false);
+    auto numberOfProcesses = static_cast<std::size_t>(mpiCommunicator->getNumberOfProcesses());
+    std::size_t producers = argc > 5 ? std::stoul(argv[5]) : numberOfProcesses / 2;
+    if (producers == 0 or producers >= numberOfProcesses) {
+        std::cerr << "There has to be at least one producer and one consumer" << std::endl;
+        return 1;
+    }
+    std::size_t consumers = numberOfProcesses - producers;
+    auto communicator = std::make_shared<CountingCommunicator>(mpiCommunicator);
+    std::shared_ptr<ICommunicator> managerCommunicator = communicator;
+    if (algorithm == "causal") {
+        managerCommunicator = std::make_shared<CausalCommunicator>(communicator);
+    }
+    {
+        auto communicationManager = std::make_shared<CommunicationManager>(managerCommunicator);
+        auto mutexAlgorithm = std::make_shared<RicartAgrawalaExclusionAlgorithm>(communicationManager);
+        auto cvAlgorithm = makeConditionVariableAlgorithm(algorithm, communicationManager);
+        BufferMonitor buffer("buffer", communicationManager, mutexAlgorithm, cvAlgorithm, queueSize, notification);
+        communicationManager->listen();
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        auto processId = static_cast<std::size_t>(communicationManager->getProcessId());
+        if (processId < producers) {
+            /** Process 0 produces the remainder of the items **/
+            std::size_t producedItems = items * consumers / producers;
+            if (processId == 0) {
+                producedItems += items * consumers % producers;
+            }
+            for (std::size_t item = 0; item < producedItems; ++item) {
+                buffer.produce();
+            }
+        } else {
+            for (std::size_t item = 0; item < items; ++item) {
+                buffer.consume();
+            }
+        }
+        awaitQuiescence(communicationManager);
+
+        std::array<unsigned long long, 3> statistics = buffer.getStatistics();
+        std::array<unsigned long long, 3> totalStatistics {};
+        std::vector<unsigned long long> sentMessages = communicator->getSentMessages();
+        std::vector<unsigned long long> totalMessages(sentMessages.size());
+        MPI_Reduce(statistics.data(), totalStatistics.data(), static_cast<int>(statistics.size()),
+                   MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        MPI_Reduce(sentMessages.data(), totalMessages.data(), static_cast<int>(sentMessages.size()),
+                   MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        if (communicationManager->getProcessId() == 0) {
+            auto [waits, wakeups, wastedWakeups] = totalStatistics;
+            auto entries = static_cast<double>(2 * items * consumers);
+            unsigned long long all = 0;
+            unsigned long long conditionVariableMessages = 0;
+            for (std::size_t messageType = 0; messageType < totalMessages.size(); ++messageType) {
+                all += totalMessages[messageType];
+                if (isConditionVariableMessage(static_cast<MessageType>(messageType))) {
+                    conditionVariableMessages += totalMessages[messageType];
+                }
+            }
+            std::cerr << "Algorithm: " << algorithm << ", notification: " << notification << ", producers: "
+                      << producers << ", consumers: " << consumers << ", entries: " << entries << std::endl;
+            double wastedPercent = 100.0 * static_cast<double>(wastedWakeups)
+                                   / static_cast<double>(std::max(wakeups, 1ULL));
+            std::cerr << "Waits: " << waits << ", wakeups: " << wakeups << ", wasted wakeups: " << wastedWakeups
+                      << " (" << wastedPercent << "%)" << std::endl;
+            std::cerr << "Messages per entry: " << static_cast<double>(all) / entries << ", CV messages per entry: "
+                      << static_cast<double>(conditionVariableMessages) / entries << std::endl;
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+}
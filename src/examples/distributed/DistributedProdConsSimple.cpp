@@ -4,6 +4,10 @@
 
 #define MAX_QUEUE_SIZE 5
 
+/** Producers and consumers wait on the same CV - the classes let a notification wake up the right one of them **/
+static constexpr WaitClass NOT_FULL = 1;
+static constexpr WaitClass NOT_EMPTY = 2;
+
 /**
  * In this example I present a Producer-Consumer problem without the Boost dependency.
  *
@@ -42,22 +46,22 @@ public:
 
     void produce(char request) {
         auto sync = synchronized();
-        cv.wait(mutex, [&]() { return not isFull(); });
+        cv.wait(mutex, [&]() { return not isFull(); }, NOT_FULL);
         buffer[static_cast<unsigned char>(putIndex)] = request;
         ++count;
         Logger::log("Produced request " + std::to_string(request) + " at index " + std::to_string(putIndex) + ". Count: " + std::to_string(count));
         putIndex = (putIndex + 1) % MAX_QUEUE_SIZE;
-        cv.notify_one();
+        cv.notify_one(NOT_EMPTY);
     }
 
     char consume() {
         auto sync = synchronized();
-        cv.wait(mutex, [&]() { return not isEmpty(); });
+        cv.wait(mutex, [&]() { return not isEmpty(); }, NOT_EMPTY);
         char request = buffer[static_cast<unsigned char>(getIndex)];
         --count;
         Logger::log("Consumed request " + std::to_string(request) + " from index " + std::to_string(getIndex) + ". Count: " + std::to_string(count));
         getIndex = (getIndex + 1) % MAX_QUEUE_SIZE;
-        cv.notify_one();
+        cv.notify_one(NOT_FULL);
         return request;
     }
 
@@ -9,6 +9,10 @@
 
 #define MAX_QUEUE_SIZE 5
 
+/** Producers and consumers wait on the same CV - the classes let a notification wake up the right one of them **/
+static constexpr WaitClass NOT_FULL = 1;
+static constexpr WaitClass NOT_EMPTY = 2;
+
 /**
  * In this example I present a Producer-Consumer problem using one CV with unlocking the mutex before notifying on CV.
  * It could be considered a form of optimization as in most CV implementations notifying on CV that have mutex already
@@ -42,23 +46,23 @@ public:
     void produce(T request) {
         {
             auto sync = synchronized();
-            cv.wait(mutex, [&]() { return not isFull(); });
+            cv.wait(mutex, [&]() { return not isFull(); }, NOT_FULL);
             queue.push(request);
             Logger::log("Produced " + std::to_string(request) + ". Queue size: " + std::to_string(queue.size()));
         }
-        cv.notify_one();
+        cv.notify_one(NOT_EMPTY);
     }
 
     T consume() {
         T request;
         {
             auto sync = synchronized();
-            cv.wait(mutex, [&]() { return not isEmpty(); });
+            cv.wait(mutex, [&]() { return not isEmpty(); }, NOT_EMPTY);
             request = queue.front();
             queue.pop();
             Logger::log("Consumed " + std::to_string(request) + ". Queue size: " + std::to_string(queue.size()));
         }
-        cv.notify_one();
+        cv.notify_one(NOT_FULL);
         return request;
     }
 
@@ -7,6 +7,7 @@ std::mutex Logger::mutex;
 std::map<std::thread::id, std::pair<std::string, rang::fg>> Logger::threads;
 unsigned Logger::logMessageCounter = 0;
 std::shared_ptr<ICommunicator> Logger::communicator;
+std::atomic<bool> Logger::enabled = true;
 rang::style backgroundColor = rang::style::reset;
 
 void Logger::init(std::shared_ptr<ICommunicator> communicator) {
@@ -18,7 +19,14 @@ void Logger::registerThread(std::string threadFriendlyName, rang::fg consoleColo
     threads[std::this_thread::get_id()] = {std::move(threadFriendlyName), consoleColor};
 }
 
+void Logger::setEnabled(bool enabled) {
+    Logger::enabled = enabled;
+}
+
 void Logger::log(const std::string& message, rang::fg color, rang::style style) {
+    if (not isEnabled()) {
+        return;
+    }
     std::lock_guard<std::mutex> guard(mutex);
     auto [threadId, threadColor] = threads[std::this_thread::get_id()];
     ProcessId myProcessId = communicator->getProcessId();
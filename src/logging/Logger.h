@@ -2,6 +2,7 @@
 #define DISTRIBUTEDMONITOR_LOGGER_H
 
 #include <communication/ICommunicator.h>
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -14,6 +15,12 @@ public:
     static void log(const std::string& message, rang::fg color = rang::fg::reset, rang::style style = rang::style::reset);
     static void registerThread(std::string threadFriendlyName, rang::fg consoleColor = rang::fg::reset);
 
+    /** Logging is enabled by default. Check isEnabled() before building an expensive message on a hot path. **/
+    static void setEnabled(bool enabled);
+    static bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
 private:
     static std::string getFormattedNumber(unsigned long number);
     static std::string getCurrentTime();
@@ -22,6 +29,7 @@ private:
     static std::map<std::thread::id, std::pair<std::string, rang::fg>> threads;
     static unsigned logMessageCounter;
     static std::shared_ptr<ICommunicator> communicator;
+    static std::atomic<bool> enabled;
 };
 
 
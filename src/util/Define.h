@@ -1,8 +1,11 @@
 #ifndef DISTRIBUTEDMONITOR_DEFINE_H
 #define DISTRIBUTEDMONITOR_DEFINE_H
 
-#include <map>
+#include <array>
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <string_view>
 #include "Utils.h"
 
 #define LOGGER_NUMBER_DIGITS 7
@@ -13,25 +16,44 @@ using LamportTime = unsigned long;
 using MutexName = std::string;
 using CondName = std::string;
 using Predicate = std::function<bool ()>;
+/** What a waiting process waits for (e.g. "not full" or "not empty"), so that a notification can target it **/
+using WaitClass = std::uint32_t;
+/** Waits of this class are woken up by notifications of any class, notifications of this class wake any wait **/
+inline constexpr WaitClass ANY_WAIT_CLASS = 0;
+/** Point in time at which a timed acquisition or wait gives up **/
+using Deadline = std::chrono::steady_clock::time_point;
 
 enum class MessageType : unsigned char {
-    MUTEX_REQUEST, MUTEX_AGREEMENT, COND_WAIT, COND_WAIT_END, COND_WAIT_END_CONFIRM, COND_NOTIFY, SYNC
+    MUTEX_REQUEST, MUTEX_AGREEMENT, COND_WAIT, COND_WAIT_END, COND_WAIT_END_CONFIRM, COND_NOTIFY, SYNC,
+    TOKEN_REQUEST, TOKEN, MODE_SWITCH, MODE_SWITCH_CONFIRM,
+    LOCAL_MUTEX_REQUEST, LOCAL_MUTEX_GRANT, LOCAL_MUTEX_RELEASE, MUTEX_FENCE, COND_NOTIFY_ONE, COND_NOTIFY_ALL,
+    MUTEX_CANCEL, MUTEX_RENEWAL, COND_WAKE, COND_WAIT_CANCEL, SHUTDOWN
 };
 
-static std::map<MessageType, std::string>  messageTypeString = {{MessageType::MUTEX_REQUEST, "MUTEX_REQUEST"},
-                                                                {MessageType::MUTEX_AGREEMENT, "MUTEX_AGREEMENT"},
-                                                                {MessageType::COND_WAIT, "COND_WAIT"},
-                                                                {MessageType::COND_WAIT_END, "COND_WAIT_END"},
-                                                                {MessageType::COND_WAIT_END_CONFIRM, "COND_WAIT_END_CONFIRM"},
-                                                                {MessageType::COND_NOTIFY, "COND_NOTIFY"},
-                                                                {MessageType::SYNC, "SYNC"}};
+/** Indexed by MessageType, in the order of declaration **/
+inline constexpr std::array<std::string_view, 22> messageTypeString = {"MUTEX_REQUEST", "MUTEX_AGREEMENT", "COND_WAIT",
+                                                                       "COND_WAIT_END", "COND_WAIT_END_CONFIRM",
+                                                                       "COND_NOTIFY", "SYNC", "TOKEN_REQUEST", "TOKEN",
+                                                                       "MODE_SWITCH", "MODE_SWITCH_CONFIRM",
+                                                                       "LOCAL_MUTEX_REQUEST", "LOCAL_MUTEX_GRANT",
+                                                                       "LOCAL_MUTEX_RELEASE", "MUTEX_FENCE",
+                                                                       "COND_NOTIFY_ONE", "COND_NOTIFY_ALL", "MUTEX_CANCEL",
+                                                                       "MUTEX_RENEWAL", "COND_WAKE",
+                                                                       "COND_WAIT_CANCEL", "SHUTDOWN"};
+
+static_assert(messageTypeString.size() == static_cast<std::size_t>(MessageType::SHUTDOWN) + 1,
+              "Every message type needs its name");
+
+constexpr std::string_view toString(MessageType messageType) {
+    return messageTypeString[static_cast<std::size_t>(messageType)];
+}
 
 inline std::ostream& operator<< (std::ostream& os, MessageType messageType) {
-    return os << messageTypeString[messageType];
+    return os << toString(messageType);
 }
 
 inline std::string& operator+ (std::string& str, MessageType messageType) {
-    return str.append(messageTypeString[messageType]);
+    return str.append(toString(messageType));
 }
 
 namespace std {
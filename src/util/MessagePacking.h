@@ -0,0 +1,95 @@
+#ifndef DISTRIBUTEDMONITOR_MESSAGEPACKING_H
+#define DISTRIBUTEDMONITOR_MESSAGEPACKING_H
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "Define.h"
+
+/**
+ * Messages carrying additional data for a named object (mutex, monitor, ...) are packed as:
+ * [name length - 1 byte][name][data]
+ */
+inline std::string packNamedMessage(std::string_view name, std::string_view data) {
+    assert(name.length() <= static_cast<unsigned char>(-1));
+    std::string message;
+    message.reserve(1 + name.length() + data.length());
+    message += static_cast<char>(name.length());
+    message.append(name);
+    message.append(data);
+    return message;
+}
+
+inline std::string_view extractName(std::string_view message) {
+    return message.substr(1, static_cast<unsigned char>(message[0]));
+}
+
+inline std::string_view extractData(std::string_view message) {
+    return message.substr(1 + static_cast<std::size_t>(static_cast<unsigned char>(message[0])));
+}
+
+/**
+ * Mutex and CV control messages carry nothing but the name, other messages are packed with packNamedMessage - among
+ * them COND_WAIT and COND_NOTIFY_ONE, carrying the wait class, COND_WAKE, carrying the waits it wakes up,
+ * COND_WAIT_CANCEL, carrying the time of the wait, and MUTEX_RENEWAL, carrying the request timestamp
+ */
+inline bool isNamedMessage(MessageType messageType) {
+    switch (messageType) {
+        case MessageType::MUTEX_REQUEST:
+        case MessageType::MUTEX_AGREEMENT:
+        case MessageType::MUTEX_CANCEL:
+        case MessageType::COND_WAIT_END:
+        case MessageType::COND_WAIT_END_CONFIRM:
+        case MessageType::COND_NOTIFY:
+        case MessageType::COND_NOTIFY_ALL:
+            return false;
+        default:
+            return true;
+    }
+}
+
+/** Name of the object (mutex, CV, monitor) a message concerns **/
+inline std::string_view extractObjectName(MessageType messageType, std::string_view message) {
+    return isNamedMessage(messageType) ? extractName(message) : message;
+}
+
+/** Numbers are appended to the data in the host byte order - all processes are assumed to share the architecture **/
+inline void appendNumber(std::string& data, std::uint64_t number) {
+    data.append(reinterpret_cast<const char*>(&number), sizeof(number));
+}
+
+inline std::uint64_t readNumber(std::string_view data, std::size_t index) {
+    std::uint64_t number;
+    std::memcpy(&number, data.data() + index * sizeof(number), sizeof(number));
+    return number;
+}
+
+inline std::size_t countNumbers(std::string_view data) {
+    return data.length() / sizeof(std::uint64_t);
+}
+
+/** Variable length (LEB128) encoding - 7 bits per byte, the highest bit set if more bytes follow **/
+inline void appendVarint(std::string& data, std::uint64_t number) {
+    while (number >= 0x80) {
+        data += static_cast<char>((number & 0x7F) | 0x80);
+        number >>= 7;
+    }
+    data += static_cast<char>(number);
+}
+
+/** Reads the varint starting at 'offset' and moves the offset past it **/
+inline std::uint64_t readVarint(std::string_view data, std::size_t& offset) {
+    std::uint64_t number = 0;
+    for (unsigned shift = 0; offset < data.length(); shift += 7) {
+        auto byte = static_cast<unsigned char>(data[offset++]);
+        number |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if (not (byte & 0x80)) {
+            break;
+        }
+    }
+    return number;
+}
+
+#endif //DISTRIBUTEDMONITOR_MESSAGEPACKING_H
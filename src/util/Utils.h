@@ -4,6 +4,7 @@
 #include <string>
 #include <array>
 #include <memory>
+#include <stdexcept>
 
 inline void hashCombine(std::size_t& seed) { }
 